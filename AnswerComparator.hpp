@@ -0,0 +1,123 @@
+/**
+ * \file    	AnswerComparator.hpp
+ * \author  	XY0797
+ * \brief		流式答案比较器，按记号比较目标程序的输出与标准答案
+ */
+#ifndef _XY0797_ANSWERCOMPARATOR
+#define _XY0797_ANSWERCOMPARATOR 1
+
+#include <string>
+
+// 流式答案比较器，在输出到达时逐段比较，不需要等待程序结束
+// 按空白字符分隔的记号比较，忽略空白字符的种类和数量(包括行末的\r和末尾的空行)
+class AnswerComparator {
+private:
+	// 标准答案
+	std::string m_expected;
+	size_t m_expectedPos = 0;
+
+	// 已比较的输出字节数，输出是否正处于一个记号中间
+	size_t m_outputPos = 0;
+	bool m_isInToken = false;
+
+	// 是否已经发现不一致，以及不一致处在输出中的字节位置
+	bool m_isMismatched = false;
+	size_t m_mismatchOffset = 0;
+
+	static bool IsBlank(char ch) {
+		return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\v' || ch == '\f';
+	}
+
+	// 标准答案当前位置是否为记号的结尾
+	bool IsExpectedTokenEnd() const {
+		return m_expectedPos == m_expected.size() || IsBlank(m_expected[m_expectedPos]);
+	}
+
+	void SetMismatch(size_t offset) {
+		m_isMismatched = true;
+		m_mismatchOffset = offset;
+	}
+
+public:
+	// 设置标准答案并重置比较状态
+	void Reset(const std::string& expected) {
+		m_expected = expected;
+		Restart();
+	}
+
+	// 保留标准答案，重置比较状态
+	void Restart() {
+		m_expectedPos = 0;
+		m_outputPos = 0;
+		m_isInToken = false;
+		m_isMismatched = false;
+		m_mismatchOffset = 0;
+	}
+
+	/*
+	 *  比较一段输出，输出可以在任意位置分段
+	 *  返回目前为止是否一致，发现不一致后不再比较
+	 */
+	bool Feed(const char* data, size_t len) {
+		for (size_t i = 0; i < len && !m_isMismatched; ++i, ++m_outputPos) {
+			char ch = data[i];
+			if (IsBlank(ch)) {
+				// 输出的记号结束，标准答案的记号也必须结束
+				if (m_isInToken && !IsExpectedTokenEnd()) {
+					SetMismatch(m_outputPos);
+				}
+				m_isInToken = false;
+				continue;
+			}
+			if (!m_isInToken) {
+				// 输出开始新的记号，跳过标准答案中的空白
+				while (m_expectedPos < m_expected.size() && IsBlank(m_expected[m_expectedPos])) {
+					++m_expectedPos;
+				}
+				m_isInToken = true;
+			}
+			if (m_expectedPos == m_expected.size() || m_expected[m_expectedPos] != ch) {
+				SetMismatch(m_outputPos);
+			} else {
+				++m_expectedPos;
+			}
+		}
+		return !m_isMismatched;
+	}
+
+	// 输出结束，检查标准答案是否也已结束，返回全部输出是否一致
+	bool Finish() {
+		if (m_isMismatched) {
+			return false;
+		}
+		if (m_isInToken && !IsExpectedTokenEnd()) {
+			SetMismatch(m_outputPos);
+			return false;
+		}
+		m_isInToken = false;
+		while (m_expectedPos < m_expected.size() && IsBlank(m_expected[m_expectedPos])) {
+			++m_expectedPos;
+		}
+		if (m_expectedPos != m_expected.size()) {
+			SetMismatch(m_outputPos);
+		}
+		return !m_isMismatched;
+	}
+
+	// 返回标准答案
+	const std::string& getExpected() const {
+		return m_expected;
+	}
+
+	// 返回是否已经发现不一致
+	bool isMismatched() const {
+		return m_isMismatched;
+	}
+
+	// 返回第一个不一致处在输出中的字节位置，输出过短时为输出的长度
+	size_t getMismatchOffset() const {
+		return m_mismatchOffset;
+	}
+};
+
+#endif /* _XY0797_ANSWERCOMPARATOR */
@@ -0,0 +1,315 @@
+/**
+ * \file    	CompileCache.hpp
+ * \author  	XY0797
+ * \brief		按内容寻址的编译缓存，相同的源码、编译器和编译选项只编译一次
+ */
+#ifndef _XY0797_COMPILECACHE
+#define _XY0797_COMPILECACHE 1
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "ConsoleOJ.hpp"
+#include "Sha256.hpp"
+
+// 编译缓存的统计信息
+struct CompileCacheStats {
+	// 命中缓存的次数、实际编译的次数、编译失败的次数
+	unsigned long long hits = 0;
+	unsigned long long misses = 0;
+	unsigned long long compileErrors = 0;
+	// 因超过容量被删除的可执行文件数
+	unsigned long long evictions = 0;
+};
+
+/*
+ *  按内容寻址的编译缓存，线程安全，多个进程可以共用同一个缓存目录
+ *  以(源码内容, 编译器, 编译选项)的SHA-256为键，可执行文件以键命名保存在缓存目录中
+ *  编译先输出到临时文件，完成后原子地重命名为键，其他线程和进程不会看到不完整的文件
+ *  同一进程内相同的键同时只编译一次，其余调用等待编译完成后直接命中
+ *  缓存总大小超过容量时按最近使用时间(文件的修改时间)删除最久未使用的可执行文件
+ */
+class CompileCache {
+private:
+	// 缓存目录、容量(字节)和编译的时间限制(毫秒，按真实时间计算)
+	std::filesystem::path m_cacheDirectory;
+	unsigned long long m_maxCacheBytes;
+	long long m_compileTimeLimit;
+
+	// 正在编译的键、统计信息和临时文件编号
+	std::mutex m_cacheMutex;
+	std::condition_variable m_compileCond;
+	std::set<std::string> m_compilingKeys;
+	CompileCacheStats m_stats;
+	unsigned long long m_tempCounter = 0;
+
+#ifdef _WIN32
+	static constexpr const char* m_executableSuffix = ".exe";
+#else
+	static constexpr const char* m_executableSuffix = "";
+#endif
+
+	// 最近使用过的可执行文件在这段时间内不会被删除，避免删除刚交给评测的程序
+	static constexpr std::chrono::seconds m_evictionGracePeriod{ 60 };
+
+	static unsigned long GetPid() {
+#ifdef _WIN32
+		return GetCurrentProcessId();
+#else
+		return static_cast<unsigned long>(getpid());
+#endif
+	}
+
+	// 把文本中所有的占位符替换为指定的值
+	static std::string ReplacePlaceholder(std::string text, const std::string& placeholder,
+	                                      const std::string& value) {
+		size_t pos = 0;
+		while ((pos = text.find(placeholder, pos)) != std::string::npos) {
+			text.replace(pos, placeholder.size(), value);
+			pos += value.size();
+		}
+		return text;
+	}
+
+	// 生成编译器的命令行参数，编译选项中没有占位符时在末尾追加：源文件 -o 输出文件
+	static std::vector<std::string> BuildArguments(const std::vector<std::string>& flags,
+	                                               const std::string& sourcePath,
+	                                               const std::string& outputPath) {
+		std::vector<std::string> arguments;
+		bool hasPlaceholder = false;
+		for (const std::string& flag : flags) {
+			if (flag.find("{source}") != std::string::npos || flag.find("{output}") != std::string::npos) {
+				hasPlaceholder = true;
+			}
+			arguments.push_back(ReplacePlaceholder(ReplacePlaceholder(flag, "{source}", sourcePath),
+			                                       "{output}", outputPath));
+		}
+		if (!hasPlaceholder) {
+			arguments.push_back(sourcePath);
+			arguments.push_back("-o");
+			arguments.push_back(outputPath);
+		}
+		return arguments;
+	}
+
+	// 运行编译器，返回是否编译成功，编译器的标准输出和标准错误写入编译信息
+	bool RunCompiler(const std::string& compilerPath, const std::vector<std::string>& arguments,
+	                 const std::filesystem::path& outputPath, std::string& compileMessage) {
+		ConsoleOJ oj(compilerPath);
+		oj.setArguments(arguments);
+		// 编译器会创建子进程(如cc1plus、as、ld)，按真实时间限制
+		oj.setCPUTimePolicy(CPUTimePolicy::WallClockTime, true);
+		long long timeCosted;
+		std::string errstr;
+		if (!oj.launchAndWait("", m_compileTimeLimit, compileMessage, timeCosted, errstr)) {
+			compileMessage += (compileMessage.empty() ? "" : "\n") + errstr;
+			return false;
+		}
+		std::error_code errorCode;
+		if (!std::filesystem::exists(outputPath, errorCode)) {
+			compileMessage += (compileMessage.empty() ? "" : "\n") + std::string("编译器没有生成可执行文件！");
+			return false;
+		}
+		return true;
+	}
+
+	/*
+	 *  删除最久未使用的可执行文件，直到缓存总大小不超过容量
+	 *  保留路径[in]：刚生成的可执行文件，不会被删除
+	 *  同时清理异常退出的编译留下的临时文件
+	 */
+	void Evict(const std::filesystem::path& keepPath) {
+		struct CacheEntry {
+			std::filesystem::path path;
+			std::filesystem::file_time_type lastUsed;
+			unsigned long long size;
+		};
+		std::vector<CacheEntry> entries;
+		unsigned long long totalBytes = 0;
+		std::error_code errorCode;
+		auto now = std::filesystem::file_time_type::clock::now();
+		auto tempExpireTime = std::chrono::milliseconds(m_compileTimeLimit) + m_evictionGracePeriod;
+		for (std::filesystem::directory_iterator entry(m_cacheDirectory, errorCode), end;
+		     !errorCode && entry != end; entry.increment(errorCode)) {
+			if (!entry->is_regular_file(errorCode)) {
+				continue;
+			}
+			CacheEntry cacheEntry;
+			cacheEntry.path = entry->path();
+			cacheEntry.lastUsed = entry->last_write_time(errorCode);
+			cacheEntry.size = entry->file_size(errorCode);
+			if (errorCode) {
+				// 文件可能刚被其他进程删除
+				errorCode.clear();
+				continue;
+			}
+			if (cacheEntry.path.filename().string().compare(0, 4, "tmp-") == 0) {
+				if (now - cacheEntry.lastUsed > tempExpireTime) {
+					std::filesystem::remove(cacheEntry.path, errorCode);
+					errorCode.clear();
+				}
+				continue;
+			}
+			totalBytes += cacheEntry.size;
+			entries.push_back(std::move(cacheEntry));
+		}
+		if (totalBytes <= m_maxCacheBytes) {
+			return;
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const CacheEntry& a, const CacheEntry& b) {
+			return a.lastUsed < b.lastUsed;
+		});
+		unsigned long long evictions = 0;
+		for (const CacheEntry& cacheEntry : entries) {
+			if (totalBytes <= m_maxCacheBytes) {
+				break;
+			}
+			if (cacheEntry.path == keepPath || now - cacheEntry.lastUsed < m_evictionGracePeriod) {
+				continue;
+			}
+			// 删除失败(如Windows下程序正在运行)时跳过
+			if (std::filesystem::remove(cacheEntry.path, errorCode)) {
+				totalBytes -= cacheEntry.size;
+				++evictions;
+			}
+			errorCode.clear();
+		}
+		m_cacheMutex.lock();
+		m_stats.evictions += evictions;
+		m_cacheMutex.unlock();
+	}
+
+public:
+	/*
+	 *  构造时传入：[缓存目录] [缓存容量] [编译的时间限制]
+	 *  缓存目录不存在时自动创建
+	 *  缓存容量[in]：单位字节，超过时删除最久未使用的可执行文件
+	 *  编译的时间限制[in]：单位毫秒，按真实时间计算
+	 */
+	explicit CompileCache(const std::string& cacheDirectory,
+	                      unsigned long long maxCacheBytes = 1ULL << 30, long long compileTimeLimit = 30000)
+		: m_maxCacheBytes(maxCacheBytes), m_compileTimeLimit(compileTimeLimit) {
+		std::error_code errorCode;
+		std::filesystem::create_directories(cacheDirectory, errorCode);
+		m_cacheDirectory = std::filesystem::absolute(cacheDirectory, errorCode);
+	}
+
+	CompileCache(const CompileCache&) = delete;
+	CompileCache& operator=(const CompileCache&) = delete;
+
+	/*
+	 *  计算缓存的键，源文件无法读取时返回空串
+	 *  键包含编译器路径、编译器文件的大小和修改时间(升级编译器后自动失效)、全部编译选项和源码内容
+	 */
+	std::string getKey(const std::string& sourcePath, const std::string& compilerPath,
+	                   const std::vector<std::string>& flags) const {
+		Sha256 sha;
+		sha.UpdateField("CompileCache 1");
+		sha.UpdateField(compilerPath);
+		std::error_code errorCode;
+		unsigned long long compilerSize = std::filesystem::file_size(compilerPath, errorCode);
+		sha.UpdateField(errorCode ? "" : std::to_string(compilerSize));
+		auto compilerTime = std::filesystem::last_write_time(compilerPath, errorCode);
+		sha.UpdateField(errorCode ? "" : std::to_string(compilerTime.time_since_epoch().count()));
+		sha.UpdateField(std::to_string(flags.size()));
+		for (const std::string& flag : flags) {
+			sha.UpdateField(flag);
+		}
+		// 源码是最后一个字段，不需要长度前缀
+		if (!sha.UpdateFile(sourcePath)) {
+			return "";
+		}
+		return sha.FinalHex();
+	}
+
+	/*
+	 *  编译源文件，命中缓存时不再编译，返回是否得到可执行文件
+	 *  源文件路径[in]：源码文件
+	 *  编译器路径[in]：编译器可执行文件的完整路径，如/usr/bin/g++
+	 *  编译选项[in]：编译器的参数，可用{source}和{output}表示源文件和输出文件的绝对路径
+	 *               不含占位符时在末尾追加：源文件 -o 输出文件
+	 *               编译器的工作目录为编译器所在目录，选项中的其他路径应使用绝对路径
+	 *  可执行文件路径[out]：返回缓存中可执行文件的路径，失败时为空
+	 *  编译信息[out]：返回编译器的输出和失败原因，命中缓存时为空，编译失败的结果不缓存
+	 */
+	bool Compile(const std::string& sourcePath, const std::string& compilerPath,
+	             const std::vector<std::string>& flags, std::string& binaryPath, std::string& compileMessage) {
+		binaryPath.clear();
+		compileMessage.clear();
+		std::string key = getKey(sourcePath, compilerPath, flags);
+		if (key.empty()) {
+			compileMessage = "无法读取源文件！";
+			return false;
+		}
+		std::filesystem::path cachedPath = m_cacheDirectory / (key + m_executableSuffix);
+		std::error_code errorCode;
+
+		// 等待本进程内相同键的编译完成
+		std::unique_lock<std::mutex> lock(m_cacheMutex);
+		m_compileCond.wait(lock, [&] {
+			return m_compilingKeys.count(key) == 0;
+		});
+		if (std::filesystem::exists(cachedPath, errorCode)) {
+			++m_stats.hits;
+			lock.unlock();
+			// 更新最近使用时间
+			std::filesystem::last_write_time(cachedPath, std::filesystem::file_time_type::clock::now(), errorCode);
+			binaryPath = cachedPath.string();
+			return true;
+		}
+		++m_stats.misses;
+		m_compilingKeys.insert(key);
+		std::filesystem::path tempPath = m_cacheDirectory / ("tmp-" + std::to_string(GetPid()) + "-" +
+		                                 std::to_string(m_tempCounter++) + m_executableSuffix);
+		lock.unlock();
+
+		// 在锁外编译到临时文件，然后原子地重命名
+		// 其他进程同时编译了相同的键时，重命名覆盖的是内容相同的文件
+		std::filesystem::path absoluteSourcePath = std::filesystem::absolute(sourcePath, errorCode);
+		bool isSucceeded = RunCompiler(compilerPath,
+		                               BuildArguments(flags, absoluteSourcePath.string(), tempPath.string()),
+		                               tempPath, compileMessage);
+		if (isSucceeded) {
+			std::filesystem::rename(tempPath, cachedPath, errorCode);
+			if (errorCode && !std::filesystem::exists(cachedPath, errorCode)) {
+				compileMessage += (compileMessage.empty() ? "" : "\n") + std::string("无法写入编译缓存！");
+				isSucceeded = false;
+			}
+		}
+		std::filesystem::remove(tempPath, errorCode);
+
+		lock.lock();
+		m_compilingKeys.erase(key);
+		if (!isSucceeded) {
+			++m_stats.compileErrors;
+		}
+		lock.unlock();
+		m_compileCond.notify_all();
+
+		if (!isSucceeded) {
+			return false;
+		}
+		Evict(cachedPath);
+		binaryPath = cachedPath.string();
+		return true;
+	}
+
+	// 返回统计信息
+	CompileCacheStats getStats() {
+		m_cacheMutex.lock();
+		CompileCacheStats stats = m_stats;
+		m_cacheMutex.unlock();
+		return stats;
+	}
+
+	// 返回缓存目录的绝对路径
+	std::string getCacheDirectory() const {
+		return m_cacheDirectory.string();
+	}
+};
+
+#endif /* _XY0797_COMPILECACHE */
@@ -12,6 +12,136 @@
 #include <thread>
 #include <chrono>
 #include <string>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "OutputChunkPool.hpp"
+#include "AnswerComparator.hpp"
+#include "VerdictCache.hpp"
+
+// 评测结果
+enum class JudgeVerdict {
+	// 尚未评测
+	None,
+	// 程序在时限内正常结束，设置了标准答案时输出也一致
+	Accepted,
+	// 输出与标准答案不一致
+	WrongAnswer,
+	// 输出格式错误，由检查器判定
+	PresentationError,
+	// 部分正确，由检查器判定，得分见检查器信息
+	PartiallyCorrect,
+	// 输出超出限制
+	OutputLimitExceeded,
+	// 内存超出限制
+	MemoryLimitExceeded,
+	// 超出时间限制
+	TimeLimitExceeded,
+	// 程序长时间空闲(如等待输入、死锁)，超出空闲时间限制
+	IdlenessLimitExceeded,
+	// 返回值不为0或异常终止
+	RuntimeError,
+	// 评测机自身的错误，如创建进程失败、类正在析构
+	SystemError
+};
+
+// 返回评测结果的英文简写，如"AC"、"WA"，用于机器可读的报告
+inline const char* judgeVerdictName(JudgeVerdict verdict) {
+	switch (verdict) {
+		case JudgeVerdict::Accepted:
+			return "AC";
+		case JudgeVerdict::WrongAnswer:
+			return "WA";
+		case JudgeVerdict::PresentationError:
+			return "PE";
+		case JudgeVerdict::PartiallyCorrect:
+			return "PC";
+		case JudgeVerdict::OutputLimitExceeded:
+			return "OLE";
+		case JudgeVerdict::MemoryLimitExceeded:
+			return "MLE";
+		case JudgeVerdict::TimeLimitExceeded:
+			return "TLE";
+		case JudgeVerdict::IdlenessLimitExceeded:
+			return "ILE";
+		case JudgeVerdict::RuntimeError:
+			return "RE";
+		case JudgeVerdict::SystemError:
+			return "SE";
+		default:
+			return "None";
+	}
+}
+
+// 时间花费的计算方式
+enum class CPUTimePolicy {
+	// 所有线程的CPU时间之和，多线程并行不能减少时间花费
+	TotalCPUTime,
+	// 真实时间，多线程并行可以减少时间花费
+	WallClockTime,
+	// 性能计数器统计的任务时钟(task-clock)，纳秒精度，不依赖时钟中断采样，仅Linux
+	TaskClock,
+	// 性能计数器统计的用户态指令数，按每毫秒的指令数换算，不受机器负载和频率影响，仅Linux
+	Instructions
+};
+
+/*
+ *  计算距下一次判断空闲的毫秒数
+ *  检查时只知道两次检查之间是否有活动，每隔空闲时间限制的1/4检查一次，使得判断空闲的延迟不超过限制的1/4
+ *  最后一次发现活动之后空闲时间限制内没有任何活动即为空闲
+ */
+inline long long nextIdleCheck(long long idlelimit, long long lastActiveTime, long long elapsed) {
+	long long wait = lastActiveTime + idlelimit - elapsed;
+	long long sampleWait = idlelimit / 4;
+	if (wait > sampleWait) {
+		wait = sampleWait;
+	}
+	return (wait < 1) ? 1 : wait;
+}
+
+/*
+ *  计算距下一次检查时间限制的毫秒数
+ *  CPU时间的增长速度不超过真实时间乘以线程数，所以在此之前不可能超时
+ *  真实时间达到时间限制之前至少检查一次，之后每100ms检查一次，用于判断程序是否被阻塞
+ */
+inline long long nextTimeLimitCheck(long long timelimit, long long cpuTime, long long elapsed,
+                                    long long threadCount) {
+	if (threadCount < 1) {
+		threadCount = 1;
+	}
+	long long wait = (timelimit - cpuTime) / threadCount;
+	long long blockCheckWait = (elapsed < timelimit) ? (timelimit - elapsed) : 100;
+	if (wait > blockCheckWait) {
+		wait = blockCheckWait;
+	}
+	return (wait < 1) ? 1 : wait;
+}
+
+/*
+ *  把检查器(special judge)的退出代码转换为评测结果，与testlib的约定相同
+ *  0为正确，1、4(dirt)、8(unexpected eof)为答案错误，2为格式错误，7为部分得分
+ *  3为检查器自身失败，其他退出代码也视为检查器失败
+ */
+inline JudgeVerdict checkerExitCodeToVerdict(int exitCode) {
+	switch (exitCode) {
+		case 0:
+			return JudgeVerdict::Accepted;
+		case 1:
+		case 4:
+		case 8:
+			return JudgeVerdict::WrongAnswer;
+		case 2:
+			return JudgeVerdict::PresentationError;
+		case 7:
+			return JudgeVerdict::PartiallyCorrect;
+		default:
+			return JudgeVerdict::SystemError;
+	}
+}
+
+#ifdef _WIN32
+
 #include <windows.h>
 
 // 安全关闭句柄
@@ -30,12 +160,58 @@ long long fileTime2ms(const FILETIME& fileTime) {
 	return (Uint.QuadPart / 10000ull);
 }
 
+#else /* POSIX */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "ConsoleOJZygote.hpp"
+
+// 安全关闭文件描述符
+inline void Clfd_s(int& fd) {
+	if (fd != -1) {
+		close(fd);
+		fd = -1;
+	}
+}
+
+// timeval转毫秒
+inline long long timeval2ms(const timeval& tv) {
+	return tv.tv_sec * 1000ll + tv.tv_usec / 1000;
+}
+
+// timespec转毫秒
+inline long long timespec2ms(const timespec& ts) {
+	return ts.tv_sec * 1000ll + ts.tv_nsec / 1000000;
+}
+
+#endif /* _WIN32 */
+
 class ConsoleOJ {
 private:
 	// 可执行文件路径、工作目录、命令行参数
 	std::string m_programPath;
 	std::string m_workingDirectory;
+	std::vector<std::string> m_arguments;
 
+#ifdef _WIN32
 	// 进程信息读写锁，多线程访问时的线程安全
 	std::shared_mutex m_rwProcMutex;
 
@@ -45,16 +221,51 @@ private:
 	// 写入数据的句柄
 	HANDLE m_inputPipeWrite = INVALID_HANDLE_VALUE;
 
+	// 析构事件同步对象
+	HANDLE m_hExitEvent = INVALID_HANDLE_VALUE;
+
+	// 输出管道缓冲区大小
+	static const DWORD m_outputPipeSize = 1 << 16;
+
+	// 监视线程结束事件和监视线程句柄
+	HANDLE m_hReadDoneEvent = INVALID_HANDLE_VALUE;
+	HANDLE m_hReadThread = INVALID_HANDLE_VALUE;
+
+	// 目标程序的进程句柄，由launchAndWait持有，监视线程发现输出不一致时用于结束进程
+	HANDLE m_hProcess = INVALID_HANDLE_VALUE;
+#else
+	// 读取输出的文件描述符
+	int m_outputPipeRead = -1;
+
+	// 写入数据的文件描述符
+	int m_inputPipeWrite = -1;
+
+	// 析构事件同步对象
+	int m_exitEventFd = -1;
+
+	// 通知监视线程取出剩余输出后退出
+	int m_stopReadEventFd = -1;
+
+	// 目标程序的进程组，监视线程发现输出不一致时用于结束进程
+	pid_t m_processGroup = -1;
+
+	// 预先创建子进程的zygote，为空表示每次自行fork
+	ConsoleOJZygote* m_zygote = nullptr;
+
+	// 父cgroup目录，每次评测在其下创建一个cgroup，需要启用memory控制器并有写权限
+	std::string m_cgroupRoot = "/sys/fs/cgroup/ConsoleOJ";
+#endif
+
 	// 写入数据，保证输入期间不被析构
 	const char* m_inputCStr = nullptr;
-	DWORD m_inputCStrLen = 0;
+	size_t m_inputCStrLen = 0;
+
+	// 输入文件路径，不为空时目标程序的标准输入直接重定向到该文件
+	std::string m_inputFilePath;
 
 	// 是否已经启动
 	bool isLaunched = false;
 
-	// 析构事件同步对象
-	HANDLE m_hExitEvent = INVALID_HANDLE_VALUE;
-
 	// 将要析构标志位
 	bool m_willExit = false;
 
@@ -64,320 +275,3088 @@ private:
 	// 写输入文本线程对象
 	std::thread m_WriteStrThread;
 
-	// 输出文本内容
-	std::string m_output;
+	// 输出文本内容，按块存放，评测结束时拼接一次；块写满后从内存池取新的块，只有最后一块未满
+	std::vector<char*> m_outputChunks;
+	size_t m_outputSize = 0;
+
+	// 输出块内存池，空闲列表保留的块可以容纳1MB的输出，不超过时稳定运行不再分配内存
+	OutputChunkPool m_chunkPool{ 1 << 16, 16 };
+
+	// 目标程序绑定的CPU编号，-1为不绑定
+	int m_cpuAffinity = -1;
+
+	// 标准答案比较器，是否设置了标准答案，标准答案来自文件时的文件路径
+	AnswerComparator m_comparator;
+	bool m_hasExpectedOutput = false;
+	std::string m_expectedOutputPath;
+
+	// 检查器路径和时间限制(单位毫秒)，路径为空表示不使用检查器；上一次评测的检查器信息
+	std::string m_checkerPath;
+	long long m_checkerTimeLimit = 10000;
+	std::string m_checkerMessage;
+
+	// 评测结果缓存，为空表示不使用缓存；上一次评测的结果是否来自缓存
+	VerdictCache* m_verdictCache = nullptr;
+	bool m_isVerdictCached = false;
+
+	// 上一次评测是否因评测机负载过大而中止
+	bool m_isOverloaded = false;
+
+	// 输出字节数限制，0为不限制
+	size_t m_outputLimit = 0;
 
-	// 监视线程
+	// 监视线程结束目标程序的原因(输出不一致或输出超限)，None为未结束
+	std::atomic<JudgeVerdict> m_readerVerdict{ JudgeVerdict::None };
+
+	// 上一次评测的结果和输出不一致的位置
+	JudgeVerdict m_verdict = JudgeVerdict::None;
+	size_t m_mismatchOffset = 0;
+
+	// 内存限制，0为不限制；上一次评测的内存峰值，单位字节
+	size_t m_memoryLimit = 0;
+	size_t m_peakMemory = 0;
+
+	// 上一次评测开始运行的时间、消耗的真实时间(单位毫秒)、目标程序的退出代码和结束信号
+	std::chrono::steady_clock::time_point m_startTime;
+	long long m_realTimeCosted = 0;
+	int m_exitCode = 0;
+	int m_exitSignal = 0;
+
+	// 时间花费的计算方式，CPU时间是否计入目标程序创建的子进程
+	CPUTimePolicy m_cpuTimePolicy = CPUTimePolicy::TotalCPUTime;
+	bool m_isChildProcessCounted = false;
+
+	// 空闲时间限制，单位毫秒，0为等于时间限制
+	long long m_idleLimit = 0;
+
+	// Instructions计时方式下每毫秒计入的指令数
+	unsigned long long m_instructionsPerMillisecond = 1000000;
+	// 计时方式不使用性能计数器时是否也统计；上一次评测的指令数和任务时钟(纳秒)，不可用时为0
+	bool m_isPerfCounterEnabled = false;
+	unsigned long long m_instructionCount = 0;
+	unsigned long long m_taskClockNanoseconds = 0;
+
+#ifdef _WIN32
+	// 监视线程，阻塞读取输出，数据一到就取走，直到管道关闭或读取被取消
+	static void CheckProcThread(ConsoleOJ* const classthis) {
+		classthis->ReleaseOutput();
+		DWORD bytesRead;
+		// 保存本线程的句柄，用于取消阻塞读取
+		classthis->m_rwProcMutex.lock();
+		DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(),
+		                &classthis->m_hReadThread, 0, FALSE, DUPLICATE_SAME_ACCESS);
+		classthis->m_rwProcMutex.unlock();
+		while (!classthis->m_willExit) {
+			// 所有写入端关闭后返回ERROR_BROKEN_PIPE，被取消时返回ERROR_OPERATION_ABORTED
+			size_t bufferLen;
+			char* outputBuffer = classthis->GetOutputBuffer(bufferLen);
+			if (!ReadFile(classthis->m_outputPipeRead, outputBuffer,
+			              static_cast<DWORD>(bufferLen), &bytesRead, NULL)) {
+				break;
+			}
+			classthis->AppendOutput(outputBuffer, bytesRead);
+		}
+		classthis->m_rwProcMutex.lock();
+		Clhandle_s(classthis->m_hReadThread);
+		classthis->m_rwProcMutex.unlock();
+		SetEvent(classthis->m_hReadDoneEvent);
+	}
+#else
+	// 监视线程，阻塞读取输出直到管道关闭或被通知停止
 	static void CheckProcThread(ConsoleOJ* const classthis) {
-		classthis->m_output = "";
-		bool onemoretime = true;
-		while (classthis->isLaunched || onemoretime) {
-			if (!classthis->isLaunched) {
-				onemoretime = false;
+		classthis->ReleaseOutput();
+		char* outputBuffer;
+		size_t bufferLen;
+		pollfd fds[2];
+		fds[0].fd = classthis->m_outputPipeRead;
+		fds[0].events = POLLIN;
+		fds[1].fd = classthis->m_stopReadEventFd;
+		fds[1].events = POLLIN;
+		while (1) {
+			if (poll(fds, 2, -1) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				break;
 			}
-			DWORD availableBytes;
-			DWORD bytesRead;
-			classthis->m_rwProcMutex.lock();
-			PeekNamedPipe(classthis->m_outputPipeRead, NULL, 0, NULL,
-			              &availableBytes, NULL);
-			if (availableBytes > 0) {
-				char* outputBuffer = new char[availableBytes + 1];
-				if (!ReadFile(classthis->m_outputPipeRead, outputBuffer,
-				              availableBytes, &bytesRead, NULL)) {
-					delete[] outputBuffer;
-					classthis->m_rwProcMutex.unlock();
-					return;
+			if (fds[1].revents & POLLIN) {
+				// 进程已结束，取出剩余输出后退出
+				fcntl(classthis->m_outputPipeRead, F_SETFL, O_NONBLOCK);
+				ssize_t bytesRead;
+				while ((outputBuffer = classthis->GetOutputBuffer(bufferLen)),
+				       (bytesRead = read(classthis->m_outputPipeRead, outputBuffer, bufferLen)) > 0) {
+					classthis->AppendOutput(outputBuffer, bytesRead);
 				}
-				outputBuffer[bytesRead] = '\0';
-				classthis->m_output += std::string(outputBuffer);
-				delete[] outputBuffer;
+				break;
 			}
-			classthis->m_rwProcMutex.unlock();
-			WaitForSingleObject(classthis->m_hExitEvent, 10);
-			if (classthis->m_willExit) {
-				return;
+			if (fds[0].revents & (POLLIN | POLLHUP)) {
+				outputBuffer = classthis->GetOutputBuffer(bufferLen);
+				ssize_t bytesRead = read(classthis->m_outputPipeRead, outputBuffer, bufferLen);
+				if (bytesRead <= 0) {
+					// 所有写入端都已关闭
+					break;
+				}
+				classthis->AppendOutput(outputBuffer, bytesRead);
 			}
 		}
 	}
+#endif
 
-	static void WriteStrThread(ConsoleOJ* const classthis) {
-		DWORD bytesWritten;
-		WriteFile(classthis->m_inputPipeWrite, classthis->m_inputCStr,
-		          classthis->m_inputCStrLen, &bytesWritten, NULL);
+	// 由监视线程结束目标程序(POSIX下为整个进程组)，只记录第一次的原因
+	void StopByReader(JudgeVerdict verdict) {
+		JudgeVerdict expected = JudgeVerdict::None;
+		if (!m_readerVerdict.compare_exchange_strong(expected, verdict)) {
+			return;
+		}
+#ifdef _WIN32
+		TerminateProcess(m_hProcess, 1);
+#else
+		if (m_processGroup > 0) {
+			kill(-m_processGroup, SIGKILL);
+		}
+#endif
+	}
+
+	// 返回可以直接读入输出的位置和长度，最后一块已满时从内存池取一块新的
+	char* GetOutputBuffer(size_t& len) {
+		size_t chunkSize = m_chunkPool.getChunkSize();
+		size_t used = m_outputSize - (m_outputChunks.empty() ? 0 : (m_outputChunks.size() - 1) * chunkSize);
+		if (m_outputChunks.empty() || used == chunkSize) {
+			m_outputChunks.push_back(m_chunkPool.Allocate());
+			used = 0;
+		}
+		len = chunkSize - used;
+		return m_outputChunks.back() + used;
 	}
 
-public:
 	/*
-	 *	构造时传入：exe文件路径
+	 *  确认读入GetOutputBuffer返回位置的输出并检查
+	 *  超出输出限制时只保留限制以内的部分，输出与标准答案不一致时结束目标程序
+	 *  目标程序被结束后丢弃剩余的输出，之后读入的数据会被覆盖
 	 */
-	explicit ConsoleOJ(const std::string& programPath) : m_programPath(programPath) {
-		// 处理工作目录
-		size_t found = programPath.find_last_of("/\\");
-		if (found != std::string::npos) {
-			this->m_workingDirectory = programPath.substr(0, found);
+	void AppendOutput(const char* data, size_t len) {
+		if (m_readerVerdict != JudgeVerdict::None) {
+			return;
+		}
+		if (m_outputLimit > 0 && m_outputSize + len > m_outputLimit) {
+			m_outputSize = m_outputLimit;
+			StopByReader(JudgeVerdict::OutputLimitExceeded);
+			return;
+		}
+		m_outputSize += len;
+		if (m_hasExpectedOutput && m_checkerPath.empty() && !m_comparator.Feed(data, len)) {
+			StopByReader(JudgeVerdict::WrongAnswer);
+		}
+	}
+
+	// 归还全部输出块，清空输出
+	void ReleaseOutput() {
+		for (char* chunk : m_outputChunks) {
+			m_chunkPool.Release(chunk);
+		}
+		m_outputChunks.clear();
+		m_outputSize = 0;
+	}
+
+	// 把输出拼接到字符串中并清空，字符串已有足够的容量时不分配内存
+	void TakeOutput(std::string& outputstr) {
+		size_t chunkSize = m_chunkPool.getChunkSize();
+		outputstr.clear();
+		outputstr.reserve(m_outputSize);
+		for (size_t i = 0; i < m_outputChunks.size(); ++i) {
+			size_t len = m_outputSize - i * chunkSize;
+			outputstr.append(m_outputChunks[i], (len < chunkSize) ? len : chunkSize);
+		}
+		ReleaseOutput();
+	}
+
+#ifdef _WIN32
+	// 获取作业中进程的内存峰值(已提交的内存)，单位字节
+	static size_t GetJobPeakMemory(HANDLE jobHandle) {
+		JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobLimit;
+		ZeroMemory(&jobLimit, sizeof(jobLimit));
+		if (jobHandle == INVALID_HANDLE_VALUE ||
+		    !QueryInformationJobObject(jobHandle, JobObjectExtendedLimitInformation,
+		                               &jobLimit, sizeof(jobLimit), NULL)) {
+			return 0;
+		}
+		return jobLimit.PeakProcessMemoryUsed;
+	}
+
+	// 获取目标程序所有线程的CPU时间，计入子进程时为作业中所有进程之和，单位毫秒
+	long long GetRunCPUTime(HANDLE processHandle, HANDLE jobHandle) {
+		if (m_isChildProcessCounted && jobHandle != INVALID_HANDLE_VALUE) {
+			JOBOBJECT_BASIC_ACCOUNTING_INFORMATION jobAccounting;
+			if (QueryInformationJobObject(jobHandle, JobObjectBasicAccountingInformation,
+			                              &jobAccounting, sizeof(jobAccounting), NULL)) {
+				return (jobAccounting.TotalUserTime.QuadPart +
+				        jobAccounting.TotalKernelTime.QuadPart) / 10000;
+			}
+		}
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		GetProcessTimes(processHandle, &creationTime, &exitTime, &kernelTime, &userTime);
+		return fileTime2ms(kernelTime) + fileTime2ms(userTime);
+	}
+
+	/*
+	 *  创建目标程序使用的作业对象，按时间计算方式和内存限制设置限制，作业关闭时结束其中所有进程
+	 *  同时创建接收作业通知的完成端口，返回作业对象，失败返回INVALID_HANDLE_VALUE
+	 */
+	HANDLE CreateRunJob(long long timelimit, HANDLE& jobPort) {
+		jobPort = INVALID_HANDLE_VALUE;
+		HANDLE jobHandle = CreateJobObject(NULL, NULL);
+		if (jobHandle == NULL) {
+			return INVALID_HANDLE_VALUE;
+		}
+		JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobLimit;
+		ZeroMemory(&jobLimit, sizeof(jobLimit));
+		jobLimit.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+		// 用户态CPU时间超过时间限制时由系统立即结束进程，不必等待下一次检查
+		if (m_cpuTimePolicy == CPUTimePolicy::TotalCPUTime && m_isChildProcessCounted) {
+			jobLimit.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_JOB_TIME;
+			jobLimit.BasicLimitInformation.PerJobUserTimeLimit.QuadPart = timelimit * 10000;
+		} else if (m_cpuTimePolicy == CPUTimePolicy::TotalCPUTime) {
+			jobLimit.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_TIME;
+			jobLimit.BasicLimitInformation.PerProcessUserTimeLimit.QuadPart = timelimit * 10000;
+		}
+		if (m_memoryLimit > 0) {
+			jobLimit.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_MEMORY;
+			jobLimit.ProcessMemoryLimit = m_memoryLimit;
+		}
+		// 超限后程序的表现不确定，所以通过作业通知判断
+		jobPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+		if (jobPort == NULL) {
+			jobPort = INVALID_HANDLE_VALUE;
 		} else {
-			this->m_workingDirectory.clear();
+			JOBOBJECT_ASSOCIATE_COMPLETION_PORT jobPortInfo;
+			jobPortInfo.CompletionKey = jobHandle;
+			jobPortInfo.CompletionPort = jobPort;
+			SetInformationJobObject(jobHandle, JobObjectAssociateCompletionPortInformation,
+			                        &jobPortInfo, sizeof(jobPortInfo));
 		}
-		// 创建事件对象
-		m_hExitEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		SetInformationJobObject(jobHandle, JobObjectExtendedLimitInformation,
+		                        &jobLimit, sizeof(jobLimit));
+		return jobHandle;
 	}
 
-	~ConsoleOJ() {
-		// 析构
-		m_willExit = true;
-		SetEvent(m_hExitEvent);
-		if (isLaunched) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	// 取出作业完成端口收到的通知，判断是否有进程内存超限或因CPU时间超限被结束
+	static void GetJobLimitHits(HANDLE jobPort, bool& isMemoryLimitHit, bool& isTimeLimitHit) {
+		isMemoryLimitHit = false;
+		isTimeLimitHit = false;
+		if (jobPort == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		DWORD message;
+		ULONG_PTR completionKey;
+		LPOVERLAPPED overlapped;
+		while (GetQueuedCompletionStatus(jobPort, &message, &completionKey, &overlapped, 0)) {
+			if (message == JOB_OBJECT_MSG_PROCESS_MEMORY_LIMIT) {
+				isMemoryLimitHit = true;
+			} else if (message == JOB_OBJECT_MSG_END_OF_PROCESS_TIME ||
+			           message == JOB_OBJECT_MSG_END_OF_JOB_TIME) {
+				isTimeLimitHit = true;
+			}
 		}
-		// 关闭事件同步对象句柄
-		CloseHandle(m_hExitEvent);
 	}
 
 	/*
-	 *	启动进程，返回目标程序是否在时限内成功运行
-	 *  输入文本[in]：将压入目标程序输入流的文本，为空则不输入文本
-	 *  时间限制[in]：单位毫秒，必须是100ms的倍数，否则向上取整到100ms的倍数
-	 *  输出文本[out]：返回程序输出流中的文本
-	 *  时间花费[out]：返回程序运行消耗的CPU时间
-	 *  错误信息[out]：返回程序运行失败的原因
+	 *  等待监视线程结束
+	 *  目标程序结束后管道通常随之关闭，监视线程取出剩余输出后自行结束
+	 *  如果目标程序留下的子进程仍持有管道，则取消监视线程的阻塞读取
 	 */
-	bool launchAndWait(const std::string& inputstr, long long timelimit,
-	                   std::string& outputstr, long long& timecosted, std::string& errstr) {
-		// 初始化安全标识符，使得管道可被子进程访问
-		SECURITY_ATTRIBUTES securityAttributes;
-		securityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
-		securityAttributes.bInheritHandle = TRUE;
-		securityAttributes.lpSecurityDescriptor = NULL;
-		// 管道句柄
-		HANDLE inputPipeRead = INVALID_HANDLE_VALUE;
-		HANDLE inputPipeWrite = INVALID_HANDLE_VALUE;
-		HANDLE outputPipeWrite = INVALID_HANDLE_VALUE;
-		// 初始化进程信息结构体
-		PROCESS_INFORMATION processInfo;
-		ZeroMemory(&processInfo, sizeof(processInfo));
-		try {
-			// 附带安全标识符创建输入管道
-			if (!CreatePipe(&inputPipeRead, &inputPipeWrite, &securityAttributes, 0)) {
-				errstr = "创建输入管道失败！";
-				throw 1;
+	void StopCheckProcThread() {
+		while (WaitForSingleObject(m_hReadDoneEvent, 10) != WAIT_OBJECT_0) {
+			m_rwProcMutex.lock_shared();
+			if (m_hReadThread != INVALID_HANDLE_VALUE) {
+				CancelSynchronousIo(m_hReadThread);
 			}
+			m_rwProcMutex.unlock_shared();
+		}
+		m_checkProcThread.join();
+	}
 
-			// 附带安全标识符创建输出管道
-			m_rwProcMutex.lock();
-			if (!CreatePipe(&m_outputPipeRead, &outputPipeWrite, &securityAttributes, 0)) {
-				errstr = "创建输出管道失败！";
-				throw 2;
+	static void WriteStrThread(ConsoleOJ* const classthis) {
+		const char* data = classthis->m_inputCStr;
+		size_t len = classthis->m_inputCStrLen;
+		while (len > 0) {
+			DWORD chunkLen = (len > (1u << 30)) ? (1u << 30) : static_cast<DWORD>(len);
+			DWORD bytesWritten;
+			// 目标程序提前退出或写入被取消时返回失败
+			if (!WriteFile(classthis->m_inputPipeWrite, data, chunkLen, &bytesWritten, NULL)) {
+				break;
 			}
-			m_rwProcMutex.unlock();
+			data += bytesWritten;
+			len -= bytesWritten;
+		}
 
-			// 初始化启动信息结构体
-			STARTUPINFOA startupInfo;
-			ZeroMemory(&startupInfo, sizeof(startupInfo));
-			startupInfo.cb = sizeof(startupInfo);
+		// 关闭写入端，目标程序读到管道关闭即为EOF
+		classthis->m_rwProcMutex.lock();
+		Clhandle_s(classthis->m_inputPipeWrite);
+		classthis->m_rwProcMutex.unlock();
+	}
 
-			// 设置输入输出管道，设置使用自定义管道标志位
-			startupInfo.hStdInput = inputPipeRead;
-			startupInfo.hStdOutput = outputPipeWrite;
-			startupInfo.hStdError = outputPipeWrite;
-			startupInfo.dwFlags |= STARTF_USESTDHANDLES;
+	// 按命令行解析规则给参数加引号，参数中的引号和引号前的反斜杠需要转义
+	static std::string QuoteArgument(const std::string& argument) {
+		std::string quoted = "\"";
+		size_t backslashCount = 0;
+		for (char ch : argument) {
+			if (ch == '\\') {
+				++backslashCount;
+				continue;
+			}
+			if (ch == '"') {
+				quoted.append(backslashCount * 2 + 1, '\\');
+			} else {
+				quoted.append(backslashCount, '\\');
+			}
+			quoted += ch;
+			backslashCount = 0;
+		}
+		// 结尾的引号前的反斜杠也需要转义
+		quoted.append(backslashCount * 2, '\\');
+		return quoted + "\"";
+	}
 
-			// 处理命令行信息
-			std::string commandLine = "\"" + m_programPath + "\"";
-			char* commandLine_c = new char[commandLine.size() + 1];
-			strncpy(commandLine_c, commandLine.c_str(), commandLine.size());
-			commandLine_c[commandLine.size()] = 0;
+	// 生成目标程序的命令行
+	std::string BuildCommandLine() const {
+		std::string commandLine = "\"" + m_programPath + "\"";
+		for (const std::string& argument : m_arguments) {
+			commandLine += " " + QuoteArgument(argument);
+		}
+		return commandLine;
+	}
 
-			// 创建进程
-			const char* workingDirectoryPtr = NULL;
-			if (!m_workingDirectory.empty()) {
-				workingDirectoryPtr = m_workingDirectory.c_str();
+	// 在临时目录创建一个空文件，返回文件路径，失败返回空串
+	static std::string CreateTempFile() {
+		char tempDirectory[MAX_PATH];
+		char tempPath[MAX_PATH];
+		if (GetTempPathA(MAX_PATH, tempDirectory) == 0 ||
+		    GetTempFileNameA(tempDirectory, "coj", 0, tempPath) == 0) {
+			return "";
+		}
+		return tempPath;
+	}
+
+	// 创建临时文件并写入内容，返回文件路径，失败返回空串
+	static std::string WriteTempFile(const std::string& content) {
+		std::string tempPath = CreateTempFile();
+		if (tempPath.empty()) {
+			return "";
+		}
+		std::ofstream tempFile(tempPath, std::ios::binary);
+		tempFile.write(content.data(), content.size());
+		tempFile.close();
+		if (!tempFile) {
+			DeleteFileA(tempPath.c_str());
+			return "";
+		}
+		return tempPath;
+	}
+
+	/*
+	 *  以传入的三个标准句柄创建进程，返回是否成功
+	 *  通过PROC_THREAD_ATTRIBUTE_HANDLE_LIST只让子进程继承这三个句柄，传入的句柄须为可继承的
+	 *  本类创建的进程都经过这里，并行评测时一个进程不会继承到其他评测的管道端
+	 */
+	static bool CreateProcessWithHandles(std::string commandLine, const char* workingDirectory,
+	                                     DWORD creationFlags, HANDLE stdinHandle,
+	                                     HANDLE stdoutHandle, HANDLE stderrHandle,
+	                                     PROCESS_INFORMATION& processInfo) {
+		// 句柄列表中不能有重复或无效的句柄
+		HANDLE handleList[3];
+		DWORD handleCount = 0;
+		for (HANDLE stdHandle : { stdinHandle, stdoutHandle, stderrHandle }) {
+			bool isListed = (stdHandle == NULL || stdHandle == INVALID_HANDLE_VALUE);
+			for (DWORD i = 0; i < handleCount; ++i) {
+				isListed = isListed || handleList[i] == stdHandle;
 			}
-			if (!CreateProcessA(NULL, commandLine_c, NULL, NULL, TRUE,
-			                    HIGH_PRIORITY_CLASS | CREATE_NO_WINDOW | CREATE_SUSPENDED,
-			                    NULL, workingDirectoryPtr, &startupInfo, &processInfo)) {
-				// 释放命令行文本
-				delete[] commandLine_c;
-				errstr = "创建进程失败！";
-				throw 3;
+			if (!isListed) {
+				handleList[handleCount++] = stdHandle;
 			}
+		}
+		SIZE_T attributeListSize = 0;
+		InitializeProcThreadAttributeList(NULL, 1, 0, &attributeListSize);
+		std::vector<char> attributeListBuffer(attributeListSize);
+		LPPROC_THREAD_ATTRIBUTE_LIST attributeList =
+			reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeListBuffer.data());
+		if (!InitializeProcThreadAttributeList(attributeList, 1, 0, &attributeListSize)) {
+			return false;
+		}
+		STARTUPINFOEXA startupInfo;
+		ZeroMemory(&startupInfo, sizeof(startupInfo));
+		startupInfo.StartupInfo.cb = sizeof(startupInfo);
+		startupInfo.StartupInfo.hStdInput = stdinHandle;
+		startupInfo.StartupInfo.hStdOutput = stdoutHandle;
+		startupInfo.StartupInfo.hStdError = stderrHandle;
+		startupInfo.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
+		startupInfo.lpAttributeList = attributeList;
+		BOOL isCreated = UpdateProcThreadAttribute(attributeList, 0,
+		                                           PROC_THREAD_ATTRIBUTE_HANDLE_LIST, handleList,
+		                                           handleCount * sizeof(HANDLE), NULL, NULL) &&
+		                 CreateProcessA(NULL, &commandLine[0], NULL, NULL, TRUE,
+		                                creationFlags | EXTENDED_STARTUPINFO_PRESENT, NULL,
+		                                workingDirectory, &startupInfo.StartupInfo, &processInfo);
+		DeleteProcThreadAttributeList(attributeList);
+		return isCreated != FALSE;
+	}
+#else
+	static void WriteStrThread(ConsoleOJ* const classthis) {
+		// 目标程序提前退出时写入会产生SIGPIPE，在本线程屏蔽它，改为返回EPIPE
+		sigset_t sigpipeMask;
+		sigemptyset(&sigpipeMask);
+		sigaddset(&sigpipeMask, SIGPIPE);
+		pthread_sigmask(SIG_BLOCK, &sigpipeMask, NULL);
 
-			// 释放命令行文本
-			delete[] commandLine_c;
+		const char* data = classthis->m_inputCStr;
+		size_t len = classthis->m_inputCStrLen;
+		while (len > 0) {
+			ssize_t bytesWritten = write(classthis->m_inputPipeWrite, data, len);
+			if (bytesWritten < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				break;
+			}
+			data += bytesWritten;
+			len -= bytesWritten;
+		}
 
-			isLaunched = true;
+		// 关闭写入端，目标程序读到EOF
+		Clfd_s(classthis->m_inputPipeWrite);
 
-			// 启动监视线程
-			m_checkProcThread = std::thread(&CheckProcThread, this);
+		// 丢弃可能挂起的SIGPIPE
+		timespec zeroTimeout = { 0, 0 };
+		sigtimedwait(&sigpipeMask, NULL, &zeroTimeout);
+	}
 
-			// 写入测试输入
-			std::string inputWithEOF;
-			if (!inputstr.empty()) {
-				// 不为空才需要真写入数据
-				inputWithEOF = inputstr + static_cast<char>(26);
-				// 异步写入数据
-				m_inputCStr = inputWithEOF.c_str();
-				m_inputCStrLen = static_cast<DWORD>(inputWithEOF.size());
-				m_inputPipeWrite = inputPipeWrite;
-				// 启动数据写入线程
-				m_WriteStrThread = std::thread(&WriteStrThread, this);
-			}
+	// 通知事件文件描述符
+	static void NotifyEventFd(int fd) {
+		uint64_t value = 1;
+		ssize_t ret = write(fd, &value, sizeof(value));
+		(void)ret;
+	}
 
-			// 需要等待析构标志句柄与进程句柄
-			HANDLE hWaitHandle[2];
-			hWaitHandle[0] = this->m_hExitEvent;
-			hWaitHandle[1] = processInfo.hProcess;
+	// 获取正在运行的进程消耗的CPU时间(所有线程)，单位毫秒，失败返回-1
+	static long long GetProcessCPUTime(pid_t pid) {
+		clockid_t clockId;
+		timespec ts;
+		if (clock_getcpuclockid(pid, &clockId) != 0 || clock_gettime(clockId, &ts) != 0) {
+			return -1;
+		}
+		return timespec2ms(ts);
+	}
 
-			// 存储初始CPU周期计数
-			ULONG64 stCycleTime = 0ull;
-			// 最小增长周期1e6
-			const ULONG64 minDCycleTime = 1000000ull;
+	// 向文件写入字符串，用于cgroup接口文件，返回是否成功
+	static bool WriteTextFile(const std::string& path, const std::string& text) {
+		int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return false;
+		}
+		bool isWritten = (write(fd, text.c_str(), text.size()) ==
+		                  static_cast<ssize_t>(text.size()));
+		Clfd_s(fd);
+		return isWritten;
+	}
 
-			// 处理时间限制为100ms的倍数
-			long long timeLimitCnt = timelimit / 100;
-			if (timelimit % 100) {
-				++timeLimitCnt;
-			}
-			timelimit = timeLimitCnt * 100;
+	// 读取文件中的全部文本，用于cgroup接口文件，返回是否成功
+	static bool ReadTextFile(const std::string& path, std::string& text) {
+		std::ifstream file(path);
+		if (!file) {
+			return false;
+		}
+		std::ostringstream content;
+		content << file.rdbuf();
+		text = content.str();
+		return true;
+	}
 
-			// 最大真实时间花费
-			long long maxRealTimeCost = 40 * timelimit;
+	/*
+	 *  为一次评测创建cgroup并设置内存限制
+	 *  返回cgroup目录，cgroup不可用(不是cgroup v2、未启用memory控制器或没有权限)时返回空串
+	 */
+	std::string CreateCgroup() {
+		static std::atomic<unsigned long long> cgroupCounter{ 0 };
+		std::string cgroupPath = m_cgroupRoot + "/run-" + std::to_string(getpid()) + "-" +
+		                         std::to_string(cgroupCounter++);
+		if (mkdir(cgroupPath.c_str(), 0755) != 0) {
+			return "";
+		}
+		std::string memoryMax = "max";
+		if (m_memoryLimit > 0) {
+			memoryMax = std::to_string(m_memoryLimit);
+		}
+		if (!WriteTextFile(cgroupPath + "/memory.max", memoryMax)) {
+			rmdir(cgroupPath.c_str());
+			return "";
+		}
+		// 禁止使用交换空间，否则超出限制的部分会被换出而不是触发OOM
+		WriteTextFile(cgroupPath + "/memory.swap.max", "0");
+		return cgroupPath;
+	}
 
-			// 继续执行进程
-			ResumeThread(processInfo.hThread);
+	// 读取cgroup的内存峰值，单位字节，内核不支持memory.peak时返回0
+	static size_t GetCgroupPeakMemory(const std::string& cgroupPath) {
+		std::string peak;
+		if (!ReadTextFile(cgroupPath + "/memory.peak", peak)) {
+			return 0;
+		}
+		return static_cast<size_t>(strtoull(peak.c_str(), NULL, 10));
+	}
 
-			// 开始计时
-			auto start = std::chrono::high_resolution_clock::now();
+	// 判断cgroup中是否有进程因内存超限被OOM结束
+	static bool IsCgroupOOMKilled(const std::string& cgroupPath) {
+		std::string events;
+		if (!ReadTextFile(cgroupPath + "/memory.events", events)) {
+			return false;
+		}
+		size_t found = events.find("oom_kill ");
+		return found != std::string::npos &&
+		       strtoull(events.c_str() + found + 9, NULL, 10) > 0;
+	}
 
-			// 开始等待句柄信号
-			while (1) {
-				// 同时等待两个句柄，只要有一个响应就退出阻塞
-				DWORD waitResult = WaitForMultipleObjects(2, hWaitHandle, FALSE, 100);
+	// 结束cgroup中的所有进程并删除cgroup
+	static void RemoveCgroup(std::string& cgroupPath) {
+		if (cgroupPath.empty()) {
+			return;
+		}
+		WriteTextFile(cgroupPath + "/cgroup.kill", "1");
+		// 进程退出需要一点时间，期间cgroup不能删除
+		for (int i = 0; i < 100 && rmdir(cgroupPath.c_str()) != 0 && errno == EBUSY; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		cgroupPath.clear();
+	}
 
-				if (m_willExit) {
-					errstr = "类正在析构！";
-					throw 4;
-				} else if (waitResult == WAIT_TIMEOUT) {
-					if (timeLimitCnt == 0) {
-						// 需要判断是不是真TLE了
-						FILETIME creationTime, exitTime, kernelTime, userTime;
-						GetThreadTimes(processInfo.hThread, &creationTime, &exitTime,
-						               &kernelTime, &userTime);
-						timecosted = fileTime2ms(kernelTime) + fileTime2ms(userTime);
-						if (timecosted > timelimit) {
-							errstr = "执行超时！";
-							throw 4;
-						}
-						// 先获取真实时间花费
-						std::chrono::duration<double> timeElapsed =
-						    std::chrono::high_resolution_clock::now() - start;
-						timecosted = std::chrono::duration_cast<std::chrono::milliseconds>
-						             (timeElapsed).count();
-						// 然后判断被阻塞的情况
-						ULONG64 curCycleTime = 0ull;
-						QueryThreadCycleTime(processInfo.hThread, &curCycleTime);
-						if (curCycleTime - stCycleTime < minDCycleTime) {
-							errstr = "程序疑似被阻塞，执行超时！";
-							throw 4;
-						}
-						stCycleTime = curCycleTime;
-						// 再判断真实耗时过大的情况
-						if (timecosted > maxRealTimeCost) {
-							errstr = "评测机负载过大，执行超时！";
-							throw 4;
-						}
-					} else {
-						--timeLimitCnt;
-					}
-				} else {
-					// 说明正常退出了
-					break;
+	/*
+	 *  获取目标程序消耗的CPU时间，单位毫秒，失败返回-1
+	 *  计入子进程且使用cgroup时为cgroup中所有进程之和，否则为目标进程所有线程之和
+	 */
+	long long GetRunCPUTime(pid_t pid, const std::string& cgroupPath) {
+		if (m_isChildProcessCounted && !cgroupPath.empty()) {
+			std::string stat;
+			if (ReadTextFile(cgroupPath + "/cpu.stat", stat)) {
+				size_t found = stat.find("usage_usec ");
+				if (found != std::string::npos) {
+					return static_cast<long long>(strtoull(stat.c_str() + found + 11, NULL, 10) / 1000);
 				}
 			}
+		}
+		return GetProcessCPUTime(pid);
+	}
 
-			// 程序时限内退出
+	/*
+	 *  为尚未exec的进程打开一个性能计数器，失败返回-1
+	 *  exec时开始计数，只统计用户态，之后创建的线程和子进程也计入(结束后累加)
+	 */
+	static int OpenPerfCounter(pid_t pid, uint32_t type, uint64_t config) {
+		perf_event_attr attr = perf_event_attr();
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.enable_on_exec = 1;
+		attr.inherit = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+	}
 
-			// 获取时间
-			FILETIME creationTime, exitTime, kernelTime, userTime;
-			GetThreadTimes(processInfo.hThread, &creationTime, &exitTime,
-			               &kernelTime, &userTime);
-			long long realTimeUsed, CPUTimeUsed;
-			realTimeUsed = fileTime2ms(exitTime) - fileTime2ms(creationTime);
-			if (realTimeUsed < 0) {
-				realTimeUsed = 0;
-			}
-			CPUTimeUsed = fileTime2ms(kernelTime) + fileTime2ms(userTime);
-			if (CPUTimeUsed > realTimeUsed) {
-				timecosted = realTimeUsed;
+	// 计时方式是否以性能计数器为准
+	bool IsPerfCounterPolicy() const {
+		return m_cpuTimePolicy == CPUTimePolicy::TaskClock || m_cpuTimePolicy == CPUTimePolicy::Instructions;
+	}
+
+	// 读取性能计数器：指令数和任务时钟
+	void ReadPerfCounters(const int* perfFds) {
+		uint64_t value;
+		if (perfFds[0] >= 0 && read(perfFds[0], &value, sizeof(value)) == sizeof(value)) {
+			m_instructionCount = value;
+		}
+		if (perfFds[1] >= 0 && read(perfFds[1], &value, sizeof(value)) == sizeof(value)) {
+			m_taskClockNanoseconds = value;
+		}
+	}
+
+	// 按性能计数器计算的时间花费，单位毫秒
+	long long GetPerfChargedTime() const {
+		if (m_cpuTimePolicy == CPUTimePolicy::Instructions) {
+			return static_cast<long long>(m_instructionCount / m_instructionsPerMillisecond);
+		}
+		return static_cast<long long>(m_taskClockNanoseconds / 1000000);
+	}
+
+	// 获取正在运行的进程的线程数，失败返回1
+	static long long GetProcessThreadCount(pid_t pid) {
+		std::ifstream statFile("/proc/" + std::to_string(pid) + "/stat");
+		std::string stat;
+		if (!std::getline(statFile, stat)) {
+			return 1;
+		}
+		// 进程名可能含有空格，从最后一个')'之后开始数，线程数是第20个字段
+		size_t found = stat.rfind(')');
+		if (found == std::string::npos) {
+			return 1;
+		}
+		std::istringstream fields(stat.substr(found + 1));
+		std::string field;
+		for (int i = 3; i <= 20 && (fields >> field); ++i) {
+		}
+		long long threadCount = atoll(field.c_str());
+		return (threadCount < 1) ? 1 : threadCount;
+	}
+
+	/*
+	 *  读取进程所有线程的调度状态，返回是否有线程处于可运行(R)或不可中断(D)状态
+	 *  运行时间[out]：所有线程在CPU上运行的时间之和，单位纳秒，来自schedstat，不可用时为0
+	 */
+	static bool GetProcessSchedState(pid_t pid, unsigned long long& runTime) {
+		runTime = 0;
+		std::string taskDir = "/proc/" + std::to_string(pid) + "/task";
+		DIR* dir = opendir(taskDir.c_str());
+		if (dir == NULL) {
+			return false;
+		}
+		bool isRunnable = false;
+		while (dirent* entry = readdir(dir)) {
+			if (entry->d_name[0] == '.') {
+				continue;
+			}
+			std::string threadDir = taskDir + "/" + entry->d_name;
+			std::string stat;
+			if (ReadTextFile(threadDir + "/stat", stat)) {
+				// 线程名可能含有空格，状态是最后一个')'之后的第一个字段
+				size_t found = stat.rfind(')');
+				if (found != std::string::npos && found + 2 < stat.size() &&
+				    (stat[found + 2] == 'R' || stat[found + 2] == 'D')) {
+					isRunnable = true;
+				}
+			}
+			std::string schedstat;
+			if (ReadTextFile(threadDir + "/schedstat", schedstat)) {
+				runTime += strtoull(schedstat.c_str(), NULL, 10);
+			}
+		}
+		closedir(dir);
+		return isRunnable;
+	}
+
+	// 设置定时器在指定毫秒数后到期一次
+	static void ArmTimer(int timerFd, long long milliseconds) {
+		itimerspec timerSpec;
+		timerSpec.it_interval.tv_sec = 0;
+		timerSpec.it_interval.tv_nsec = 0;
+		timerSpec.it_value.tv_sec = milliseconds / 1000;
+		timerSpec.it_value.tv_nsec = (milliseconds % 1000) * 1000000;
+		timerfd_settime(timerFd, 0, &timerSpec, NULL);
+	}
+
+	// 判断进程是否已经结束，不回收进程
+	static bool IsProcessExited(pid_t pid) {
+		siginfo_t info;
+		info.si_pid = 0;
+		if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0) {
+			return true;
+		}
+		return info.si_pid == pid;
+	}
+
+	// 生成目标程序的参数表，以NULL结尾，指向成员字符串，需要在fork之前生成
+	std::vector<char*> BuildArgv() {
+		std::vector<char*> argv;
+		argv.push_back(&m_programPath[0]);
+		for (std::string& argument : m_arguments) {
+			argv.push_back(&argument[0]);
+		}
+		argv.push_back(NULL);
+		return argv;
+	}
+
+	// 创建内存文件并写入内容，返回文件描述符，失败返回-1
+	static int CreateMemoryFile(const char* name, const std::string& content) {
+		int fd = memfd_create(name, MFD_CLOEXEC);
+		if (fd < 0) {
+			return -1;
+		}
+		size_t written = 0;
+		while (written < content.size()) {
+			ssize_t ret = write(fd, content.data() + written, content.size() - written);
+			if (ret < 0 && errno == EINTR) {
+				continue;
+			}
+			if (ret <= 0) {
+				Clfd_s(fd);
+				return -1;
+			}
+			written += static_cast<size_t>(ret);
+		}
+		return fd;
+	}
+
+	/*
+	 *  在fork出的子进程中恢复默认的SIGPIPE处理和空的信号屏蔽，只调用异步信号安全的函数
+	 *  exec会保留被忽略的信号和信号屏蔽，评测机忽略SIGPIPE时目标程序向已关闭的管道写入会继续运行而不是被结束
+	 */
+	static void ResetChildSignals() {
+		signal(SIGPIPE, SIG_DFL);
+		sigset_t emptyMask;
+		sigemptyset(&emptyMask);
+		sigprocmask(SIG_SETMASK, &emptyMask, NULL);
+	}
+
+	/*
+	 *  启动交互题中的一个进程，等待exec完成，返回进程号，失败返回-1
+	 *  标准输入、输出、错误重定向到传入的文件描述符，inheritFds中的文件描述符取消CLOEXEC供其继承
+	 *  进程处于独立的进程组，SIGPIPE为默认处理，向已结束的对方写入时被信号结束
+	 *  cgroupProcsPath不为NULL时在exec之前加入该cgroup，加入失败且有内存限制时改用RLIMIT_AS
+	 */
+	static pid_t SpawnProcess(char* const argv[], const char* workingDirectory,
+	                          int stdinFd, int stdoutFd, int stderrFd,
+	                          const int* inheritFds, int inheritFdCnt,
+	                          const char* cgroupProcsPath, size_t memoryLimit,
+	                          const rlimit& cpuLimit, const cpu_set_t& cpuSet) {
+		int execErrorPipe[2] = { -1, -1 };
+		if (pipe2(execErrorPipe, O_CLOEXEC) != 0) {
+			return -1;
+		}
+		pid_t pid = fork();
+		if (pid == 0) {
+			// 子进程：只能调用异步信号安全的函数
+			close(execErrorPipe[0]);
+			setpgid(0, 0);
+			ResetChildSignals();
+			for (int i = 0; i < inheritFdCnt; ++i) {
+				if (inheritFds[i] >= 0) {
+					fcntl(inheritFds[i], F_SETFD, 0);
+				}
+			}
+			dup2(stdinFd, STDIN_FILENO);
+			dup2(stdoutFd, STDOUT_FILENO);
+			dup2(stderrFd, STDERR_FILENO);
+			int err = 0;
+			if (workingDirectory != NULL && chdir(workingDirectory) != 0) {
+				err = errno;
+			} else {
+				bool isCgroupJoined = false;
+				if (cgroupProcsPath != NULL) {
+					// 写入0表示把写入者自身加入cgroup
+					int procsFd = open(cgroupProcsPath, O_WRONLY | O_CLOEXEC);
+					if (procsFd >= 0) {
+						isCgroupJoined = (write(procsFd, "0", 1) == 1);
+						close(procsFd);
+					}
+				}
+				if (!isCgroupJoined && memoryLimit > 0) {
+					rlimit memoryRlimit;
+					memoryRlimit.rlim_cur = memoryLimit;
+					memoryRlimit.rlim_max = memoryLimit;
+					setrlimit(RLIMIT_AS, &memoryRlimit);
+				}
+				setrlimit(RLIMIT_CPU, &cpuLimit);
+				if (CPU_COUNT(&cpuSet) > 0) {
+					sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+				}
+				execv(argv[0], argv);
+				err = errno;
+			}
+			ssize_t ret = write(execErrorPipe[1], &err, sizeof(err));
+			(void)ret;
+			_exit(127);
+		}
+		Clfd_s(execErrorPipe[1]);
+		if (pid < 0) {
+			Clfd_s(execErrorPipe[0]);
+			return -1;
+		}
+		setpgid(pid, pid);
+		// exec成功时管道随之关闭，读到EOF
+		int execError = 0;
+		ssize_t errorLen;
+		while ((errorLen = read(execErrorPipe[0], &execError, sizeof(execError))) < 0 &&
+		       errno == EINTR) {
+		}
+		Clfd_s(execErrorPipe[0]);
+		if (errorLen > 0) {
+			while (waitpid(pid, NULL, 0) < 0 && errno == EINTR) {
+			}
+			return -1;
+		}
+		return pid;
+	}
+
+	// 读取内存文件中的全部内容
+	static std::string ReadMemoryFile(int fd) {
+		std::string content;
+		char buffer[4096];
+		ssize_t bytesRead;
+		lseek(fd, 0, SEEK_SET);
+		while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0 ||
+		       (bytesRead < 0 && errno == EINTR)) {
+			if (bytesRead > 0) {
+				content.append(buffer, static_cast<size_t>(bytesRead));
+			}
+		}
+		return content;
+	}
+#endif
+
+	/*
+	 *  按检查器或交互器给出的结果设置评测结果和错误信息，返回结果是否为Accepted
+	 *  结果为SystemError时保留调用者预先设置的错误信息
+	 */
+	bool SetCheckerVerdict(JudgeVerdict verdict, std::string& errstr) {
+		m_verdict = verdict;
+		switch (verdict) {
+			case JudgeVerdict::Accepted:
+				errstr.clear();
+				return true;
+			case JudgeVerdict::WrongAnswer:
+				errstr = "答案错误！";
+				break;
+			case JudgeVerdict::PresentationError:
+				errstr = "格式错误！";
+				break;
+			case JudgeVerdict::PartiallyCorrect:
+				errstr = "部分正确！";
+				break;
+			default:
+				break;
+		}
+		return false;
+	}
+
+#ifdef _WIN32
+	/*
+	 *  运行检查器，根据其退出代码设置评测结果，返回结果是否为Accepted
+	 *  输入、输出写入临时文件，输入和标准答案来自文件时直接传入该文件
+	 *  检查器的标准输出和标准错误重定向到临时文件，结束后作为检查器信息
+	 */
+	bool RunChecker(const std::string& inputstr, const std::string& outputstr,
+	                std::string& errstr) {
+		// 准备检查器的三个文件，需要删除的临时文件记录在tempPaths中
+		// 输入来自文件时直接传入该文件
+		std::string inputPath = m_inputFilePath;
+		std::string outputPath = WriteTempFile(outputstr);
+		std::string answerPath = m_expectedOutputPath;
+		std::string messagePath = CreateTempFile();
+		std::string tempPaths[] = { "", outputPath, "", messagePath };
+		if (inputPath.empty()) {
+			inputPath = WriteTempFile(inputstr);
+			tempPaths[0] = inputPath;
+		}
+		if (answerPath.empty()) {
+			answerPath = WriteTempFile(m_comparator.getExpected());
+			tempPaths[2] = answerPath;
+		}
+
+		// 以可继承的方式打开检查器信息文件
+		SECURITY_ATTRIBUTES securityAttributes;
+		securityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+		securityAttributes.bInheritHandle = TRUE;
+		securityAttributes.lpSecurityDescriptor = NULL;
+		HANDLE messageHandle = INVALID_HANDLE_VALUE;
+		if (!messagePath.empty()) {
+			messageHandle = CreateFileA(messagePath.c_str(), GENERIC_WRITE,
+			                            FILE_SHARE_READ | FILE_SHARE_WRITE, &securityAttributes,
+			                            CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+		}
+
+		JudgeVerdict checkerVerdict = JudgeVerdict::SystemError;
+		errstr = "检查器运行失败！";
+		PROCESS_INFORMATION processInfo;
+		ZeroMemory(&processInfo, sizeof(processInfo));
+		std::string commandLine = "\"" + m_checkerPath + "\" \"" + inputPath + "\" \"" +
+		                          outputPath + "\" \"" + answerPath + "\"";
+		if (!inputPath.empty() && !outputPath.empty() && !answerPath.empty() &&
+		    messageHandle != INVALID_HANDLE_VALUE &&
+		    CreateProcessWithHandles(commandLine, NULL, CREATE_NO_WINDOW | CREATE_SUSPENDED,
+		                             NULL, messageHandle, messageHandle, processInfo)) {
+			// 加入作业对象，超时或析构时结束检查器及其子进程
+			HANDLE jobHandle = CreateJobObject(NULL, NULL);
+			if (jobHandle == NULL) {
+				jobHandle = INVALID_HANDLE_VALUE;
+			} else {
+				JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobLimit;
+				ZeroMemory(&jobLimit, sizeof(jobLimit));
+				jobLimit.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+				SetInformationJobObject(jobHandle, JobObjectExtendedLimitInformation,
+				                        &jobLimit, sizeof(jobLimit));
+				AssignProcessToJobObject(jobHandle, processInfo.hProcess);
+			}
+			ResumeThread(processInfo.hThread);
+
+			// 等待检查器结束、超时或析构
+			HANDLE hWaitHandle[2];
+			hWaitHandle[0] = this->m_hExitEvent;
+			hWaitHandle[1] = processInfo.hProcess;
+			DWORD waitResult = WaitForMultipleObjects(2, hWaitHandle, FALSE,
+			                                          static_cast<DWORD>(m_checkerTimeLimit));
+			if (waitResult == WAIT_OBJECT_0 + 1) {
+				DWORD exitCode;
+				GetExitCodeProcess(processInfo.hProcess, &exitCode);
+				checkerVerdict = checkerExitCodeToVerdict(static_cast<int>(exitCode));
+			} else {
+				TerminateProcess(processInfo.hProcess, 1);
+				WaitForSingleObject(processInfo.hProcess, INFINITE);
+				if (waitResult == WAIT_TIMEOUT) {
+					errstr = "检查器运行超时！";
+				} else {
+					errstr = "类正在析构！";
+				}
+			}
+			Clhandle_s(jobHandle);
+			Clhandle_s(processInfo.hThread);
+			Clhandle_s(processInfo.hProcess);
+		}
+		Clhandle_s(messageHandle);
+
+		// 读取检查器信息，删除临时文件
+		if (!messagePath.empty()) {
+			std::ifstream messageFile(messagePath, std::ios::binary);
+			std::ostringstream message;
+			message << messageFile.rdbuf();
+			m_checkerMessage += message.str();
+		}
+		for (const std::string& tempPath : tempPaths) {
+			if (!tempPath.empty()) {
+				DeleteFileA(tempPath.c_str());
+			}
+		}
+
+		return SetCheckerVerdict(checkerVerdict, errstr);
+	}
+#else
+	/*
+	 *  运行检查器，根据其退出代码设置评测结果，返回结果是否为Accepted
+	 *  输入、输出和标准答案放在内存文件中，检查器继承文件描述符，通过/dev/fd/N打开
+	 *  输入和标准答案来自文件时直接传入该文件
+	 *  检查器的标准输出和标准错误重定向到内存文件，结束后作为检查器信息
+	 */
+	bool RunChecker(const std::string& inputstr, const std::string& outputstr,
+	                std::string& errstr) {
+		// 准备检查器的三个文件和信息文件，以及对应的路径
+		int checkerFds[4] = { -1, CreateMemoryFile("output", outputstr), -1,
+		                      CreateMemoryFile("message", "") };
+		std::string inputPath = m_inputFilePath;
+		if (inputPath.empty()) {
+			checkerFds[0] = CreateMemoryFile("input", inputstr);
+			inputPath = "/dev/fd/" + std::to_string(checkerFds[0]);
+		}
+		std::string answerPath = m_expectedOutputPath;
+		if (answerPath.empty()) {
+			checkerFds[2] = CreateMemoryFile("answer", m_comparator.getExpected());
+			answerPath = "/dev/fd/" + std::to_string(checkerFds[2]);
+		}
+		std::string outputPath = "/dev/fd/" + std::to_string(checkerFds[1]);
+
+		JudgeVerdict checkerVerdict = JudgeVerdict::SystemError;
+		errstr = "检查器运行失败！";
+		pid_t pid = -1;
+		if (m_inputFilePath.empty() == (checkerFds[0] >= 0) && checkerFds[1] >= 0 &&
+		    m_expectedOutputPath.empty() == (checkerFds[2] >= 0) && checkerFds[3] >= 0) {
+			// fork之后只能调用异步信号安全的函数，所以提前准备好参数
+			const char* checkerPath = m_checkerPath.c_str();
+			char* argv[] = { const_cast<char*>(checkerPath), &inputPath[0], &outputPath[0],
+			                 &answerPath[0], NULL };
+			pid = fork();
+			if (pid == 0) {
+				// 子进程：独立进程组，取消内存文件的CLOEXEC以便检查器继承
+				setpgid(0, 0);
+				ResetChildSignals();
+				for (int i = 0; i < 3; ++i) {
+					if (checkerFds[i] >= 0) {
+						fcntl(checkerFds[i], F_SETFD, 0);
+					}
+				}
+				int nullFd = open("/dev/null", O_RDONLY);
+				if (nullFd >= 0) {
+					dup2(nullFd, STDIN_FILENO);
+				}
+				dup2(checkerFds[3], STDOUT_FILENO);
+				dup2(checkerFds[3], STDERR_FILENO);
+				execv(checkerPath, argv);
+				_exit(127);
+			}
+		}
+		if (pid > 0) {
+			setpgid(pid, pid);
+			// 等待检查器结束、超时或析构，没有pidfd时每10ms检查一次
+			int pidFd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+			pollfd waitFds[2];
+			waitFds[0].fd = m_exitEventFd;
+			waitFds[0].events = POLLIN;
+			waitFds[1].fd = pidFd;
+			waitFds[1].events = POLLIN;
+			nfds_t waitFdCnt = (pidFd >= 0) ? 2 : 1;
+			auto start = std::chrono::steady_clock::now();
+			bool isExited = false;
+			while (!m_willExit && !(isExited = IsProcessExited(pid))) {
+				long long remaining = m_checkerTimeLimit -
+				                      std::chrono::duration_cast<std::chrono::milliseconds>
+				                      (std::chrono::steady_clock::now() - start).count();
+				if (remaining <= 0) {
+					break;
+				}
+				int pollTimeout = (pidFd < 0 && remaining > 10) ? 10 : static_cast<int>(remaining);
+				poll(waitFds, waitFdCnt, pollTimeout);
+			}
+			Clfd_s(pidFd);
+			// 结束检查器留下的进程，然后回收检查器
+			kill(-pid, SIGKILL);
+			int status = 0;
+			while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+			}
+			if (!isExited) {
+				errstr = m_willExit ? "类正在析构！" : "检查器运行超时！";
+			} else if (WIFEXITED(status)) {
+				checkerVerdict = checkerExitCodeToVerdict(WEXITSTATUS(status));
+			}
+		}
+
+		// 读取检查器信息，关闭内存文件
+		if (checkerFds[3] >= 0) {
+			m_checkerMessage += ReadMemoryFile(checkerFds[3]);
+		}
+		for (int& fd : checkerFds) {
+			Clfd_s(fd);
+		}
+
+		return SetCheckerVerdict(checkerVerdict, errstr);
+	}
+#endif
+
+	// 计算评测结果缓存的键，没有设置缓存、没有标准答案和检查器或无法读取文件时返回空串
+	std::string GetVerdictCacheKey(const std::string& inputstr, long long timelimit) {
+		if (m_verdictCache == nullptr || (!m_hasExpectedOutput && m_checkerPath.empty())) {
+			return "";
+		}
+		std::vector<std::string> fields;
+		fields.push_back(m_verdictCache->HashFile(m_programPath));
+		fields.push_back(m_inputFilePath.empty() ? Sha256::hashHex(inputstr)
+		                                         : m_verdictCache->HashFile(m_inputFilePath));
+		fields.push_back(m_hasExpectedOutput ? Sha256::hashHex(m_comparator.getExpected()) : "");
+		fields.push_back(m_checkerPath.empty() ? "" : m_verdictCache->HashFile(m_checkerPath));
+		if (fields[0].empty() || fields[1].empty() || (!m_checkerPath.empty() && fields[3].empty())) {
+			return "";
+		}
+		fields.push_back(m_checkerPath.empty() ? "" : std::to_string(m_checkerTimeLimit));
+		fields.push_back(std::to_string(timelimit));
+		fields.push_back(std::to_string(m_memoryLimit));
+		fields.push_back(std::to_string(m_outputLimit));
+		fields.push_back(std::to_string(static_cast<int>(m_cpuTimePolicy)));
+		fields.push_back(m_isChildProcessCounted ? "1" : "0");
+		fields.push_back(std::to_string(m_idleLimit));
+		fields.push_back(m_cpuTimePolicy == CPUTimePolicy::Instructions ? std::to_string(m_instructionsPerMillisecond) : "");
+		fields.push_back(std::to_string(m_arguments.size()));
+		fields.insert(fields.end(), m_arguments.begin(), m_arguments.end());
+		return m_verdictCache->MakeKey(fields);
+	}
+
+	// 从缓存取出评测结果，返回是否命中
+	bool LoadCachedVerdict(const std::string& key, long long timelimit, long long& timecosted) {
+		VerdictCacheEntry entry;
+		if (key.empty() || !m_verdictCache->Lookup(key, timelimit, m_memoryLimit, entry)) {
+			return false;
+		}
+		m_verdict = JudgeVerdict::Accepted;
+		timecosted = entry.timeCosted;
+		m_realTimeCosted = entry.realTimeCosted;
+		m_peakMemory = entry.peakMemory;
+		m_checkerMessage = entry.checkerMessage;
+		m_isVerdictCached = true;
+		return true;
+	}
+
+	// 评测通过时存入缓存，返回传入的评测是否成功
+	bool StoreCachedVerdict(const std::string& key, bool isSucceeded, long long timecosted) {
+		if (!key.empty() && isSucceeded && m_verdict == JudgeVerdict::Accepted) {
+			VerdictCacheEntry entry;
+			entry.timeCosted = timecosted;
+			entry.realTimeCosted = m_realTimeCosted;
+			entry.peakMemory = m_peakMemory;
+			entry.checkerMessage = m_checkerMessage;
+			m_verdictCache->Store(key, entry);
+		}
+		return isSucceeded;
+	}
+
+public:
+	/*
+	 *	构造时传入：可执行文件路径
+	 */
+	explicit ConsoleOJ(const std::string& programPath) : m_programPath(programPath) {
+		// 处理工作目录
+#ifdef _WIN32
+		size_t found = programPath.find_last_of("/\\");
+#else
+		size_t found = programPath.find_last_of("/");
+#endif
+		if (found != std::string::npos) {
+			this->m_workingDirectory = programPath.substr(0, found);
+		} else {
+			this->m_workingDirectory.clear();
+		}
+#ifdef _WIN32
+		// 创建事件对象
+		m_hExitEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		m_hReadDoneEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+#else
+		// 切换工作目录后相对路径会失效，所以转换为绝对路径
+		// 不解析符号链接：路径同时作为argv[0]，clang++、ccache等程序按argv[0]决定行为
+		std::error_code errorCode;
+		std::filesystem::path absolutePath = std::filesystem::absolute(programPath, errorCode);
+		if (!errorCode) {
+			this->m_programPath = absolutePath.lexically_normal().string();
+		}
+		// 创建事件对象
+		m_exitEventFd = eventfd(0, EFD_CLOEXEC);
+#endif
+	}
+
+	~ConsoleOJ() {
+		// 析构
+		m_willExit = true;
+#ifdef _WIN32
+		SetEvent(m_hExitEvent);
+#else
+		NotifyEventFd(m_exitEventFd);
+#endif
+		if (isLaunched) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+		// 关闭事件同步对象
+#ifdef _WIN32
+		CloseHandle(m_hExitEvent);
+		CloseHandle(m_hReadDoneEvent);
+#else
+		Clfd_s(m_exitEventFd);
+#endif
+	}
+
+	// 返回输出块内存池的统计信息
+	OutputChunkPoolStats getChunkPoolStats() {
+		return m_chunkPool.getStats();
+	}
+
+	/*
+	 *  设置目标程序绑定的CPU，对之后启动的进程生效
+	 *  CPU编号[in]：从0开始，-1为不绑定
+	 */
+	void setCPUAffinity(int cpuIndex) {
+		m_cpuAffinity = cpuIndex;
+	}
+
+	// 设置传给目标程序的命令行参数，对之后启动的进程生效，默认没有参数
+	void setArguments(const std::vector<std::string>& arguments) {
+		m_arguments = arguments;
+	}
+
+	/*
+	 *  设置标准答案，对之后的评测生效
+	 *  评测时输出边产生边与标准答案比较，发现不一致立即结束目标程序，结果为WrongAnswer
+	 */
+	void setExpectedOutput(const std::string& answer) {
+		m_comparator.Reset(answer);
+		m_hasExpectedOutput = true;
+		m_expectedOutputPath.clear();
+	}
+
+	// 从文件读取标准答案，返回是否读取成功
+	bool setExpectedOutputFile(const std::string& answerPath) {
+		std::ifstream answerFile(answerPath, std::ios::binary);
+		if (!answerFile) {
+			return false;
+		}
+		std::ostringstream answer;
+		answer << answerFile.rdbuf();
+		setExpectedOutput(answer.str());
+		m_expectedOutputPath = answerPath;
+		return true;
+	}
+
+	// 清除标准答案，之后的评测不再比较输出
+	void clearExpectedOutput() {
+		m_comparator.Reset("");
+		m_hasExpectedOutput = false;
+		m_expectedOutputPath.clear();
+	}
+
+	/*
+	 *  设置检查器(special judge)，对之后的评测生效
+	 *  目标程序正常结束后运行检查器，命令行为：检查器 输入文件 输出文件 标准答案文件
+	 *  评测结果由检查器的退出代码决定，见checkerExitCodeToVerdict
+	 *  设置检查器后不再逐记号比较输出，标准答案只传给检查器，未设置标准答案时传入空文件
+	 *  检查器路径[in]：可执行文件路径
+	 *  检查器时间限制[in]：单位毫秒，按真实时间计算，超时结果为SystemError
+	 */
+	void setChecker(const std::string& checkerPath, long long checkerTimeLimit = 10000) {
+		m_checkerPath = checkerPath;
+		m_checkerTimeLimit = checkerTimeLimit;
+	}
+
+	// 清除检查器，之后的评测恢复为与标准答案逐记号比较
+	void clearChecker() {
+		m_checkerPath.clear();
+	}
+
+	// 返回上一次评测中检查器的标准输出和标准错误，没有运行检查器时为空
+	const std::string& getCheckerMessage() const {
+		return m_checkerMessage;
+	}
+
+	/*
+	 *  设置评测结果缓存，对之后的launchAndWait和launchAndWaitFile生效，传入nullptr则不使用缓存
+	 *  只在设置了标准答案或检查器时使用缓存，交互题不使用缓存
+	 *  命中时不运行目标程序，直接返回缓存的时间、内存峰值和检查器信息，输出文本为空
+	 *  缓存对象可以由多个ConsoleOJ对象共用，生命周期由调用者管理
+	 */
+	void setVerdictCache(VerdictCache* verdictCache) {
+		m_verdictCache = verdictCache;
+	}
+
+	// 返回上一次评测的结果是否来自缓存
+	bool isVerdictCached() const {
+		return m_isVerdictCached;
+	}
+
+	/*
+	 *  返回上一次评测是否因评测机负载过大而中止
+	 *  目标程序仍在运行但真实时间超过时间限制的40倍时中止，结果为SystemError而不是TimeLimitExceeded，应在负载降低后重新评测
+	 */
+	bool isOverloaded() const {
+		return m_isOverloaded;
+	}
+
+#ifndef _WIN32
+	/*
+	 *  设置zygote，对之后的launchAndWait和launchAndWaitFile生效，传入nullptr则每次自行fork
+	 *  目标程序由zygote预先创建的子进程exec，评测机不再fork，zygote不可用时自动退回fork
+	 *  zygote可以由多个ConsoleOJ对象共用，生命周期由调用者管理，仅Linux可用
+	 *  目标程序的环境变量是构造zygote时的环境变量，内存限制和cgroup仍由本类在放行启动屏障前设置
+	 */
+	void setZygote(ConsoleOJZygote* zygote) {
+		m_zygote = zygote;
+	}
+#endif
+
+	/*
+	 *  设置输出字节数限制，对之后的评测生效
+	 *  输出超过限制时立即结束目标程序，结果为OutputLimitExceeded，输出文本保留限制以内的部分
+	 *  输出限制[in]：单位字节，0为不限制
+	 */
+	void setOutputLimit(size_t outputLimit) {
+		m_outputLimit = outputLimit;
+	}
+
+	// 返回上一次评测的结果
+	JudgeVerdict getVerdict() const {
+		return m_verdict;
+	}
+
+	// 返回上一次评测中第一个与标准答案不一致处在输出中的字节位置
+	size_t getMismatchOffset() const {
+		return m_mismatchOffset;
+	}
+
+	/*
+	 *  设置内存限制，对之后的评测生效
+	 *  Windows下通过作业对象限制进程可提交的内存，超过限制时结果为MemoryLimitExceeded
+	 *  POSIX下优先通过cgroup v2的memory.max限制，内存超限被OOM结束时结果为MemoryLimitExceeded
+	 *  cgroup不可用时退化为RLIMIT_AS限制地址空间，此时内存分配失败的程序通常表现为运行错误
+	 *  内存限制[in]：单位字节，0为不限制
+	 */
+	void setMemoryLimit(size_t memoryLimit) {
+		m_memoryLimit = memoryLimit;
+	}
+
+#ifndef _WIN32
+	/*
+	 *  设置父cgroup目录，默认为/sys/fs/cgroup/ConsoleOJ
+	 *  该目录需要由管理员创建，在其父目录的cgroup.subtree_control中启用memory控制器，并授予写权限
+	 */
+	void setCgroupRoot(const std::string& cgroupRoot) {
+		m_cgroupRoot = cgroupRoot;
+	}
+#endif
+
+	/*
+	 *  返回上一次评测的内存峰值，单位字节
+	 *  Windows下为已提交的内存；POSIX下使用cgroup时为memory.peak，否则为最大常驻内存
+	 */
+	size_t getPeakMemory() const {
+		return m_peakMemory;
+	}
+
+	// 返回上一次评测中目标程序运行的真实时间，单位毫秒
+	long long getRealTimeCosted() const {
+		return m_realTimeCosted;
+	}
+
+	/*
+	 *  返回上一次评测中目标程序的退出代码
+	 *  被信号结束或被评测机结束(超时、空闲超限、输出不一致或超限)时为0
+	 *  Windows下因作业对象的限制被结束时按原样返回
+	 */
+	int getExitCode() const {
+		return m_exitCode;
+	}
+
+	/*
+	 *  返回上一次评测中结束目标程序的信号，Windows下没有信号，总是0
+	 *  正常退出或被评测机结束(超时、空闲超限、输出不一致或超限)时为0
+	 *  内核按资源限制发出的信号按原样返回，如内存超限被OOM结束的SIGKILL、CPU时间超限的SIGXCPU
+	 */
+	int getExitSignal() const {
+		return m_exitSignal;
+	}
+
+	/*
+	 *  设置时间的计算方式，对之后的评测生效，默认为TotalCPUTime且不计入子进程
+	 *  计时方式[in]：TotalCPUTime按所有线程的CPU时间之和，WallClockTime按真实时间
+	 *               TaskClock按性能计数器的任务时钟，Instructions按用户态指令数换算(见setInstructionRate)
+	 *               性能计数器计入目标程序的全部线程和子进程，不可用时评测结果为SystemError
+	 *               交互题和Windows下不使用性能计数器，TaskClock和Instructions按TotalCPUTime计算
+	 *  是否计入子进程[in]：为true时CPU时间按作业对象(Windows)或cgroup(POSIX)中所有进程之和计算
+	 *  cgroup不可用时只能计入目标程序已回收的子进程
+	 */
+	void setCPUTimePolicy(CPUTimePolicy policy, bool isChildProcessCounted = false) {
+#ifdef _WIN32
+		m_cpuTimePolicy = (policy == CPUTimePolicy::WallClockTime) ? policy : CPUTimePolicy::TotalCPUTime;
+#else
+		m_cpuTimePolicy = policy;
+#endif
+		m_isChildProcessCounted = isChildProcessCounted;
+	}
+
+	/*
+	 *  设置空闲时间限制，对之后的launchAndWait和launchAndWaitFile生效
+	 *  程序连续空闲超过该真实时间时视为被阻塞(如等待输入、死锁)，结果为IdlenessLimitExceeded
+	 *  Windows下按CPU时间是否增长判断；POSIX下按/proc中所有线程的调度状态判断：
+	 *  没有线程处于可运行或不可中断状态，且运行时间没有增长即为空闲
+	 *  正常休眠的程序只要休眠不超过该限制就不受影响，主线程等待而其他线程运行的程序不算空闲
+	 *  空闲时间限制[in]：单位毫秒，0为等于时间限制
+	 */
+	void setIdleLimit(long long idleLimit) {
+		m_idleLimit = (idleLimit > 0) ? idleLimit : 0;
+	}
+
+	/*
+	 *  设置Instructions计时方式下每毫秒计入的指令数，默认为1000000
+	 *  应按评测机的实际速度标定，例如用参考程序的指令数除以其在空闲机器上的CPU时间
+	 */
+	void setInstructionRate(unsigned long long instructionsPerMillisecond) {
+		m_instructionsPerMillisecond = (instructionsPerMillisecond > 0) ? instructionsPerMillisecond : 1;
+	}
+
+	/*
+	 *  设置是否统计性能计数器，对之后的launchAndWait和launchAndWaitFile生效
+	 *  计时方式为TaskClock或Instructions时总是统计，否则只在开启时统计，不可用时结果为0，不影响评测
+	 *  Windows下不支持，结果总是0
+	 */
+	void setPerfCounters(bool isEnabled) {
+		m_isPerfCounterEnabled = isEnabled;
+	}
+
+	// 返回上一次评测中目标程序的用户态指令数，没有统计时为0
+	unsigned long long getInstructionCount() const {
+		return m_instructionCount;
+	}
+
+	// 返回上一次评测中目标程序的任务时钟，单位纳秒，没有统计时为0
+	unsigned long long getTaskClockNanoseconds() const {
+		return m_taskClockNanoseconds;
+	}
+
+#ifdef _WIN32
+	/*
+	 *	启动进程，返回目标程序是否在时限内成功运行
+	 *  输入文本[in]：将压入目标程序输入流的文本，为空则不输入文本，输入完毕后关闭输入流
+	 *  时间限制[in]：单位毫秒
+	 *  输出文本[out]：返回程序输出流中的文本，程序启动后运行失败时为已读取的部分
+	 *  时间花费[out]：返回程序运行消耗的时间，计算方式由setCPUTimePolicy设置
+	 *  错误信息[out]：返回程序运行失败的原因
+	 */
+	bool launchAndWait(const std::string& inputstr, long long timelimit,
+	                   std::string& outputstr, long long& timecosted, std::string& errstr) {
+		// 初始化安全标识符，使得管道可被子进程访问
+		SECURITY_ATTRIBUTES securityAttributes;
+		securityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+		securityAttributes.bInheritHandle = TRUE;
+		securityAttributes.lpSecurityDescriptor = NULL;
+		// 管道句柄
+		HANDLE inputPipeRead = INVALID_HANDLE_VALUE;
+		HANDLE inputPipeWrite = INVALID_HANDLE_VALUE;
+		HANDLE outputPipeWrite = INVALID_HANDLE_VALUE;
+		// 作业对象和接收作业通知的完成端口，用于限制和统计内存
+		HANDLE jobHandle = INVALID_HANDLE_VALUE;
+		HANDLE jobPort = INVALID_HANDLE_VALUE;
+		// 输入文件句柄，没有设置输入文件时不使用
+		HANDLE inputFileHandle = INVALID_HANDLE_VALUE;
+		// 初始化进程信息结构体
+		PROCESS_INFORMATION processInfo;
+		ZeroMemory(&processInfo, sizeof(processInfo));
+		// 重置评测结果和比较状态
+		m_verdict = JudgeVerdict::None;
+		m_mismatchOffset = 0;
+		m_peakMemory = 0;
+		m_realTimeCosted = 0;
+		m_exitCode = 0;
+		m_startTime = std::chrono::steady_clock::now();
+		m_readerVerdict = JudgeVerdict::None;
+		m_comparator.Restart();
+		m_checkerMessage.clear();
+		m_isVerdictCached = false;
+		m_isOverloaded = false;
+		timecosted = 0;
+		// 查询评测结果缓存，命中时不运行目标程序
+		std::string verdictCacheKey = GetVerdictCacheKey(inputstr, timelimit);
+		if (LoadCachedVerdict(verdictCacheKey, timelimit, timecosted)) {
+			outputstr.clear();
+			return true;
+		}
+		try {
+			// 附带安全标识符创建输入管道
+			if (!CreatePipe(&inputPipeRead, &inputPipeWrite, &securityAttributes, 0)) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建输入管道失败！";
+				throw 1;
+			}
+			// 本进程使用的写入端不可被继承，否则目标程序持有写入端，读不到EOF
+			SetHandleInformation(inputPipeWrite, HANDLE_FLAG_INHERIT, 0);
+
+			// 附带安全标识符创建输出管道
+			m_rwProcMutex.lock();
+			if (!CreatePipe(&m_outputPipeRead, &outputPipeWrite, &securityAttributes,
+			                m_outputPipeSize)) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建输出管道失败！";
+				throw 2;
+			}
+			// 本进程使用的读取端同样不可被继承
+			SetHandleInformation(m_outputPipeRead, HANDLE_FLAG_INHERIT, 0);
+			m_rwProcMutex.unlock();
+
+			// 设置了输入文件时标准输入直接重定向到文件，不经过管道
+			if (!m_inputFilePath.empty()) {
+				inputFileHandle = CreateFileA(m_inputFilePath.c_str(), GENERIC_READ,
+				                              FILE_SHARE_READ, &securityAttributes, OPEN_EXISTING,
+				                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+				if (inputFileHandle == INVALID_HANDLE_VALUE) {
+					m_verdict = JudgeVerdict::SystemError;
+					errstr = "打开输入文件失败！";
+					throw 3;
+				}
+			}
+			HANDLE stdinHandle = inputPipeRead;
+			if (inputFileHandle != INVALID_HANDLE_VALUE) {
+				stdinHandle = inputFileHandle;
+			}
+
+			// 创建进程
+			const char* workingDirectoryPtr = NULL;
+			if (!m_workingDirectory.empty()) {
+				workingDirectoryPtr = m_workingDirectory.c_str();
+			}
+			if (!CreateProcessWithHandles(BuildCommandLine(), workingDirectoryPtr,
+			                              HIGH_PRIORITY_CLASS | CREATE_NO_WINDOW | CREATE_SUSPENDED,
+			                              stdinHandle, outputPipeWrite, outputPipeWrite,
+			                              processInfo)) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建进程失败！";
+				throw 3;
+			}
+
+			// 关闭本进程中子进程使用的管道端，目标程序结束后监视线程才能读到管道关闭
+			Clhandle_s(outputPipeWrite);
+			Clhandle_s(inputPipeRead);
+			Clhandle_s(inputFileHandle);
+
+			isLaunched = true;
+			m_hProcess = processInfo.hProcess;
+
+			// 启动监视线程
+			ResetEvent(m_hReadDoneEvent);
+			m_checkProcThread = std::thread(&CheckProcThread, this);
+
+			// 写入测试输入，写完后关闭输入管道作为EOF
+			m_inputPipeWrite = inputPipeWrite;
+			inputPipeWrite = INVALID_HANDLE_VALUE;
+			if (!inputstr.empty()) {
+				// 不为空才需要真写入数据，直接从输入文本写入，不复制
+				m_inputCStr = inputstr.c_str();
+				m_inputCStrLen = inputstr.size();
+				// 启动数据写入线程
+				m_WriteStrThread = std::thread(&WriteStrThread, this);
+			} else {
+				Clhandle_s(m_inputPipeWrite);
+			}
+
+			// 需要等待析构标志句柄与进程句柄
+			HANDLE hWaitHandle[2];
+			hWaitHandle[0] = this->m_hExitEvent;
+			hWaitHandle[1] = processInfo.hProcess;
+
+			// 空闲时间限制，上一次检查时的CPU周期计数，最后一次发现活动时的真实时间
+			long long idlelimit = (m_idleLimit > 0) ? m_idleLimit : timelimit;
+			ULONG64 lastCycleTime = 0ull;
+			long long lastActiveTime = 0;
+			// 两次检查之间至少增长1e6个周期才算活动
+			const ULONG64 minDCycleTime = 1000000ull;
+
+			// 最大真实时间花费
+			long long maxRealTimeCost = 40 * timelimit;
+
+			// 绑定CPU
+			if (m_cpuAffinity >= 0) {
+				SetProcessAffinityMask(processInfo.hProcess,
+				                       static_cast<DWORD_PTR>(1) << m_cpuAffinity);
+			}
+
+			// 加入作业对象，作业关闭时结束其中所有进程
+			jobHandle = CreateRunJob(timelimit, jobPort);
+			if (jobHandle != INVALID_HANDLE_VALUE &&
+			    !AssignProcessToJobObject(jobHandle, processInfo.hProcess) && m_memoryLimit > 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "设置内存限制失败！";
+				throw 4;
+			}
+
+			// 继续执行进程
+			ResumeThread(processInfo.hThread);
+
+			// 开始计时
+			auto start = std::chrono::high_resolution_clock::now();
+			m_startTime = std::chrono::steady_clock::now();
+
+			// 开始等待句柄信号，第一次检查在真实时间达到时间限制时
+			long long firstCheck = nextTimeLimitCheck(timelimit, 0, 0, 1);
+			long long firstIdleCheck = nextIdleCheck(idlelimit, 0, 0);
+			DWORD waitTimeout = static_cast<DWORD>((firstIdleCheck < firstCheck) ? firstIdleCheck : firstCheck);
+			while (1) {
+				// 同时等待两个句柄，只要有一个响应就退出阻塞
+				DWORD waitResult = WaitForMultipleObjects(2, hWaitHandle, FALSE, waitTimeout);
+
+				if (m_willExit) {
+					m_verdict = JudgeVerdict::SystemError;
+					errstr = "类正在析构！";
+					throw 4;
+				} else if (waitResult == WAIT_TIMEOUT) {
+					// 获取CPU时间和真实时间花费
+					long long curCPUTime = GetRunCPUTime(processInfo.hProcess, jobHandle);
+					long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+					                    (std::chrono::high_resolution_clock::now() - start).count();
+					// 需要判断是不是真TLE了
+					long long chargedTime = curCPUTime;
+					if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+						chargedTime = elapsed;
+					}
+					timecosted = chargedTime;
+					if (timecosted > timelimit) {
+						m_verdict = JudgeVerdict::TimeLimitExceeded;
+						errstr = "执行超时！";
+						throw 4;
+					}
+					// 判断空闲：所有线程的周期计数之和自上次检查以来几乎没有增长
+					ULONG64 curCycleTime = 0ull;
+					QueryProcessCycleTime(processInfo.hProcess, &curCycleTime);
+					if (curCycleTime - lastCycleTime >= minDCycleTime) {
+						lastActiveTime = elapsed;
+					}
+					lastCycleTime = curCycleTime;
+					if (elapsed - lastActiveTime >= idlelimit) {
+						m_verdict = JudgeVerdict::IdlenessLimitExceeded;
+						errstr = "程序疑似被阻塞，空闲时间超限！";
+						throw 4;
+					}
+					if (elapsed >= timelimit) {
+						timecosted = elapsed;
+						// 判断真实耗时过大的情况，程序没有空闲却得不到CPU，是评测机负载过大而不是程序超时
+						if (timecosted > maxRealTimeCost) {
+							m_verdict = JudgeVerdict::SystemError;
+							m_isOverloaded = true;
+							errstr = "评测机负载过大，执行超时！";
+							throw 4;
+						}
+					}
+					long long nextCheck = nextTimeLimitCheck(timelimit, chargedTime, elapsed, 1);
+					long long idleCheck = nextIdleCheck(idlelimit, lastActiveTime, elapsed);
+					waitTimeout = static_cast<DWORD>((idleCheck < nextCheck) ? idleCheck : nextCheck);
+				} else {
+					// 说明正常退出了
+					break;
+				}
+			}
+
+			// 程序时限内退出
+
+			// 获取时间
+			FILETIME creationTime, exitTime, kernelTime, userTime;
+			GetProcessTimes(processInfo.hProcess, &creationTime, &exitTime,
+			                &kernelTime, &userTime);
+			long long realTimeUsed, CPUTimeUsed;
+			realTimeUsed = fileTime2ms(exitTime) - fileTime2ms(creationTime);
+			if (realTimeUsed < 0) {
+				realTimeUsed = 0;
+			}
+			m_realTimeCosted = realTimeUsed;
+			CPUTimeUsed = GetRunCPUTime(processInfo.hProcess, jobHandle);
+			if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+				timecosted = realTimeUsed;
+			} else {
+				timecosted = CPUTimeUsed;
+			}
+
+			// 获取内存峰值，判断是否内存超限或因CPU时间超限被作业结束
+			m_peakMemory = GetJobPeakMemory(jobHandle);
+			bool isMemoryLimitHit, isTimeLimitHit;
+			GetJobLimitHits(jobPort, isMemoryLimitHit, isTimeLimitHit);
+			if (isMemoryLimitHit) {
+				m_verdict = JudgeVerdict::MemoryLimitExceeded;
+				errstr = "内存超限！";
+				throw 4;
+			}
+			if (isTimeLimitHit || timecosted > timelimit) {
+				m_verdict = JudgeVerdict::TimeLimitExceeded;
+				errstr = "执行超时！";
+				throw 4;
+			}
+
+			// 获取进程退出代码，被监视线程结束的不算运行错误
+			DWORD exeCode;
+			GetExitCodeProcess(processInfo.hProcess, &exeCode);
+			// 被监视线程结束(输出不一致或超限)的与超时一样视为被评测机结束
+			m_exitCode = (m_readerVerdict == JudgeVerdict::None) ? static_cast<int>(exeCode) : 0;
+			if (exeCode != 0 && m_readerVerdict == JudgeVerdict::None) {
+				m_verdict = JudgeVerdict::RuntimeError;
+				errstr = "程序返回值为" + std::to_string(exeCode) + "！";
+				throw 4;
+			}
+
+			// 获取输出
+			isLaunched = false;
+			StopCheckProcThread();
+			if (m_WriteStrThread.joinable()) {
+				m_WriteStrThread.join();
+			}
+			TakeOutput(outputstr);
+
+			// 比较输出的剩余部分
+			if (m_hasExpectedOutput && m_checkerPath.empty() &&
+			    m_readerVerdict == JudgeVerdict::None && !m_comparator.Finish()) {
+				m_readerVerdict = JudgeVerdict::WrongAnswer;
+			}
+
+			// 关闭管道句柄
+			Clhandle_s(inputPipeWrite);
+			Clhandle_s(inputPipeRead);
+			Clhandle_s(m_outputPipeRead);
+			Clhandle_s(outputPipeWrite);
+
+			// 关闭线程句柄
+			Clhandle_s(processInfo.hThread);
+
+			// 关闭进程句柄
+			Clhandle_s(processInfo.hProcess);
+			m_hProcess = INVALID_HANDLE_VALUE;
+
+			// 关闭作业对象，结束残留的子进程
+			Clhandle_s(jobHandle);
+			Clhandle_s(jobPort);
+
+			if (m_readerVerdict == JudgeVerdict::WrongAnswer) {
+				m_verdict = JudgeVerdict::WrongAnswer;
+				m_mismatchOffset = m_comparator.getMismatchOffset();
+				errstr = "答案错误！";
+				return false;
+			} else if (m_readerVerdict == JudgeVerdict::OutputLimitExceeded) {
+				m_verdict = JudgeVerdict::OutputLimitExceeded;
+				errstr = "输出超限！";
+				return false;
+			}
+			if (!m_checkerPath.empty()) {
+				return StoreCachedVerdict(verdictCacheKey, RunChecker(inputstr, outputstr, errstr), timecosted);
+			}
+			m_verdict = JudgeVerdict::Accepted;
+			return StoreCachedVerdict(verdictCacheKey, true, timecosted);
+		} catch (int errid) {
+			switch (errid) {
+				case 4:
+					// 结束进程，关闭作业对象结束残留的子进程，输入管道的读取端随之关闭
+					TerminateProcess(processInfo.hProcess, 1);
+					if (m_realTimeCosted == 0) {
+						m_realTimeCosted = std::chrono::duration_cast<std::chrono::milliseconds>
+						                   (std::chrono::steady_clock::now() - m_startTime).count();
+					}
+					if (m_peakMemory == 0) {
+						m_peakMemory = GetJobPeakMemory(jobHandle);
+					}
+					Clhandle_s(jobHandle);
+					Clhandle_s(jobPort);
+					// 需要处理写入线程
+					if (m_WriteStrThread.joinable()) {
+						// 取消IO请求
+						m_rwProcMutex.lock_shared();
+						if (m_inputPipeWrite != INVALID_HANDLE_VALUE) {
+							CancelIoEx(m_inputPipeWrite, NULL);
+						}
+						m_rwProcMutex.unlock_shared();
+						// 等待线程结束
+						m_WriteStrThread.join();
+					}
+					Clhandle_s(m_inputPipeWrite);
+					// 等待线程
+					isLaunched = false;
+					StopCheckProcThread();
+					// 运行失败时也返回已读取的输出，如编译器的错误信息
+					TakeOutput(outputstr);
+					// 关闭线程句柄
+					Clhandle_s(processInfo.hThread);
+					// 关闭进程句柄
+					Clhandle_s(processInfo.hProcess);
+					m_hProcess = INVALID_HANDLE_VALUE;
+					[[fallthrough]];
+				case 3:
+					// 关闭输出句柄
+					m_rwProcMutex.lock();
+					Clhandle_s(m_outputPipeRead);
+					m_rwProcMutex.unlock();
+					Clhandle_s(outputPipeWrite);
+					break;
+				case 2:
+					// 关闭输出句柄
+					Clhandle_s(m_outputPipeRead);
+					m_rwProcMutex.unlock();
+					Clhandle_s(outputPipeWrite);
+					break;
+			}
+			// 关闭输入句柄
+			Clhandle_s(inputPipeRead);
+			Clhandle_s(inputPipeWrite);
+			Clhandle_s(inputFileHandle);
+			return false;
+		}
+	}
+#else
+	/*
+	 *	启动进程，返回目标程序是否在时限内成功运行
+	 *  输入文本[in]：将压入目标程序输入流的文本，为空则不输入文本，输入完毕后关闭输入流
+	 *  时间限制[in]：单位毫秒
+	 *  输出文本[out]：返回程序输出流中的文本，程序启动后运行失败时为已读取的部分
+	 *  时间花费[out]：返回程序运行消耗的时间，计算方式由setCPUTimePolicy设置
+	 *  错误信息[out]：返回程序运行失败的原因
+	 */
+	bool launchAndWait(const std::string& inputstr, long long timelimit,
+	                   std::string& outputstr, long long& timecosted, std::string& errstr) {
+		// 管道：输入、输出、启动屏障、exec错误回报
+		int inputPipe[2] = { -1, -1 };
+		int outputPipe[2] = { -1, -1 };
+		int barrierPipe[2] = { -1, -1 };
+		int execErrorPipe[2] = { -1, -1 };
+		// 输入文件，没有设置输入文件时不使用
+		int inputFileFd = -1;
+		// 进程信息，进程组与进程号相同
+		pid_t pid = -1;
+		pid_t processGroup = -1;
+		int pidFd = -1;
+		// 检查时间限制的定时器
+		int timerFd = -1;
+		// 本次评测的cgroup目录，为空表示不使用cgroup
+		std::string cgroupPath;
+		// 性能计数器：指令数、任务时钟
+		int perfFds[2] = { -1, -1 };
+		// 重置评测结果和比较状态
+		m_verdict = JudgeVerdict::None;
+		m_mismatchOffset = 0;
+		m_peakMemory = 0;
+		m_realTimeCosted = 0;
+		m_exitCode = 0;
+		m_exitSignal = 0;
+		m_instructionCount = 0;
+		m_taskClockNanoseconds = 0;
+		m_startTime = std::chrono::steady_clock::now();
+		m_readerVerdict = JudgeVerdict::None;
+		m_comparator.Restart();
+		m_checkerMessage.clear();
+		m_isVerdictCached = false;
+		m_isOverloaded = false;
+		timecosted = 0;
+		// 查询评测结果缓存，命中时不运行目标程序
+		std::string verdictCacheKey = GetVerdictCacheKey(inputstr, timelimit);
+		if (LoadCachedVerdict(verdictCacheKey, timelimit, timecosted)) {
+			outputstr.clear();
+			return true;
+		}
+		try {
+			// 设置了输入文件时标准输入直接重定向到文件，不经过管道
+			if (!m_inputFilePath.empty()) {
+				inputFileFd = open(m_inputFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+				if (inputFileFd < 0) {
+					m_verdict = JudgeVerdict::SystemError;
+					errstr = "打开输入文件失败！";
+					throw 1;
+				}
+			}
+
+			// 创建输入管道
+			if (pipe2(inputPipe, O_CLOEXEC) != 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建输入管道失败！";
+				throw 1;
+			}
+
+			// 创建输出管道和停止读取事件
+			if (pipe2(outputPipe, O_CLOEXEC) != 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建输出管道失败！";
+				throw 2;
+			}
+			m_outputPipeRead = outputPipe[0];
+			m_stopReadEventFd = eventfd(0, EFD_CLOEXEC);
+
+			// 创建启动屏障和exec错误回报管道
+			if (pipe2(barrierPipe, O_CLOEXEC) != 0 || pipe2(execErrorPipe, O_CLOEXEC) != 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建进程失败！";
+				throw 3;
+			}
+
+			// CPU时间硬限制，作为超时检测的兜底
+			// 按真实时间计时时，所有CPU同时运行也不会在时间限制内达到该限制
+			// 按指令数计时时CPU时间与时间花费没有固定比例，不设置硬限制，由定时检查和真实时间上限兜底
+			rlimit cpuLimit;
+			cpuLimit.rlim_cur = timelimit / 1000 + 1;
+			if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+				long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+				cpuLimit.rlim_cur = timelimit * (cpuCount > 0 ? cpuCount : 1) / 1000 + 1;
+			}
+			cpuLimit.rlim_max = cpuLimit.rlim_cur + 1;
+			if (m_cpuTimePolicy == CPUTimePolicy::Instructions) {
+				cpuLimit.rlim_cur = RLIM_INFINITY;
+				cpuLimit.rlim_max = RLIM_INFINITY;
+			}
+
+			// fork之后只能调用异步信号安全的函数，所以提前准备好参数
+			const char* programPath = m_programPath.c_str();
+			const char* workingDirectoryPtr = NULL;
+			if (!m_workingDirectory.empty()) {
+				workingDirectoryPtr = m_workingDirectory.c_str();
+			}
+			std::vector<char*> argv = BuildArgv();
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			if (m_cpuAffinity >= 0) {
+				CPU_SET(m_cpuAffinity, &cpuSet);
+			}
+
+			// 创建本次评测的cgroup
+			cgroupPath = CreateCgroup();
+
+			// 创建进程，设置了zygote时使用预先创建的子进程，无法使用时自行fork
+			pid = -1;
+			if (m_zygote != nullptr) {
+				pid = m_zygote->Spawn(argv.data(), programPath, workingDirectoryPtr, cpuLimit, m_cpuAffinity,
+				                      inputFileFd >= 0 ? inputFileFd : inputPipe[0], outputPipe[1],
+				                      barrierPipe[0], execErrorPipe[1]);
+			}
+			if (pid < 0) {
+				pid = fork();
+			}
+			if (pid < 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建进程失败！";
+				throw 3;
+			}
+			if (pid == 0) {
+				// 子进程：关闭父进程使用的屏障和错误回报管道端，否则读不到EOF
+				close(barrierPipe[1]);
+				close(execErrorPipe[0]);
+				// 独立进程组，便于结束整个进程树
+				setpgid(0, 0);
+				ResetChildSignals();
+				dup2(inputFileFd >= 0 ? inputFileFd : inputPipe[0], STDIN_FILENO);
+				dup2(outputPipe[1], STDOUT_FILENO);
+				dup2(outputPipe[1], STDERR_FILENO);
+				if (workingDirectoryPtr != NULL && chdir(workingDirectoryPtr) != 0) {
+					int err = errno;
+					ssize_t ret = write(execErrorPipe[1], &err, sizeof(err));
+					(void)ret;
+					_exit(127);
+				}
+				setrlimit(RLIMIT_CPU, &cpuLimit);
+				if (CPU_COUNT(&cpuSet) > 0) {
+					sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+				}
+				// 等待启动屏障，相当于CREATE_SUSPENDED
+				char barrier;
+				while (read(barrierPipe[0], &barrier, 1) < 0 && errno == EINTR) {
+				}
+				execv(programPath, argv.data());
+				int err = errno;
+				ssize_t ret = write(execErrorPipe[1], &err, sizeof(err));
+				(void)ret;
+				_exit(127);
+			}
+
+			// 父进程：关闭子进程使用的管道端和输入文件
+			Clfd_s(inputPipe[0]);
+			Clfd_s(inputFileFd);
+			Clfd_s(outputPipe[1]);
+			Clfd_s(barrierPipe[0]);
+			Clfd_s(execErrorPipe[1]);
+			setpgid(pid, pid);
+			processGroup = pid;
+			m_processGroup = processGroup;
+
+			// 在exec之前加入cgroup，cgroup不可用时用RLIMIT_AS限制内存
+			if (!cgroupPath.empty() &&
+			    !WriteTextFile(cgroupPath + "/cgroup.procs", std::to_string(pid))) {
+				RemoveCgroup(cgroupPath);
+			}
+			if (cgroupPath.empty() && m_memoryLimit > 0) {
+				rlimit memoryLimit;
+				memoryLimit.rlim_cur = m_memoryLimit;
+				memoryLimit.rlim_max = m_memoryLimit;
+				if (prlimit(pid, RLIMIT_AS, &memoryLimit, NULL) != 0) {
+					m_verdict = JudgeVerdict::SystemError;
+					errstr = "设置内存限制失败！";
+					throw 4;
+				}
+			}
+
+			// 通过pidfd等待进程结束，内核不支持时退化为轮询
+			pidFd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+
+			isLaunched = true;
+
+			// 启动监视线程
+			m_checkProcThread = std::thread(&CheckProcThread, this);
+
+			// 写入测试输入
+			m_inputPipeWrite = inputPipe[1];
+			inputPipe[1] = -1;
+			if (!inputstr.empty()) {
+				// 不为空才需要真写入数据，写完后关闭输入流作为EOF
+				m_inputCStr = inputstr.c_str();
+				m_inputCStrLen = inputstr.size();
+				// 启动数据写入线程
+				m_WriteStrThread = std::thread(&WriteStrThread, this);
+			} else {
+				Clfd_s(m_inputPipeWrite);
+			}
+
+			// 在exec之前打开性能计数器，exec时开始计数
+			if (IsPerfCounterPolicy() || m_isPerfCounterEnabled) {
+				perfFds[0] = OpenPerfCounter(pid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+				perfFds[1] = OpenPerfCounter(pid, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+				if (IsPerfCounterPolicy() &&
+				    perfFds[m_cpuTimePolicy == CPUTimePolicy::Instructions ? 0 : 1] < 0) {
+					m_verdict = JudgeVerdict::SystemError;
+					errstr = "打开性能计数器失败！";
+					throw 4;
+				}
+			}
+
+			// 继续执行进程，等待exec完成
+			// 通过写入而不是关闭来放行，并发fork出的其他子进程可能暂时持有屏障的写入端
+			char barrier = 0;
+			ssize_t barrierLen = write(barrierPipe[1], &barrier, 1);
+			(void)barrierLen;
+			Clfd_s(barrierPipe[1]);
+			int execError = 0;
+			ssize_t errorLen;
+			while ((errorLen = read(execErrorPipe[0], &execError, sizeof(execError))) < 0 &&
+			       errno == EINTR) {
+			}
+			Clfd_s(execErrorPipe[0]);
+			if (errorLen > 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建进程失败！";
+				throw 4;
+			}
+
+			// 创建检查时间限制的定时器
+			timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+			if (timerFd < 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建定时器失败！";
+				throw 4;
+			}
+
+			// 需要等待析构事件、定时器与进程结束，没有pidfd时每10ms检查一次进程是否结束
+			pollfd waitFds[3];
+			waitFds[0].fd = m_exitEventFd;
+			waitFds[0].events = POLLIN;
+			waitFds[1].fd = timerFd;
+			waitFds[1].events = POLLIN;
+			waitFds[2].fd = pidFd;
+			waitFds[2].events = POLLIN;
+			nfds_t waitFdCnt = (pidFd >= 0) ? 3 : 2;
+			int pollTimeout = (pidFd >= 0) ? -1 : 10;
+
+			// 空闲时间限制，上一次检查时的CPU时间和线程运行时间，最后一次发现活动时的真实时间
+			long long idlelimit = (m_idleLimit > 0) ? m_idleLimit : timelimit;
+			long long lastCPUTime = 0;
+			unsigned long long lastRunTime = 0;
+			long long lastActiveTime = 0;
+			// 两次检查之间CPU时间至少增长1ms(线程运行时间1e6纳秒)才算活动
+			const long long minDCPUTime = 1;
+			const unsigned long long minDRunTime = 1000000ull;
+
+			// 最大真实时间花费
+			long long maxRealTimeCost = 40 * timelimit;
+
+			// 开始计时，第一次检查在真实时间达到时间限制时
+			auto start = std::chrono::steady_clock::now();
+			m_startTime = start;
+			long long firstCheck = nextTimeLimitCheck(timelimit, 0, 0, 1);
+			long long firstIdleCheck = nextIdleCheck(idlelimit, 0, 0);
+			ArmTimer(timerFd, (firstIdleCheck < firstCheck) ? firstIdleCheck : firstCheck);
+
+			// 开始等待信号
+			while (1) {
+				// 同时等待析构事件、定时器和进程结束，只要有一个响应就退出阻塞
+				int pollResult = poll(waitFds, waitFdCnt, pollTimeout);
+				if (pollResult < 0 && errno == EINTR) {
+					continue;
+				}
+
+				if (m_willExit) {
+					m_verdict = JudgeVerdict::SystemError;
+					errstr = "类正在析构！";
+					throw 4;
+				} else if (pidFd >= 0 ? (waitFds[2].revents & POLLIN) : IsProcessExited(pid)) {
+					// 说明正常退出了
+					break;
+				} else if (pollResult > 0 && (waitFds[1].revents & POLLIN)) {
+					uint64_t expirations;
+					ssize_t ret = read(timerFd, &expirations, sizeof(expirations));
+					(void)ret;
+					// 获取CPU时间和真实时间花费
+					long long curCPUTime = GetRunCPUTime(pid, cgroupPath);
+					long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+					                    (std::chrono::steady_clock::now() - start).count();
+					// 需要判断是不是真TLE了
+					long long chargedTime = curCPUTime;
+					long long threadCount = GetProcessThreadCount(pid);
+					if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+						chargedTime = elapsed;
+						threadCount = 1;
+					} else if (IsPerfCounterPolicy()) {
+						ReadPerfCounters(perfFds);
+						chargedTime = GetPerfChargedTime();
+					}
+					timecosted = chargedTime;
+					if (timecosted > timelimit) {
+						m_verdict = JudgeVerdict::TimeLimitExceeded;
+						errstr = "执行超时！";
+						throw 4;
+					}
+					// 判断空闲：此刻没有线程可运行，且自上次检查以来运行时间几乎没有增长
+					// 计入子进程时cgroup的CPU时间增长也算活动
+					unsigned long long curRunTime = 0;
+					bool isRunnable = GetProcessSchedState(pid, curRunTime);
+					if (isRunnable || curRunTime < lastRunTime || curRunTime - lastRunTime >= minDRunTime ||
+					    curCPUTime - lastCPUTime >= minDCPUTime) {
+						lastActiveTime = elapsed;
+					}
+					lastRunTime = curRunTime;
+					lastCPUTime = curCPUTime;
+					if (elapsed - lastActiveTime >= idlelimit) {
+						m_verdict = JudgeVerdict::IdlenessLimitExceeded;
+						errstr = "程序疑似被阻塞，空闲时间超限！";
+						throw 4;
+					}
+					if (elapsed >= timelimit) {
+						timecosted = elapsed;
+						// 判断真实耗时过大的情况，程序没有空闲却得不到CPU，是评测机负载过大而不是程序超时
+						if (timecosted > maxRealTimeCost) {
+							m_verdict = JudgeVerdict::SystemError;
+							m_isOverloaded = true;
+							errstr = "评测机负载过大，执行超时！";
+							throw 4;
+						}
+					}
+					long long nextCheck = nextTimeLimitCheck(timelimit, chargedTime, elapsed, threadCount);
+					long long idleCheck = nextIdleCheck(idlelimit, lastActiveTime, elapsed);
+					ArmTimer(timerFd, (idleCheck < nextCheck) ? idleCheck : nextCheck);
+				}
+			}
+
+			// 程序时限内退出
+
+			// 回收进程，获取时间
+			int status = 0;
+			rusage usage;
+			while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+			}
+			pid = -1;
+			long long realTimeUsed, CPUTimeUsed;
+			realTimeUsed = std::chrono::duration_cast<std::chrono::milliseconds>
+			               (std::chrono::steady_clock::now() - start).count();
+			m_realTimeCosted = realTimeUsed;
+			m_exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 0;
+			m_exitSignal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+			// 被监视线程结束(输出不一致或超限)的与超时一样视为被评测机结束
+			if (m_readerVerdict != JudgeVerdict::None) {
+				m_exitCode = 0;
+				m_exitSignal = 0;
+			}
+			// rusage已包含目标程序回收过的子进程，cgroup还包含未回收的子进程
+			CPUTimeUsed = timeval2ms(usage.ru_utime) + timeval2ms(usage.ru_stime);
+			if (m_isChildProcessCounted && !cgroupPath.empty()) {
+				long long cgroupCPUTime = GetRunCPUTime(-1, cgroupPath);
+				if (cgroupCPUTime > CPUTimeUsed) {
+					CPUTimeUsed = cgroupCPUTime;
+				}
+			}
+			ReadPerfCounters(perfFds);
+			Clfd_s(perfFds[0]);
+			Clfd_s(perfFds[1]);
+			if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+				timecosted = realTimeUsed;
+			} else if (IsPerfCounterPolicy()) {
+				timecosted = GetPerfChargedTime();
 			} else {
 				timecosted = CPUTimeUsed;
 			}
 
-			// 获取进程退出代码
-			DWORD exeCode;
-			GetExitCodeProcess(processInfo.hProcess, &exeCode);
-			if (exeCode != 0) {
-				errstr = "程序返回值为" + std::to_string(exeCode) + "！";
-				throw 4;
+			// 获取内存峰值，判断是否内存超限
+			bool isMemoryLimitExceeded = false;
+			if (!cgroupPath.empty()) {
+				m_peakMemory = GetCgroupPeakMemory(cgroupPath);
+				isMemoryLimitExceeded = IsCgroupOOMKilled(cgroupPath);
+			}
+			if (m_peakMemory == 0) {
+				m_peakMemory = static_cast<size_t>(usage.ru_maxrss) * 1024;
+			}
+
+			// 获取进程退出代码，被监视线程结束的不算运行错误
+			if (m_readerVerdict == JudgeVerdict::None) {
+				if (isMemoryLimitExceeded) {
+					m_verdict = JudgeVerdict::MemoryLimitExceeded;
+					errstr = "内存超限！";
+					throw 5;
+				}
+				if (timecosted > timelimit || (WIFSIGNALED(status) && WTERMSIG(status) == SIGXCPU)) {
+					m_verdict = JudgeVerdict::TimeLimitExceeded;
+					errstr = "执行超时！";
+					throw 5;
+				}
+				if (WIFSIGNALED(status)) {
+					m_verdict = JudgeVerdict::RuntimeError;
+					errstr = "程序被信号" + std::to_string(WTERMSIG(status)) + "终止！";
+					throw 5;
+				}
+				if (WEXITSTATUS(status) != 0) {
+					m_verdict = JudgeVerdict::RuntimeError;
+					errstr = "程序返回值为" + std::to_string(WEXITSTATUS(status)) + "！";
+					throw 5;
+				}
 			}
 
 			// 获取输出
 			isLaunched = false;
+			// 结束残留的进程组和cgroup，然后通知监视线程取出剩余输出
+			kill(-processGroup, SIGKILL);
+			RemoveCgroup(cgroupPath);
+			NotifyEventFd(m_stopReadEventFd);
 			m_checkProcThread.join();
-			m_WriteStrThread.join();
-			outputstr = m_output;
-			m_output = "";
+			if (m_WriteStrThread.joinable()) {
+				m_WriteStrThread.join();
+			}
+			TakeOutput(outputstr);
+			m_processGroup = -1;
 
-			// 关闭管道句柄
-			Clhandle_s(inputPipeWrite);
-			Clhandle_s(inputPipeRead);
-			Clhandle_s(m_outputPipeRead);
-			Clhandle_s(outputPipeWrite);
+			// 比较输出的剩余部分
+			if (m_hasExpectedOutput && m_checkerPath.empty() &&
+			    m_readerVerdict == JudgeVerdict::None && !m_comparator.Finish()) {
+				m_readerVerdict = JudgeVerdict::WrongAnswer;
+			}
 
-			// 关闭线程句柄
-			Clhandle_s(processInfo.hThread);
+			// 关闭管道
+			Clfd_s(m_inputPipeWrite);
+			Clfd_s(m_outputPipeRead);
+			Clfd_s(m_stopReadEventFd);
+			Clfd_s(pidFd);
+			Clfd_s(timerFd);
 
-			// 关闭进程句柄
-			Clhandle_s(processInfo.hProcess);
-			return true;
+			if (m_readerVerdict == JudgeVerdict::WrongAnswer) {
+				m_verdict = JudgeVerdict::WrongAnswer;
+				m_mismatchOffset = m_comparator.getMismatchOffset();
+				errstr = "答案错误！";
+				return false;
+			} else if (m_readerVerdict == JudgeVerdict::OutputLimitExceeded) {
+				m_verdict = JudgeVerdict::OutputLimitExceeded;
+				errstr = "输出超限！";
+				return false;
+			}
+			if (!m_checkerPath.empty()) {
+				return StoreCachedVerdict(verdictCacheKey, RunChecker(inputstr, outputstr, errstr), timecosted);
+			}
+			m_verdict = JudgeVerdict::Accepted;
+			return StoreCachedVerdict(verdictCacheKey, true, timecosted);
 		} catch (int errid) {
 			switch (errid) {
 				case 4:
-					// 需要处理写入线程
-					if (!inputstr.empty()) {
-						// 取消IO请求
-						CancelIoEx(m_inputPipeWrite, NULL);
-						// 等待线程结束
+				case 5:
+					if (m_realTimeCosted == 0) {
+						m_realTimeCosted = std::chrono::duration_cast<std::chrono::milliseconds>
+						                   (std::chrono::steady_clock::now() - m_startTime).count();
+					}
+					// 结束进程组，目标程序的输入管道随之关闭，写入线程得以退出
+					if (processGroup > 0) {
+						kill(-processGroup, SIGKILL);
+					}
+					if (pid > 0) {
+						kill(pid, SIGKILL);
+						while (waitpid(pid, NULL, 0) < 0 && errno == EINTR) {
+						}
+					}
+					if (m_WriteStrThread.joinable()) {
 						m_WriteStrThread.join();
 					}
-					// 结束进程
-					TerminateProcess(processInfo.hProcess, 1);
-					// 等待线程
+					Clfd_s(m_inputPipeWrite);
+					// 等待线程，设置资源限制失败时监视线程尚未启动
 					isLaunched = false;
-					m_checkProcThread.join();
-					// 关闭线程句柄
-					Clhandle_s(processInfo.hThread);
-					// 关闭进程句柄
-					Clhandle_s(processInfo.hProcess);
+					NotifyEventFd(m_stopReadEventFd);
+					if (m_checkProcThread.joinable()) {
+						m_checkProcThread.join();
+					}
+					// 运行失败时也返回已读取的输出，如编译器的错误信息
+					TakeOutput(outputstr);
+					m_processGroup = -1;
+					Clfd_s(pidFd);
+					Clfd_s(timerFd);
+					[[fallthrough]];
 				case 3:
-					// 关闭输出句柄
-					m_rwProcMutex.lock();
-					Clhandle_s(m_outputPipeRead);
-					m_rwProcMutex.unlock();
-					Clhandle_s(outputPipeWrite);
-					break;
 				case 2:
-					// 关闭输出句柄
-					Clhandle_s(m_outputPipeRead);
-					m_rwProcMutex.unlock();
-					Clhandle_s(outputPipeWrite);
+					// 关闭输出管道
+					Clfd_s(m_outputPipeRead);
+					Clfd_s(outputPipe[1]);
+					Clfd_s(m_stopReadEventFd);
+					Clfd_s(barrierPipe[0]);
+					Clfd_s(barrierPipe[1]);
+					Clfd_s(execErrorPipe[0]);
+					Clfd_s(execErrorPipe[1]);
+					RemoveCgroup(cgroupPath);
 					break;
 			}
-			// 关闭输入句柄
-			Clhandle_s(inputPipeRead);
-			Clhandle_s(inputPipeWrite);
+			// 关闭输入管道和输入文件，读取被结束前的性能计数器
+			Clfd_s(inputPipe[0]);
+			Clfd_s(inputPipe[1]);
+			Clfd_s(inputFileFd);
+			ReadPerfCounters(perfFds);
+			Clfd_s(perfFds[0]);
+			Clfd_s(perfFds[1]);
+			return false;
+		}
+	}
+#endif
+
+	/*
+	 *	启动进程，以文件作为目标程序的标准输入，返回目标程序是否在时限内成功运行
+	 *  标准输入直接重定向到文件，不读入内存也不经过管道，读到文件末尾即为EOF，适合大数据和二进制输入
+	 *  设置了检查器时直接把该文件传给检查器
+	 *  输入文件路径[in]：测试数据文件
+	 *  其他参数与launchAndWait相同
+	 */
+	bool launchAndWaitFile(const std::string& inputPath, long long timelimit,
+	                       std::string& outputstr, long long& timecosted, std::string& errstr) {
+		m_inputFilePath = inputPath;
+		bool isSucceeded = launchAndWait("", timelimit, outputstr, timecosted, errstr);
+		m_inputFilePath.clear();
+		return isSucceeded;
+	}
+
+#ifdef _WIN32
+	/*
+	 *  评测交互题，返回目标程序是否成功运行且交互器判定正确
+	 *  交互器的标准输出连接目标程序的标准输入，目标程序的标准输出连接交互器的标准输入
+	 *  交互器的命令行为：交互器 输入文件 输出文件 标准答案文件，与testlib相同
+	 *  交互器的退出代码按checkerExitCodeToVerdict转换，标准错误作为检查器信息
+	 *  设置了检查器时，交互器判定正确后再用检查器检查交互器写入输出文件的内容
+	 *  两个进程的CPU时间分别计算，目标程序的时间、内存限制和CPU绑定与launchAndWait相同
+	 *  目标程序和交互器都没有活动的时间超过空闲时间限制时结果为IdlenessLimitExceeded，等待交互器运行的时间不算空闲
+	 *  交互器先于目标程序结束且判定不正确时以交互器的结果为准，否则目标程序的超时、内存超限和运行错误优先
+	 *  交互器路径[in]：可执行文件路径
+	 *  输入文本[in]：写入交互器的输入文件
+	 *  时间限制[in]：目标程序的时间限制，单位毫秒
+	 *  交互器时间限制[in]：交互器的CPU时间限制，单位毫秒，目标程序结束后也用于限制等待交互器的真实时间
+	 *  时间花费[out]：返回目标程序运行消耗的时间，计算方式由setCPUTimePolicy设置
+	 *  错误信息[out]：返回评测失败的原因
+	 */
+	bool launchInteractive(const std::string& interactorPath, const std::string& inputstr,
+	                       long long timelimit, long long interactorTimeLimit,
+	                       long long& timecosted, std::string& errstr) {
+		// 管道：交互器到目标程序、目标程序到交互器，四个端都交给子进程，本进程创建后即关闭
+		// 句柄可继承，但每个进程只通过句柄列表继承自己的三个标准句柄
+		SECURITY_ATTRIBUTES securityAttributes;
+		securityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+		securityAttributes.bInheritHandle = TRUE;
+		securityAttributes.lpSecurityDescriptor = NULL;
+		HANDLE toSolutionRead = INVALID_HANDLE_VALUE;
+		HANDLE toSolutionWrite = INVALID_HANDLE_VALUE;
+		HANDLE toInteractorRead = INVALID_HANDLE_VALUE;
+		HANDLE toInteractorWrite = INVALID_HANDLE_VALUE;
+		// 交互器的输入、输出、标准答案和信息文件，需要删除的临时文件记录在tempPaths中
+		std::string inputPath = WriteTempFile(inputstr);
+		std::string outputPath = CreateTempFile();
+		std::string answerPath = m_expectedOutputPath;
+		std::string messagePath = CreateTempFile();
+		std::string tempPaths[] = { inputPath, outputPath, "", messagePath };
+		if (answerPath.empty()) {
+			answerPath = WriteTempFile(m_comparator.getExpected());
+			tempPaths[2] = answerPath;
+		}
+		HANDLE messageHandle = INVALID_HANDLE_VALUE;
+		HANDLE nullHandle = INVALID_HANDLE_VALUE;
+		// 两个进程的信息和作业对象
+		PROCESS_INFORMATION solutionInfo;
+		PROCESS_INFORMATION interactorInfo;
+		ZeroMemory(&solutionInfo, sizeof(solutionInfo));
+		ZeroMemory(&interactorInfo, sizeof(interactorInfo));
+		HANDLE solutionJob = INVALID_HANDLE_VALUE;
+		HANDLE solutionJobPort = INVALID_HANDLE_VALUE;
+		HANDLE interactorJob = INVALID_HANDLE_VALUE;
+		// 两个进程的结束状态
+		bool isSolutionExited = false;
+		bool isInteractorExited = false;
+		bool isInteractorFirst = false;
+		DWORD solutionExitCode = 0;
+		DWORD interactorExitCode = 0;
+		// 超时情况
+		bool isSolutionTimeout = false;
+		bool isSolutionBlocked = false;
+		bool isInteractorTimeout = false;
+		// 目标程序结束时的真实时间，用于限制等待交互器的时间
+		long long solutionExitTime = 0;
+		// 重置评测结果
+		m_verdict = JudgeVerdict::None;
+		m_mismatchOffset = 0;
+		m_peakMemory = 0;
+		m_realTimeCosted = 0;
+		m_exitCode = 0;
+		m_startTime = std::chrono::steady_clock::now();
+		m_checkerMessage.clear();
+		m_isVerdictCached = false;
+		m_isOverloaded = false;
+		timecosted = 0;
+		try {
+			// 创建管道
+			if (!CreatePipe(&toSolutionRead, &toSolutionWrite, &securityAttributes,
+			                m_outputPipeSize) ||
+			    !CreatePipe(&toInteractorRead, &toInteractorWrite, &securityAttributes,
+			                m_outputPipeSize)) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建管道失败！";
+				throw 1;
+			}
+
+			// 打开交互器信息文件和目标程序的标准错误
+			if (!messagePath.empty()) {
+				messageHandle = CreateFileA(messagePath.c_str(), GENERIC_WRITE,
+				                            FILE_SHARE_READ | FILE_SHARE_WRITE, &securityAttributes,
+				                            CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+			}
+			nullHandle = CreateFileA("NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+			                         &securityAttributes, OPEN_EXISTING, 0, NULL);
+			if (inputPath.empty() || outputPath.empty() || answerPath.empty() ||
+			    messageHandle == INVALID_HANDLE_VALUE || nullHandle == INVALID_HANDLE_VALUE) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建交互文件失败！";
+				throw 1;
+			}
+
+			// 创建交互器，CPU时间超过限制时由作业结束
+			std::string interactorCommandLine = "\"" + interactorPath + "\" \"" + inputPath +
+			                                    "\" \"" + outputPath + "\" \"" + answerPath + "\"";
+			if (!CreateProcessWithHandles(interactorCommandLine, NULL,
+			                              CREATE_NO_WINDOW | CREATE_SUSPENDED, toInteractorRead,
+			                              toSolutionWrite, messageHandle, interactorInfo)) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建交互器进程失败！";
+				throw 1;
+			}
+			interactorJob = CreateJobObject(NULL, NULL);
+			if (interactorJob == NULL) {
+				interactorJob = INVALID_HANDLE_VALUE;
+			} else {
+				JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobLimit;
+				ZeroMemory(&jobLimit, sizeof(jobLimit));
+				jobLimit.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE |
+				                                            JOB_OBJECT_LIMIT_PROCESS_TIME;
+				jobLimit.BasicLimitInformation.PerProcessUserTimeLimit.QuadPart =
+					interactorTimeLimit * 10000;
+				SetInformationJobObject(interactorJob, JobObjectExtendedLimitInformation,
+				                        &jobLimit, sizeof(jobLimit));
+				AssignProcessToJobObject(interactorJob, interactorInfo.hProcess);
+			}
+
+			// 创建目标程序，限制与launchAndWait相同
+			const char* workingDirectoryPtr = NULL;
+			if (!m_workingDirectory.empty()) {
+				workingDirectoryPtr = m_workingDirectory.c_str();
+			}
+			if (!CreateProcessWithHandles(BuildCommandLine(), workingDirectoryPtr,
+			                              CREATE_NO_WINDOW | CREATE_SUSPENDED, toSolutionRead,
+			                              toInteractorWrite, nullHandle, solutionInfo)) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建进程失败！";
+				throw 1;
+			}
+			if (m_cpuAffinity >= 0) {
+				SetProcessAffinityMask(solutionInfo.hProcess,
+				                       static_cast<DWORD_PTR>(1) << m_cpuAffinity);
+			}
+			solutionJob = CreateRunJob(timelimit, solutionJobPort);
+			if (solutionJob != INVALID_HANDLE_VALUE &&
+			    !AssignProcessToJobObject(solutionJob, solutionInfo.hProcess) && m_memoryLimit > 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "设置内存限制失败！";
+				throw 1;
+			}
+
+			// 关闭本进程中的管道端，一方结束后另一方才能读到管道关闭
+			Clhandle_s(toSolutionRead);
+			Clhandle_s(toSolutionWrite);
+			Clhandle_s(toInteractorRead);
+			Clhandle_s(toInteractorWrite);
+			isLaunched = true;
+
+			// 继续执行两个进程，开始计时
+			ResumeThread(interactorInfo.hThread);
+			ResumeThread(solutionInfo.hThread);
+
+			// 空闲时间限制，上一次检查时两个进程的CPU周期计数，最后一次发现活动时的真实时间
+			// 目标程序等待交互器的管道时交互器在运行，所以两个进程都没有活动才算目标程序空闲
+			long long idlelimit = (m_idleLimit > 0) ? m_idleLimit : timelimit;
+			ULONG64 lastSolutionCycleTime = 0ull;
+			ULONG64 lastInteractorCycleTime = 0ull;
+			long long lastActiveTime = 0;
+			const ULONG64 minDCycleTime = 1000000ull;
+
+			// 最大真实时间花费
+			long long maxRealTimeCost = 40 * timelimit;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			m_startTime = std::chrono::steady_clock::now();
+			while (1) {
+				long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+				                    (std::chrono::high_resolution_clock::now() - start).count();
+				// 记录已经结束的进程
+				if (!isSolutionExited &&
+				    WaitForSingleObject(solutionInfo.hProcess, 0) == WAIT_OBJECT_0) {
+					GetExitCodeProcess(solutionInfo.hProcess, &solutionExitCode);
+					isSolutionExited = true;
+					solutionExitTime = elapsed;
+				}
+				if (!isInteractorExited &&
+				    WaitForSingleObject(interactorInfo.hProcess, 0) == WAIT_OBJECT_0) {
+					GetExitCodeProcess(interactorInfo.hProcess, &interactorExitCode);
+					isInteractorExited = true;
+					isInteractorFirst = !isSolutionExited;
+					// 交互器已经判定不正确，不必再等待目标程序
+					if (isInteractorFirst &&
+					    checkerExitCodeToVerdict(static_cast<int>(interactorExitCode)) !=
+					    JudgeVerdict::Accepted) {
+						break;
+					}
+				}
+				if (isSolutionExited && isInteractorExited) {
+					break;
+				}
+				if (m_willExit) {
+					m_verdict = JudgeVerdict::SystemError;
+					errstr = "类正在析构！";
+					throw 1;
+				}
+
+				// 分别检查两个进程的时间，计算距下一次检查的时间
+				long long waitTime = 100;
+				if (!isSolutionExited) {
+					long long chargedTime = GetRunCPUTime(solutionInfo.hProcess, solutionJob);
+					if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+						chargedTime = elapsed;
+					}
+					timecosted = chargedTime;
+					if (chargedTime > timelimit) {
+						isSolutionTimeout = true;
+						break;
+					}
+					// 判断空闲：两个进程的周期计数之和自上次检查以来都几乎没有增长
+					ULONG64 solutionCycleTime = 0ull;
+					ULONG64 interactorCycleTime = 0ull;
+					QueryProcessCycleTime(solutionInfo.hProcess, &solutionCycleTime);
+					if (!isInteractorExited) {
+						QueryProcessCycleTime(interactorInfo.hProcess, &interactorCycleTime);
+					}
+					if (solutionCycleTime - lastSolutionCycleTime >= minDCycleTime ||
+					    interactorCycleTime - lastInteractorCycleTime >= minDCycleTime) {
+						lastActiveTime = elapsed;
+					}
+					lastSolutionCycleTime = solutionCycleTime;
+					lastInteractorCycleTime = interactorCycleTime;
+					if (elapsed - lastActiveTime >= idlelimit) {
+						isSolutionBlocked = true;
+						break;
+					}
+					// 没有空闲却得不到CPU，是评测机负载过大而不是程序超时
+					if (elapsed > maxRealTimeCost) {
+						m_verdict = JudgeVerdict::SystemError;
+						m_isOverloaded = true;
+						errstr = "评测机负载过大，执行超时！";
+						throw 1;
+					}
+					waitTime = nextTimeLimitCheck(timelimit, chargedTime, elapsed, 1);
+					long long idleCheck = nextIdleCheck(idlelimit, lastActiveTime, elapsed);
+					if (waitTime > idleCheck) {
+						waitTime = idleCheck;
+					}
+				}
+				if (!isInteractorExited) {
+					long long interactorCPUTime = GetRunCPUTime(interactorInfo.hProcess,
+					                                            INVALID_HANDLE_VALUE);
+					long long interactorWaitTime = isSolutionExited ? elapsed - solutionExitTime : 0;
+					if (interactorCPUTime > interactorTimeLimit ||
+					    interactorWaitTime > interactorTimeLimit) {
+						isInteractorTimeout = true;
+						break;
+					}
+					long long interactorCheck = nextTimeLimitCheck(interactorTimeLimit,
+					                                               interactorCPUTime, 0, 1);
+					if (isSolutionExited &&
+					    interactorCheck > interactorTimeLimit - interactorWaitTime + 1) {
+						interactorCheck = interactorTimeLimit - interactorWaitTime + 1;
+					}
+					if (waitTime > interactorCheck) {
+						waitTime = interactorCheck;
+					}
+				}
+
+				// 等待析构事件和尚未结束的进程
+				HANDLE hWaitHandle[3];
+				DWORD waitHandleCnt = 0;
+				hWaitHandle[waitHandleCnt++] = this->m_hExitEvent;
+				if (!isSolutionExited) {
+					hWaitHandle[waitHandleCnt++] = solutionInfo.hProcess;
+				}
+				if (!isInteractorExited) {
+					hWaitHandle[waitHandleCnt++] = interactorInfo.hProcess;
+				}
+				WaitForMultipleObjects(waitHandleCnt, hWaitHandle, FALSE,
+				                       static_cast<DWORD>(waitTime));
+			}
+		} catch (int) {
+			// 错误信息已经设置，结束进程后返回
+		}
+
+		// 目标程序正常结束时按结束状态计算时间，获取内存峰值和作业通知
+		m_realTimeCosted = std::chrono::duration_cast<std::chrono::milliseconds>
+		                   (std::chrono::steady_clock::now() - m_startTime).count();
+		if (isSolutionExited) {
+			m_realTimeCosted = solutionExitTime;
+			m_exitCode = static_cast<int>(solutionExitCode);
+			if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+				timecosted = solutionExitTime;
+			} else {
+				timecosted = GetRunCPUTime(solutionInfo.hProcess, solutionJob);
+			}
+		}
+		m_peakMemory = GetJobPeakMemory(solutionJob);
+		bool isMemoryLimitHit, isTimeLimitHit;
+		GetJobLimitHits(solutionJobPort, isMemoryLimitHit, isTimeLimitHit);
+
+		// 结束两个进程，关闭作业对象时结束残留的子进程
+		if (solutionInfo.hProcess != NULL) {
+			TerminateProcess(solutionInfo.hProcess, 1);
+			WaitForSingleObject(solutionInfo.hProcess, INFINITE);
+		}
+		if (interactorInfo.hProcess != NULL) {
+			TerminateProcess(interactorInfo.hProcess, 1);
+			WaitForSingleObject(interactorInfo.hProcess, INFINITE);
+		}
+		isLaunched = false;
+		Clhandle_s(solutionJob);
+		Clhandle_s(solutionJobPort);
+		Clhandle_s(interactorJob);
+		if (solutionInfo.hProcess != NULL) {
+			Clhandle_s(solutionInfo.hThread);
+			Clhandle_s(solutionInfo.hProcess);
+		}
+		if (interactorInfo.hProcess != NULL) {
+			Clhandle_s(interactorInfo.hThread);
+			Clhandle_s(interactorInfo.hProcess);
+		}
+		Clhandle_s(toSolutionRead);
+		Clhandle_s(toSolutionWrite);
+		Clhandle_s(toInteractorRead);
+		Clhandle_s(toInteractorWrite);
+		Clhandle_s(messageHandle);
+		Clhandle_s(nullHandle);
+
+		// 取出交互器信息和输出文件的内容，删除临时文件
+		std::string interactorOutput;
+		if (!messagePath.empty()) {
+			std::ifstream messageFile(messagePath, std::ios::binary);
+			std::ostringstream message;
+			message << messageFile.rdbuf();
+			m_checkerMessage = message.str();
+		}
+		if (!outputPath.empty()) {
+			std::ifstream outputFile(outputPath, std::ios::binary);
+			std::ostringstream output;
+			output << outputFile.rdbuf();
+			interactorOutput = output.str();
+		}
+		for (const std::string& tempPath : tempPaths) {
+			if (!tempPath.empty()) {
+				DeleteFileA(tempPath.c_str());
+			}
+		}
+		if (m_verdict == JudgeVerdict::SystemError) {
+			return false;
+		}
+
+		// 判定结果：先结束的交互器给出的不正确结果优先，其次是目标程序的错误
+		JudgeVerdict interactorVerdict = JudgeVerdict::SystemError;
+		if (isInteractorExited) {
+			interactorVerdict = checkerExitCodeToVerdict(static_cast<int>(interactorExitCode));
+		}
+		errstr = "交互器运行失败！";
+		if (isInteractorFirst && interactorVerdict != JudgeVerdict::Accepted) {
+			return SetCheckerVerdict(interactorVerdict, errstr);
+		}
+		if (isMemoryLimitHit) {
+			m_verdict = JudgeVerdict::MemoryLimitExceeded;
+			errstr = "内存超限！";
+			return false;
+		}
+		if (isSolutionBlocked && !isTimeLimitHit && timecosted <= timelimit) {
+			m_verdict = JudgeVerdict::IdlenessLimitExceeded;
+			errstr = "程序疑似被阻塞，空闲时间超限！";
+			return false;
+		}
+		if (isSolutionTimeout || isTimeLimitHit || timecosted > timelimit) {
+			m_verdict = JudgeVerdict::TimeLimitExceeded;
+			errstr = "执行超时！";
+			return false;
+		}
+		if (isInteractorTimeout) {
+			m_verdict = JudgeVerdict::SystemError;
+			errstr = "交互器运行超时！";
+			return false;
+		}
+		if (solutionExitCode != 0) {
+			m_verdict = JudgeVerdict::RuntimeError;
+			errstr = "程序返回值为" + std::to_string(solutionExitCode) + "！";
+			return false;
+		}
+		if (interactorVerdict != JudgeVerdict::Accepted) {
+			return SetCheckerVerdict(interactorVerdict, errstr);
+		}
+		if (!m_checkerPath.empty()) {
+			return RunChecker(inputstr, interactorOutput, errstr);
+		}
+		m_verdict = JudgeVerdict::Accepted;
+		errstr.clear();
+		return true;
+	}
+#else
+	/*
+	 *  评测交互题，返回目标程序是否成功运行且交互器判定正确
+	 *  交互器的标准输出连接目标程序的标准输入，目标程序的标准输出连接交互器的标准输入
+	 *  交互器的命令行为：交互器 输入文件 输出文件 标准答案文件，与testlib相同
+	 *  交互器的退出代码按checkerExitCodeToVerdict转换，标准错误作为检查器信息
+	 *  设置了检查器时，交互器判定正确后再用检查器检查交互器写入输出文件的内容
+	 *  两个进程的CPU时间分别计算，目标程序的时间、内存限制和CPU绑定与launchAndWait相同
+	 *  目标程序和交互器都没有活动的时间超过空闲时间限制时结果为IdlenessLimitExceeded，等待交互器运行的时间不算空闲
+	 *  交互器先于目标程序结束且判定不正确时以交互器的结果为准，否则目标程序的超时、内存超限和运行错误优先
+	 *  交互器路径[in]：可执行文件路径
+	 *  输入文本[in]：写入交互器的输入文件
+	 *  时间限制[in]：目标程序的时间限制，单位毫秒
+	 *  交互器时间限制[in]：交互器的CPU时间限制，单位毫秒，目标程序结束后也用于限制等待交互器的真实时间
+	 *  时间花费[out]：返回目标程序运行消耗的时间，计算方式由setCPUTimePolicy设置
+	 *  错误信息[out]：返回评测失败的原因
+	 */
+	bool launchInteractive(const std::string& interactorPath, const std::string& inputstr,
+	                       long long timelimit, long long interactorTimeLimit,
+	                       long long& timecosted, std::string& errstr) {
+		// 管道：交互器到目标程序、目标程序到交互器
+		int toSolutionPipe[2] = { -1, -1 };
+		int toInteractorPipe[2] = { -1, -1 };
+		// 交互器的输入、输出、标准答案和信息文件，目标程序的标准错误
+		int interactorFds[4] = { -1, -1, -1, -1 };
+		int nullFd = -1;
+		// 两个进程的进程号(与进程组相同)和pidfd
+		pid_t solutionPid = -1;
+		pid_t interactorPid = -1;
+		int solutionPidFd = -1;
+		int interactorPidFd = -1;
+		// 目标程序的cgroup目录，为空表示不使用cgroup
+		std::string cgroupPath;
+		// 两个进程的结束状态
+		bool isSolutionExited = false;
+		bool isInteractorExited = false;
+		bool isInteractorFirst = false;
+		int solutionStatus = 0;
+		int interactorStatus = 0;
+		rusage solutionUsage = rusage();
+		// 目标程序结束时的真实时间，用于限制等待交互器的时间
+		long long solutionExitTime = 0;
+		// 超时情况
+		bool isSolutionTimeout = false;
+		bool isSolutionBlocked = false;
+		bool isInteractorTimeout = false;
+		// 重置评测结果
+		m_verdict = JudgeVerdict::None;
+		m_mismatchOffset = 0;
+		m_peakMemory = 0;
+		m_realTimeCosted = 0;
+		m_exitCode = 0;
+		m_exitSignal = 0;
+		m_startTime = std::chrono::steady_clock::now();
+		m_checkerMessage.clear();
+		m_isVerdictCached = false;
+		m_isOverloaded = false;
+		timecosted = 0;
+		try {
+			// 创建管道，两端都带CLOEXEC，只有重定向后的副本被子进程继承
+			if (pipe2(toSolutionPipe, O_CLOEXEC) != 0 || pipe2(toInteractorPipe, O_CLOEXEC) != 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建管道失败！";
+				throw 1;
+			}
+
+			// 准备交互器的文件
+			nullFd = open("/dev/null", O_RDWR | O_CLOEXEC);
+			interactorFds[0] = CreateMemoryFile("input", inputstr);
+			interactorFds[1] = CreateMemoryFile("output", "");
+			std::string answerPath = m_expectedOutputPath;
+			if (answerPath.empty()) {
+				interactorFds[2] = CreateMemoryFile("answer", m_comparator.getExpected());
+				answerPath = "/dev/fd/" + std::to_string(interactorFds[2]);
+			}
+			interactorFds[3] = CreateMemoryFile("message", "");
+			if (nullFd < 0 || interactorFds[0] < 0 || interactorFds[1] < 0 || interactorFds[3] < 0 ||
+			    (m_expectedOutputPath.empty() && interactorFds[2] < 0)) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建交互文件失败！";
+				throw 1;
+			}
+			std::string inputPath = "/dev/fd/" + std::to_string(interactorFds[0]);
+			std::string outputPath = "/dev/fd/" + std::to_string(interactorFds[1]);
+
+			// 启动交互器
+			char* interactorArgv[] = { const_cast<char*>(interactorPath.c_str()), &inputPath[0],
+			                           &outputPath[0], &answerPath[0], NULL };
+			rlimit interactorCPULimit;
+			interactorCPULimit.rlim_cur = interactorTimeLimit / 1000 + 1;
+			interactorCPULimit.rlim_max = interactorCPULimit.rlim_cur + 1;
+			cpu_set_t interactorCPUSet;
+			CPU_ZERO(&interactorCPUSet);
+			interactorPid = SpawnProcess(interactorArgv, NULL, toInteractorPipe[0], toSolutionPipe[1],
+			                             interactorFds[3], interactorFds, 3, NULL, 0,
+			                             interactorCPULimit, interactorCPUSet);
+			if (interactorPid < 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建交互器进程失败！";
+				throw 1;
+			}
+
+			// 启动目标程序，限制与launchAndWait相同
+			rlimit cpuLimit;
+			cpuLimit.rlim_cur = timelimit / 1000 + 1;
+			if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+				long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+				cpuLimit.rlim_cur = timelimit * (cpuCount > 0 ? cpuCount : 1) / 1000 + 1;
+			}
+			cpuLimit.rlim_max = cpuLimit.rlim_cur + 1;
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			if (m_cpuAffinity >= 0) {
+				CPU_SET(m_cpuAffinity, &cpuSet);
+			}
+			const char* workingDirectoryPtr = NULL;
+			if (!m_workingDirectory.empty()) {
+				workingDirectoryPtr = m_workingDirectory.c_str();
+			}
+			cgroupPath = CreateCgroup();
+			std::string cgroupProcsPath;
+			if (!cgroupPath.empty()) {
+				cgroupProcsPath = cgroupPath + "/cgroup.procs";
+			}
+			std::vector<char*> solutionArgv = BuildArgv();
+			solutionPid = SpawnProcess(solutionArgv.data(), workingDirectoryPtr, toSolutionPipe[0],
+			                           toInteractorPipe[1], nullFd, NULL, 0,
+			                           cgroupPath.empty() ? NULL : cgroupProcsPath.c_str(),
+			                           m_memoryLimit, cpuLimit, cpuSet);
+			if (solutionPid < 0) {
+				m_verdict = JudgeVerdict::SystemError;
+				errstr = "创建进程失败！";
+				throw 1;
+			}
+
+			// 关闭本进程中的管道端，一方结束后另一方才能读到EOF
+			Clfd_s(toSolutionPipe[0]);
+			Clfd_s(toSolutionPipe[1]);
+			Clfd_s(toInteractorPipe[0]);
+			Clfd_s(toInteractorPipe[1]);
+			isLaunched = true;
+
+			// 需要等待析构事件与两个进程结束，没有pidfd时每10ms检查一次进程是否结束
+			solutionPidFd = static_cast<int>(syscall(SYS_pidfd_open, solutionPid, 0));
+			interactorPidFd = static_cast<int>(syscall(SYS_pidfd_open, interactorPid, 0));
+			pollfd waitFds[3];
+			waitFds[0].fd = m_exitEventFd;
+			waitFds[0].events = POLLIN;
+			waitFds[1].fd = solutionPidFd;
+			waitFds[1].events = POLLIN;
+			waitFds[2].fd = interactorPidFd;
+			waitFds[2].events = POLLIN;
+			bool hasPidFd = (solutionPidFd >= 0 && interactorPidFd >= 0);
+
+			// 空闲时间限制，上一次检查时两个进程的线程运行时间，最后一次发现活动时的真实时间
+			// 目标程序等待交互器的管道时交互器在运行，所以两个进程都没有活动才算目标程序空闲
+			long long idlelimit = (m_idleLimit > 0) ? m_idleLimit : timelimit;
+			unsigned long long lastSolutionRunTime = 0;
+			unsigned long long lastInteractorRunTime = 0;
+			long long lastActiveTime = 0;
+			const unsigned long long minDRunTime = 1000000ull;
+
+			// 最大真实时间花费
+			long long maxRealTimeCost = 40 * timelimit;
+
+			// 开始计时
+			auto start = std::chrono::steady_clock::now();
+			m_startTime = start;
+			while (1) {
+				long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+				                    (std::chrono::steady_clock::now() - start).count();
+				// 回收已经结束的进程，已回收的进程不再等待其pidfd
+				if (!isSolutionExited && IsProcessExited(solutionPid)) {
+					while (wait4(solutionPid, &solutionStatus, 0, &solutionUsage) < 0 &&
+					       errno == EINTR) {
+					}
+					isSolutionExited = true;
+					solutionExitTime = elapsed;
+					waitFds[1].fd = -1;
+				}
+				if (!isInteractorExited && IsProcessExited(interactorPid)) {
+					while (waitpid(interactorPid, &interactorStatus, 0) < 0 && errno == EINTR) {
+					}
+					isInteractorExited = true;
+					isInteractorFirst = !isSolutionExited;
+					waitFds[2].fd = -1;
+					// 交互器已经判定不正确，不必再等待目标程序
+					if (isInteractorFirst && (!WIFEXITED(interactorStatus) ||
+					    checkerExitCodeToVerdict(WEXITSTATUS(interactorStatus)) !=
+					    JudgeVerdict::Accepted)) {
+						break;
+					}
+				}
+				if (isSolutionExited && isInteractorExited) {
+					break;
+				}
+				if (m_willExit) {
+					m_verdict = JudgeVerdict::SystemError;
+					errstr = "类正在析构！";
+					throw 1;
+				}
+
+				// 分别检查两个进程的时间，计算距下一次检查的时间
+				long long waitTime = 100;
+				if (!isSolutionExited) {
+					long long chargedTime = GetRunCPUTime(solutionPid, cgroupPath);
+					long long threadCount = GetProcessThreadCount(solutionPid);
+					if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+						chargedTime = elapsed;
+						threadCount = 1;
+					}
+					timecosted = chargedTime;
+					if (chargedTime > timelimit) {
+						isSolutionTimeout = true;
+						break;
+					}
+					// 判断空闲：两个进程此刻都没有线程可运行，且自上次检查以来运行时间几乎没有增长
+					unsigned long long solutionRunTime = 0;
+					unsigned long long interactorRunTime = 0;
+					bool isActive = GetProcessSchedState(solutionPid, solutionRunTime);
+					if (!isInteractorExited && GetProcessSchedState(interactorPid, interactorRunTime)) {
+						isActive = true;
+					}
+					if (isActive || solutionRunTime < lastSolutionRunTime ||
+					    solutionRunTime - lastSolutionRunTime >= minDRunTime ||
+					    interactorRunTime < lastInteractorRunTime ||
+					    interactorRunTime - lastInteractorRunTime >= minDRunTime) {
+						lastActiveTime = elapsed;
+					}
+					lastSolutionRunTime = solutionRunTime;
+					lastInteractorRunTime = interactorRunTime;
+					if (elapsed - lastActiveTime >= idlelimit) {
+						isSolutionBlocked = true;
+						break;
+					}
+					// 没有空闲却得不到CPU，是评测机负载过大而不是程序超时
+					if (elapsed > maxRealTimeCost) {
+						m_verdict = JudgeVerdict::SystemError;
+						m_isOverloaded = true;
+						errstr = "评测机负载过大，执行超时！";
+						throw 1;
+					}
+					waitTime = nextTimeLimitCheck(timelimit, chargedTime, elapsed, threadCount);
+					long long idleCheck = nextIdleCheck(idlelimit, lastActiveTime, elapsed);
+					if (waitTime > idleCheck) {
+						waitTime = idleCheck;
+					}
+				}
+				if (!isInteractorExited) {
+					long long interactorCPUTime = GetProcessCPUTime(interactorPid);
+					long long interactorWaitTime = isSolutionExited ? elapsed - solutionExitTime : 0;
+					if (interactorCPUTime > interactorTimeLimit ||
+					    interactorWaitTime > interactorTimeLimit) {
+						isInteractorTimeout = true;
+						break;
+					}
+					long long interactorCheck = nextTimeLimitCheck(interactorTimeLimit,
+					                                               interactorCPUTime, 0, 1);
+					if (isSolutionExited &&
+					    interactorCheck > interactorTimeLimit - interactorWaitTime + 1) {
+						interactorCheck = interactorTimeLimit - interactorWaitTime + 1;
+					}
+					if (waitTime > interactorCheck) {
+						waitTime = interactorCheck;
+					}
+				}
+				if (!hasPidFd && waitTime > 10) {
+					waitTime = 10;
+				}
+				int pollResult = poll(waitFds, 3, static_cast<int>(waitTime));
+				(void)pollResult;
+			}
+		} catch (int) {
+			// 错误信息已经设置，结束进程后返回
+		}
+
+		// 结束两个进程组中残留的进程，回收尚未回收的进程
+		if (solutionPid > 0) {
+			kill(-solutionPid, SIGKILL);
+			if (!isSolutionExited) {
+				while (wait4(solutionPid, &solutionStatus, 0, &solutionUsage) < 0 && errno == EINTR) {
+				}
+			}
+		}
+		if (interactorPid > 0) {
+			kill(-interactorPid, SIGKILL);
+			if (!isInteractorExited) {
+				while (waitpid(interactorPid, &interactorStatus, 0) < 0 && errno == EINTR) {
+				}
+			}
+		}
+		isLaunched = false;
+
+		// 目标程序正常结束时按结束状态计算时间，获取内存峰值
+		m_realTimeCosted = std::chrono::duration_cast<std::chrono::milliseconds>
+		                   (std::chrono::steady_clock::now() - m_startTime).count();
+		if (isSolutionExited) {
+			m_realTimeCosted = solutionExitTime;
+			m_exitCode = WIFEXITED(solutionStatus) ? WEXITSTATUS(solutionStatus) : 0;
+			m_exitSignal = WIFSIGNALED(solutionStatus) ? WTERMSIG(solutionStatus) : 0;
+			long long CPUTimeUsed = timeval2ms(solutionUsage.ru_utime) +
+			                        timeval2ms(solutionUsage.ru_stime);
+			if (m_isChildProcessCounted && !cgroupPath.empty()) {
+				long long cgroupCPUTime = GetRunCPUTime(-1, cgroupPath);
+				if (cgroupCPUTime > CPUTimeUsed) {
+					CPUTimeUsed = cgroupCPUTime;
+				}
+			}
+			if (m_cpuTimePolicy == CPUTimePolicy::WallClockTime) {
+				timecosted = solutionExitTime;
+			} else {
+				timecosted = CPUTimeUsed;
+			}
+		}
+		bool isMemoryLimitExceeded = false;
+		if (!cgroupPath.empty()) {
+			m_peakMemory = GetCgroupPeakMemory(cgroupPath);
+			isMemoryLimitExceeded = IsCgroupOOMKilled(cgroupPath);
+		}
+		if (m_peakMemory == 0) {
+			m_peakMemory = static_cast<size_t>(solutionUsage.ru_maxrss) * 1024;
+		}
+		RemoveCgroup(cgroupPath);
+
+		// 取出交互器信息和输出文件的内容，关闭文件
+		if (interactorFds[3] >= 0) {
+			m_checkerMessage = ReadMemoryFile(interactorFds[3]);
+		}
+		std::string interactorOutput;
+		if (interactorFds[1] >= 0) {
+			interactorOutput = ReadMemoryFile(interactorFds[1]);
+		}
+		Clfd_s(toSolutionPipe[0]);
+		Clfd_s(toSolutionPipe[1]);
+		Clfd_s(toInteractorPipe[0]);
+		Clfd_s(toInteractorPipe[1]);
+		for (int& fd : interactorFds) {
+			Clfd_s(fd);
+		}
+		Clfd_s(nullFd);
+		Clfd_s(solutionPidFd);
+		Clfd_s(interactorPidFd);
+		if (m_verdict == JudgeVerdict::SystemError) {
+			return false;
+		}
+
+		// 判定结果：先结束的交互器给出的不正确结果优先，其次是目标程序的错误
+		JudgeVerdict interactorVerdict = JudgeVerdict::SystemError;
+		if (isInteractorExited && WIFEXITED(interactorStatus)) {
+			interactorVerdict = checkerExitCodeToVerdict(WEXITSTATUS(interactorStatus));
+		}
+		errstr = "交互器运行失败！";
+		if (isInteractorFirst && interactorVerdict != JudgeVerdict::Accepted) {
+			return SetCheckerVerdict(interactorVerdict, errstr);
+		}
+		if (isMemoryLimitExceeded) {
+			m_verdict = JudgeVerdict::MemoryLimitExceeded;
+			errstr = "内存超限！";
+			return false;
+		}
+		if (isSolutionBlocked && timecosted <= timelimit) {
+			m_verdict = JudgeVerdict::IdlenessLimitExceeded;
+			errstr = "程序疑似被阻塞，空闲时间超限！";
+			return false;
+		}
+		if (isSolutionTimeout || timecosted > timelimit ||
+		    (WIFSIGNALED(solutionStatus) && WTERMSIG(solutionStatus) == SIGXCPU)) {
+			m_verdict = JudgeVerdict::TimeLimitExceeded;
+			errstr = "执行超时！";
 			return false;
 		}
+		if (isInteractorTimeout) {
+			m_verdict = JudgeVerdict::SystemError;
+			errstr = "交互器运行超时！";
+			return false;
+		}
+		if (WIFSIGNALED(solutionStatus)) {
+			m_verdict = JudgeVerdict::RuntimeError;
+			errstr = "程序被信号" + std::to_string(WTERMSIG(solutionStatus)) + "终止！";
+			return false;
+		}
+		if (WEXITSTATUS(solutionStatus) != 0) {
+			m_verdict = JudgeVerdict::RuntimeError;
+			errstr = "程序返回值为" + std::to_string(WEXITSTATUS(solutionStatus)) + "！";
+			return false;
+		}
+		if (interactorVerdict != JudgeVerdict::Accepted) {
+			return SetCheckerVerdict(interactorVerdict, errstr);
+		}
+		if (!m_checkerPath.empty()) {
+			return RunChecker(inputstr, interactorOutput, errstr);
+		}
+		m_verdict = JudgeVerdict::Accepted;
+		errstr.clear();
+		return true;
 	}
+#endif
 };
 
 #endif /* _XY0797_CONSOLEOJ */
@@ -0,0 +1,480 @@
+/**
+ * \file    	ConsoleOJZygote.hpp
+ * \author  	XY0797
+ * \brief		Linux下预先创建子进程的zygote，降低ConsoleOJ每组测试数据的进程创建开销
+ */
+#ifndef _XY0797_CONSOLEOJZYGOTE
+#define _XY0797_CONSOLEOJZYGOTE 1
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+// zygote的统计信息
+struct ConsoleOJZygoteStats {
+	// 使用预先创建的子进程启动的次数
+	unsigned long long spawns = 0;
+	// 启动时已有就绪的子进程、需要等待zygote创建的次数
+	unsigned long long readyHits = 0;
+	unsigned long long readyWaits = 0;
+	// 无法使用zygote、需要调用者自行fork的次数
+	unsigned long long fallbacks = 0;
+};
+
+/*
+ *  Linux下的zygote(进程创建服务)
+ *  构造时fork出一个zygote进程，zygote关闭继承的全部文件描述符，之后只使用系统调用
+ *  zygote预先创建若干子进程(就绪池)，子进程已经设置好独立进程组，阻塞在控制套接字上等待启动请求
+ *  启动时把管道和参数通过控制套接字传给就绪的子进程，子进程只需重定向、设置限制并exec，同时补充就绪池
+ *  子进程用CLONE_PARENT创建，父进程是评测机而不是zygote，评测机可以像fork出的子进程一样等待和回收
+ *  fork的开销随页表大小增长，评测机越大、线程越多越明显；zygote在构造时复制评测机，应尽早构造
+ *  子进程exec时使用的环境变量是构造zygote时评测机的环境变量，之后评测机对环境变量的修改不会传给目标程序
+ *  启动请求只包含CPU时间限制和CPU绑定，内存限制(prlimit设置RLIMIT_AS)和cgroup(写入cgroup.procs)由评测机
+ *  在子进程等待启动屏障期间设置，所以调用者必须先设置好这些限制再放行屏障，见ConsoleOJ::launchAndWait
+ */
+class ConsoleOJZygote {
+private:
+	// 就绪的子进程：进程号和控制套接字
+	struct PreforkedChild {
+		pid_t pid;
+		int controlSocket;
+	};
+
+	// 启动请求的固定部分，后跟：程序路径\0 [工作目录\0] 参数0\0 参数1\0 ...
+	struct SpawnRequestHeader {
+		rlimit cpuLimit;
+		int cpuIndex;
+		int hasWorkingDirectory;
+		int argc;
+	};
+
+	// 启动请求的最大字节数和最多参数个数，超过时由调用者自行fork
+	static constexpr size_t m_maxRequestSize = 65536;
+	static constexpr int m_maxArgc = 1024;
+
+	// 启动请求随附的文件描述符：标准输入、标准输出(兼标准错误)、启动屏障读取端、exec错误回报写入端
+	static constexpr int m_spawnFdCount = 4;
+
+	// zygote进程和与其通信的套接字
+	pid_t m_zygotePid = -1;
+	int m_zygoteSocket = -1;
+
+	// 就绪池的目标大小、就绪的子进程和已发出未收到回复的创建请求数
+	size_t m_poolSize;
+	std::mutex m_zygoteMutex;
+	std::deque<PreforkedChild> m_readyChildren;
+	size_t m_pendingRequests = 0;
+	ConsoleOJZygoteStats m_stats;
+
+	// 发送一条消息并随附文件描述符，失败返回false
+	static bool SendWithFds(int socketFd, const void* data, size_t len, const int* fds, int fdCount) {
+		iovec iov;
+		iov.iov_base = const_cast<void*>(data);
+		iov.iov_len = len;
+		char control[CMSG_SPACE(sizeof(int) * m_spawnFdCount)];
+		memset(control, 0, sizeof(control));
+		msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = &iov;
+		message.msg_iovlen = 1;
+		if (fdCount > 0) {
+			message.msg_control = control;
+			message.msg_controllen = CMSG_SPACE(sizeof(int) * fdCount);
+			cmsghdr* header = CMSG_FIRSTHDR(&message);
+			header->cmsg_level = SOL_SOCKET;
+			header->cmsg_type = SCM_RIGHTS;
+			header->cmsg_len = CMSG_LEN(sizeof(int) * fdCount);
+			memcpy(CMSG_DATA(header), fds, sizeof(int) * fdCount);
+		}
+		ssize_t sent;
+		while ((sent = sendmsg(socketFd, &message, MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+		}
+		return sent == static_cast<ssize_t>(len);
+	}
+
+	/*
+	 *  接收一条消息和随附的文件描述符，收到的文件描述符带CLOEXEC
+	 *  返回消息的字节数，对端关闭返回0，失败返回-1；文件描述符个数写入fdCount，未收到的位置为-1
+	 */
+	static ssize_t RecvWithFds(int socketFd, void* data, size_t len, int* fds, int& fdCount, int flags) {
+		iovec iov;
+		iov.iov_base = data;
+		iov.iov_len = len;
+		char control[CMSG_SPACE(sizeof(int) * m_spawnFdCount)];
+		msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = &iov;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		ssize_t received;
+		while ((received = recvmsg(socketFd, &message, flags | MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {
+		}
+		int maxFdCount = fdCount;
+		fdCount = 0;
+		for (int i = 0; i < maxFdCount; ++i) {
+			fds[i] = -1;
+		}
+		if (received < 0) {
+			return -1;
+		}
+		for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != NULL; header = CMSG_NXTHDR(&message, header)) {
+			if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+				continue;
+			}
+			int count = static_cast<int>((header->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+			for (int i = 0; i < count; ++i) {
+				int fd;
+				memcpy(&fd, CMSG_DATA(header) + sizeof(int) * i, sizeof(int));
+				if (fdCount < maxFdCount) {
+					fds[fdCount++] = fd;
+				} else {
+					close(fd);
+				}
+			}
+		}
+		return received;
+	}
+
+	/*
+	 *  就绪的子进程，阻塞在控制套接字上等待启动请求
+	 *  与ConsoleOJ中fork出的子进程做相同的事：重定向、切换工作目录、设置限制、等待启动屏障、exec
+	 *  只调用异步信号安全的函数，使用栈上的缓冲区
+	 */
+	[[noreturn]] static void PreforkedChildMain(int controlSocket) {
+		// 独立进程组，便于结束整个进程树
+		setpgid(0, 0);
+		char request[m_maxRequestSize];
+		int fds[m_spawnFdCount];
+		int fdCount = m_spawnFdCount;
+		ssize_t len = RecvWithFds(controlSocket, request, sizeof(request), fds, fdCount, 0);
+		// 评测机关闭了控制套接字或请求不完整，直接退出
+		if (len < static_cast<ssize_t>(sizeof(SpawnRequestHeader)) || fdCount != m_spawnFdCount) {
+			_exit(0);
+		}
+		close(controlSocket);
+
+		// 解析请求，字符串都在请求缓冲区内
+		SpawnRequestHeader header;
+		memcpy(&header, request, sizeof(header));
+		char* argv[m_maxArgc + 1];
+		char* cursor = request + sizeof(header);
+		char* end = request + len;
+		char* programPath = cursor;
+		cursor += strnlen(cursor, end - cursor) + 1;
+		char* workingDirectory = NULL;
+		if (header.hasWorkingDirectory && cursor < end) {
+			workingDirectory = cursor;
+			cursor += strnlen(cursor, end - cursor) + 1;
+		}
+		int argc = 0;
+		while (argc < header.argc && argc < m_maxArgc && cursor < end) {
+			argv[argc++] = cursor;
+			cursor += strnlen(cursor, end - cursor) + 1;
+		}
+		argv[argc] = NULL;
+
+		dup2(fds[0], STDIN_FILENO);
+		dup2(fds[1], STDOUT_FILENO);
+		dup2(fds[1], STDERR_FILENO);
+		if (workingDirectory != NULL && chdir(workingDirectory) != 0) {
+			int err = errno;
+			ssize_t ret = write(fds[3], &err, sizeof(err));
+			(void)ret;
+			_exit(127);
+		}
+		setrlimit(RLIMIT_CPU, &header.cpuLimit);
+		if (header.cpuIndex >= 0) {
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			CPU_SET(header.cpuIndex, &cpuSet);
+			sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+		}
+		// 等待启动屏障，相当于CREATE_SUSPENDED
+		char barrier;
+		while (read(fds[2], &barrier, 1) < 0 && errno == EINTR) {
+		}
+		execv(programPath, argv);
+		int err = errno;
+		ssize_t ret = write(fds[3], &err, sizeof(err));
+		(void)ret;
+		_exit(127);
+	}
+
+	/*
+	 *  zygote进程的主循环
+	 *  每收到一个字节的创建请求，就用CLONE_PARENT创建一个就绪的子进程，回复其进程号和控制套接字
+	 *  评测机关闭套接字(包括评测机退出)时zygote退出
+	 */
+	[[noreturn]] static void ZygoteMain(int zygoteSocket) {
+		// 关闭从评测机继承的全部文件描述符，否则会持有其他评测的管道，使其读不到EOF
+		rlimit fileLimit;
+		int maxFd = (getrlimit(RLIMIT_NOFILE, &fileLimit) == 0 && fileLimit.rlim_cur != RLIM_INFINITY)
+		            ? static_cast<int>(fileLimit.rlim_cur) : 65536;
+		long closeResult = -1;
+#ifdef SYS_close_range
+		closeResult = syscall(SYS_close_range, 3, ~0U, 0);
+#endif
+		if (closeResult != 0) {
+			for (int fd = 3; fd < maxFd; ++fd) {
+				close(fd);
+			}
+		}
+		// 套接字在close_range之前已被移到0号，挪回3号，再把标准输入输出指向/dev/null
+		dup2(zygoteSocket, 3);
+		zygoteSocket = 3;
+		int nullFd = open("/dev/null", O_RDWR);
+		dup2(nullFd, STDIN_FILENO);
+		dup2(nullFd, STDOUT_FILENO);
+		dup2(nullFd, STDERR_FILENO);
+		if (nullFd > STDERR_FILENO) {
+			close(nullFd);
+		}
+		// 恢复默认的信号处理和信号屏蔽，exec会保留被忽略的信号和信号屏蔽
+		signal(SIGPIPE, SIG_DFL);
+		sigset_t emptyMask;
+		sigemptyset(&emptyMask);
+		sigprocmask(SIG_SETMASK, &emptyMask, NULL);
+
+		while (1) {
+			char command;
+			ssize_t len = recv(zygoteSocket, &command, 1, 0);
+			if (len < 0 && errno == EINTR) {
+				continue;
+			}
+			if (len <= 0) {
+				_exit(0);
+			}
+			pid_t pid = -1;
+			int controlPair[2] = { -1, -1 };
+			if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, controlPair) == 0) {
+				// 新进程的父进程为评测机
+				pid = static_cast<pid_t>(syscall(SYS_clone, CLONE_PARENT | SIGCHLD, 0, 0, 0, 0));
+				if (pid == 0) {
+					close(zygoteSocket);
+					close(controlPair[0]);
+					PreforkedChildMain(controlPair[1]);
+				}
+				close(controlPair[1]);
+			}
+			SendWithFds(zygoteSocket, &pid, sizeof(pid), &controlPair[0], (pid > 0) ? 1 : 0);
+			if (controlPair[0] >= 0) {
+				close(controlPair[0]);
+			}
+		}
+	}
+
+	// 向zygote请求创建一个子进程，需要持有锁
+	void RequestChild() {
+		char command = 0;
+		if (send(m_zygoteSocket, &command, 1, MSG_NOSIGNAL) == 1) {
+			++m_pendingRequests;
+		}
+	}
+
+	/*
+	 *  接收zygote的回复，放入就绪池，需要持有锁
+	 *  是否阻塞[in]：为true时至少等待一个回复，否则只接收已到达的回复
+	 *  返回是否与zygote通信正常
+	 */
+	bool ReceiveChildren(bool isBlocking) {
+		while (m_pendingRequests > 0) {
+			pid_t pid = -1;
+			int controlSocket = -1;
+			int fdCount = 1;
+			ssize_t len = RecvWithFds(m_zygoteSocket, &pid, sizeof(pid), &controlSocket, fdCount,
+			                          isBlocking ? 0 : MSG_DONTWAIT);
+			if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				return true;
+			}
+			if (len != static_cast<ssize_t>(sizeof(pid))) {
+				return false;
+			}
+			--m_pendingRequests;
+			isBlocking = false;
+			if (pid > 0 && controlSocket >= 0) {
+				m_readyChildren.push_back(PreforkedChild{ pid, controlSocket });
+			} else if (controlSocket >= 0) {
+				close(controlSocket);
+			}
+		}
+		return true;
+	}
+
+	// 结束并回收一个未使用的子进程
+	static void DiscardChild(const PreforkedChild& child) {
+		close(child.controlSocket);
+		kill(child.pid, SIGKILL);
+		while (waitpid(child.pid, NULL, 0) < 0 && errno == EINTR) {
+		}
+	}
+
+	// 取出一个就绪的子进程并补充就绪池，失败返回false
+	bool Acquire(PreforkedChild& child) {
+		std::lock_guard<std::mutex> lock(m_zygoteMutex);
+		if (m_zygoteSocket < 0 || !ReceiveChildren(false)) {
+			return false;
+		}
+		if (m_readyChildren.empty()) {
+			if (m_pendingRequests == 0) {
+				RequestChild();
+			}
+			if (!ReceiveChildren(true) || m_readyChildren.empty()) {
+				return false;
+			}
+			++m_stats.readyWaits;
+		} else {
+			++m_stats.readyHits;
+		}
+		child = m_readyChildren.front();
+		m_readyChildren.pop_front();
+		while (m_readyChildren.size() + m_pendingRequests < m_poolSize) {
+			size_t pendingBefore = m_pendingRequests;
+			RequestChild();
+			if (m_pendingRequests == pendingBefore) {
+				break;
+			}
+		}
+		return true;
+	}
+
+public:
+	/*
+	 *  构造时传入：[就绪池大小]
+	 *  创建zygote进程并预先创建就绪池大小个子进程，创建失败时isAvailable()返回false
+	 *  zygote复制的是构造时的评测机进程，应在创建其他线程和分配大量内存之前构造
+	 */
+	explicit ConsoleOJZygote(size_t poolSize = 4) : m_poolSize(poolSize > 0 ? poolSize : 1) {
+		int zygotePair[2];
+		if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, zygotePair) != 0) {
+			return;
+		}
+		m_zygotePid = fork();
+		if (m_zygotePid == 0) {
+			close(zygotePair[0]);
+			// 先把套接字移到0号，使close_range(3, ...)不会关闭它
+			dup2(zygotePair[1], 0);
+			ZygoteMain(0);
+		}
+		close(zygotePair[1]);
+		if (m_zygotePid < 0) {
+			close(zygotePair[0]);
+			return;
+		}
+		m_zygoteSocket = zygotePair[0];
+		m_zygoteMutex.lock();
+		for (size_t i = 0; i < m_poolSize; ++i) {
+			RequestChild();
+		}
+		m_zygoteMutex.unlock();
+	}
+
+	ConsoleOJZygote(const ConsoleOJZygote&) = delete;
+	ConsoleOJZygote& operator=(const ConsoleOJZygote&) = delete;
+
+	// 析构时结束就绪池中的子进程和zygote进程，并全部回收
+	~ConsoleOJZygote() {
+		if (m_zygoteSocket < 0) {
+			return;
+		}
+		m_zygoteMutex.lock();
+		ReceiveChildren(true);
+		while (m_pendingRequests > 0 && ReceiveChildren(true)) {
+		}
+		for (const PreforkedChild& child : m_readyChildren) {
+			DiscardChild(child);
+		}
+		m_readyChildren.clear();
+		close(m_zygoteSocket);
+		m_zygoteSocket = -1;
+		m_zygoteMutex.unlock();
+		while (waitpid(m_zygotePid, NULL, 0) < 0 && errno == EINTR) {
+		}
+	}
+
+	// 返回zygote是否创建成功
+	bool isAvailable() const {
+		return m_zygoteSocket >= 0;
+	}
+
+	/*
+	 *  用就绪的子进程启动程序，返回子进程的进程号，无法使用zygote时返回-1，由调用者自行fork
+	 *  子进程的行为与ConsoleOJ中fork出的子进程相同，调用者关闭自己持有的子进程端，放行屏障后读取exec错误
+ *  内存限制和cgroup不由子进程设置，调用者应在放行屏障之前用prlimit和cgroup.procs设置
+	 *  参数表[in]：以NULL结尾，第一项为程序名
+	 *  程序路径[in]、工作目录[in]：工作目录为NULL时不切换
+	 *  CPU时间限制[in]：子进程的RLIMIT_CPU，CPU编号[in]：-1为不绑定
+	 *  标准输入[in]、标准输出[in]：标准错误与标准输出相同
+	 *  启动屏障读取端[in]：子进程读到数据或EOF后exec
+	 *  exec错误回报写入端[in]：exec失败时子进程写入errno，成功时因CLOEXEC关闭
+	 */
+	pid_t Spawn(char* const* argv, const char* programPath, const char* workingDirectory,
+	            const rlimit& cpuLimit, int cpuIndex, int stdinFd, int stdoutFd,
+	            int barrierReadFd, int execErrorWriteFd) {
+		// 组装请求，放不下时不使用zygote
+		char request[m_maxRequestSize];
+		SpawnRequestHeader header;
+		memset(&header, 0, sizeof(header));
+		header.cpuLimit = cpuLimit;
+		header.cpuIndex = cpuIndex;
+		header.hasWorkingDirectory = (workingDirectory != NULL);
+		size_t len = sizeof(header);
+		bool isFit = true;
+		auto append = [&](const char* text) {
+			size_t textLen = strlen(text) + 1;
+			if (len + textLen > sizeof(request)) {
+				isFit = false;
+				return;
+			}
+			memcpy(request + len, text, textLen);
+			len += textLen;
+		};
+		append(programPath);
+		if (workingDirectory != NULL) {
+			append(workingDirectory);
+		}
+		for (; argv[header.argc] != NULL; ++header.argc) {
+			append(argv[header.argc]);
+		}
+		memcpy(request, &header, sizeof(header));
+		PreforkedChild child;
+		if (!isFit || header.argc > m_maxArgc || !Acquire(child)) {
+			std::lock_guard<std::mutex> lock(m_zygoteMutex);
+			++m_stats.fallbacks;
+			return -1;
+		}
+
+		int fds[m_spawnFdCount] = { stdinFd, stdoutFd, barrierReadFd, execErrorWriteFd };
+		if (!SendWithFds(child.controlSocket, request, len, fds, m_spawnFdCount)) {
+			DiscardChild(child);
+			std::lock_guard<std::mutex> lock(m_zygoteMutex);
+			++m_stats.fallbacks;
+			return -1;
+		}
+		close(child.controlSocket);
+		std::lock_guard<std::mutex> lock(m_zygoteMutex);
+		++m_stats.spawns;
+		return child.pid;
+	}
+
+	// 返回统计信息
+	ConsoleOJZygoteStats getStats() {
+		std::lock_guard<std::mutex> lock(m_zygoteMutex);
+		return m_stats;
+	}
+};
+
+#endif /* _WIN32 */
+
+#endif /* _XY0797_CONSOLEOJZYGOTE */
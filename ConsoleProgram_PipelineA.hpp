@@ -0,0 +1,144 @@
+#ifndef _XY0797_CONSOLEPROGRAM_PIPELINEA
+#define _XY0797_CONSOLEPROGRAM_PIPELINEA 1
+
+#include <memory>
+#include <vector>
+#include "ConsoleProgram_SyncA.hpp"
+
+// 控制台程序流水线，多字节字符集版本
+// 前一个程序的输出通过内核管道直接连接到后一个程序的输入，数据不经过本进程
+// 只有第一个程序的输入和最后一个程序的输出对外开放
+class ConsoleProgram_PipelineA {
+private:
+	// 流水线的各个程序，按数据流动顺序排列
+	std::vector<std::unique_ptr<ConsoleProgram_SyncA>> m_stages;
+
+public:
+	ConsoleProgram_PipelineA() = default;
+	ConsoleProgram_PipelineA(const ConsoleProgram_PipelineA&) = delete;
+	ConsoleProgram_PipelineA& operator=(const ConsoleProgram_PipelineA&) = delete;
+
+	~ConsoleProgram_PipelineA() {
+		Stop();
+	}
+
+	/*
+	 *  在流水线末尾添加一个程序，参数与ConsoleProgram_SyncA的构造函数相同
+	 *  必须在Start之前调用，返回流水线自身以便链式调用
+	 */
+	ConsoleProgram_PipelineA& AddStage(const std::string& programPath,
+	                                   const std::string& workingDirectory = "",
+	                                   const std::string& commandLineArgument = "") {
+		m_stages.emplace_back(new ConsoleProgram_SyncA(programPath, workingDirectory,
+		                      commandLineArgument));
+		return *this;
+	}
+
+	/*
+	 *  按顺序启动流水线中的所有程序
+	 *  任意一个程序启动失败时结束已经启动的程序，返回false
+	 */
+	bool Start() {
+		if (m_stages.empty() || getProcessStatus()) {
+			return false;
+		}
+
+		// 上一个程序输出管道的读取端，作为下一个程序的输入
+		HANDLE prevOutputRead = NULL;
+		for (size_t i = 0; i < m_stages.size(); ++i) {
+			// 创建连接到下一个程序的管道，最后一个程序使用自己的输出管道
+			// 管道句柄不可继承，Start复制出可继承的副本并通过句柄列表只交给对应的进程
+			HANDLE outputRead = NULL;
+			HANDLE outputWrite = NULL;
+			if (i + 1 < m_stages.size() &&
+			    !CreatePipe(&outputRead, &outputWrite, NULL, 0)) {
+				Clhandle_s(prevOutputRead);
+				Stop();
+				return false;
+			}
+
+			// 第一个程序使用自己的输入管道
+			bool isStarted = m_stages[i]->Start(prevOutputRead, outputWrite);
+
+			// 管道端已被子进程继承，关闭本进程中的副本，这样上游结束时下游能读到EOF
+			Clhandle_s(prevOutputRead);
+			Clhandle_s(outputWrite);
+			prevOutputRead = outputRead;
+
+			if (!isStarted) {
+				Clhandle_s(prevOutputRead);
+				Stop();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 强制结束流水线中的所有程序，等待它们结束后返回
+	void Stop() {
+		for (auto& stage : m_stages) {
+			stage->Stop();
+		}
+	}
+
+	// 向第一个程序输入，参数与ConsoleProgram_SyncA::Input相同
+	void Input(const char* input, DWORD len) {
+		if (!m_stages.empty()) {
+			m_stages.front()->Input(input, len);
+		}
+	}
+
+	// 向第一个程序输入，参数与ConsoleProgram_SyncA::Input相同
+	void Input(const std::string& input) {
+		if (!m_stages.empty()) {
+			m_stages.front()->Input(input);
+		}
+	}
+
+	// 向第一个程序输入一行，参数与ConsoleProgram_SyncA::InputLine相同
+	void InputLine(const std::string& input,
+	               NewlineStyle newlineStyle = NewlineStyle::CRLF) {
+		if (!m_stages.empty()) {
+			m_stages.front()->InputLine(input, newlineStyle);
+		}
+	}
+
+	// 拉取最后一个程序的输出，参数与ConsoleProgram_SyncA::PullOutput相同
+	DWORD PullOutput(char* buffer, DWORD bufferSize) {
+		if (m_stages.empty()) {
+			buffer[0] = '\0';
+			return 0;
+		}
+		return m_stages.back()->PullOutput(buffer, bufferSize);
+	}
+
+	// 读取最后一个程序的原始输出，参数与ConsoleProgram_SyncA::ReadOutput相同
+	DWORD ReadOutput(char* buffer, DWORD size) {
+		if (m_stages.empty()) {
+			return 0;
+		}
+		return m_stages.back()->ReadOutput(buffer, size);
+	}
+
+	// 返回流水线状态，任意一个程序正在运行返回true，否则返回false
+	bool getProcessStatus() {
+		for (auto& stage : m_stages) {
+			if (stage->getProcessStatus()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// 返回流水线中程序的数目
+	size_t getStageCount() const {
+		return m_stages.size();
+	}
+
+	// 返回指定程序的退出代码，含义与ConsoleProgram_SyncA::getProcessExitCode相同
+	DWORD getStageExitCode(size_t index) {
+		return m_stages.at(index)->getProcessExitCode();
+	}
+};
+
+#endif /* _XY0797_CONSOLEPROGRAM_PIPELINEA */
@@ -0,0 +1,277 @@
+#ifndef _XY0797_CONSOLEPROGRAM_REPLAYA
+#define _XY0797_CONSOLEPROGRAM_REPLAYA 1
+
+#include <vector>
+#include <fstream>
+#include "ConsoleProgram_SyncA.hpp"
+
+// 会话日志中的一条事件
+struct SessionEvent {
+	SessionEventType type;
+	// 距录制开始的微秒数
+	unsigned long long timeMicroseconds;
+	std::string data;
+};
+
+// 回放选项
+struct ReplayOptions {
+	// 回放速度倍数，1为按原速回放，2为两倍速，0为不等待、尽快输入
+	double speed = 1.0;
+	// 从输入到输出的延迟比录制时增加超过此值即视为延迟退化，单位微秒
+	long long latencyThreshold = 100000;
+	// 输入全部回放后关闭输入管道并等待进程结束的时间，超时则强制结束，单位毫秒
+	DWORD exitTimeout = 5000;
+};
+
+// 一处延迟退化
+struct ReplayLatencyRegression {
+	// 输出达到的字节数，即录制时这段输出结束的位置
+	size_t outputOffset;
+	// 录制时和回放时，从最近一次输入到输出达到该位置的微秒数
+	long long recordedLatency;
+	long long replayedLatency;
+};
+
+// 回放结果
+struct ReplayReport {
+	// 输出是否完全一致，以及第一个不一致的字节位置(一致时为输出长度)
+	bool isOutputMatched = false;
+	size_t mismatchOffset = 0;
+	// 录制时和回放时的完整输出
+	std::string recordedOutput;
+	std::string replayedOutput;
+	// 录制时和回放时的退出代码，日志中没有退出事件时为STILL_ACTIVE
+	DWORD recordedExitCode = STILL_ACTIVE;
+	DWORD replayedExitCode = STILL_ACTIVE;
+	// 所有超过阈值的延迟退化
+	std::vector<ReplayLatencyRegression> latencyRegressions;
+};
+
+// 会话回放类，读取ConsoleProgram_SyncA::StartRecording录制的日志
+// 把录制的输入按原来的节奏输入新的程序，并对比输出内容和输出延迟
+class ConsoleProgram_ReplayA {
+private:
+	// 日志中的全部事件
+	std::vector<SessionEvent> m_events;
+
+	// 从日志中读取变长整数
+	static bool ReadVarint(std::istream& stream, unsigned long long& value) {
+		value = 0;
+		for (int i = 0; i < 10; ++i) {
+			int byte = stream.get();
+			if (byte == EOF) {
+				return false;
+			}
+			value |= static_cast<unsigned long long>(byte & 0x7F) << (7 * i);
+			if ((byte & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// 一段输出结束的位置和时间
+	struct OutputMark {
+		size_t offset;
+		long long timeMicroseconds;
+		// 这段输出之前最近一次输入的序号，没有输入时为-1
+		long long inputIndex;
+	};
+
+	// 回放时的输出读取线程
+	static void ReadOutputThread(ConsoleProgram_SyncA* const program,
+	                             std::chrono::steady_clock::time_point start,
+	                             std::string* output, std::vector<OutputMark>* marks) {
+		char buffer[4096];
+		while (1) {
+			DWORD bytesRead = program->ReadOutput(buffer, sizeof(buffer));
+			if (bytesRead == 0) {
+				// 进程仍在运行说明输出管道已经关闭
+				if (program->getProcessStatus()) {
+					return;
+				}
+				// 进程已结束，取出剩余的输出
+				bytesRead = program->ReadOutput(buffer, sizeof(buffer));
+				if (bytesRead == 0) {
+					return;
+				}
+			}
+			output->append(buffer, bytesRead);
+			OutputMark mark;
+			mark.offset = output->size();
+			mark.timeMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>
+			                        (std::chrono::steady_clock::now() - start).count();
+			mark.inputIndex = -1;
+			marks->push_back(mark);
+		}
+	}
+
+public:
+	/*
+	 *  读取会话日志
+	 *  返回是否成功读取，文件不存在、格式错误(如未知的事件类型)或内容不完整时返回false
+	 */
+	bool Load(const std::string& logPath) {
+		m_events.clear();
+		std::ifstream file(logPath, std::ios::binary);
+		char magic[4];
+		if (!file.read(magic, 4) || memcmp(magic, "CPSL", 4) != 0) {
+			return false;
+		}
+		// 文件大小，用于在分配内存之前检查数据长度，损坏的日志中长度可能很大
+		std::streamoff headerEnd = file.tellg();
+		file.seekg(0, std::ios::end);
+		std::streamoff fileSize = file.tellg();
+		file.seekg(headerEnd);
+		unsigned long long timeMicroseconds = 0;
+		while (1) {
+			int type = file.get();
+			if (type == EOF) {
+				return true;
+			}
+			if (type != static_cast<int>(SessionEventType::Input) &&
+			    type != static_cast<int>(SessionEventType::Output) &&
+			    type != static_cast<int>(SessionEventType::Exit)) {
+				return false;
+			}
+			unsigned long long delta, len;
+			if (!ReadVarint(file, delta) || !ReadVarint(file, len)) {
+				return false;
+			}
+			if (len > static_cast<unsigned long long>(fileSize - file.tellg())) {
+				return false;
+			}
+			timeMicroseconds += delta;
+			SessionEvent event;
+			event.type = static_cast<SessionEventType>(type);
+			event.timeMicroseconds = timeMicroseconds;
+			event.data.resize(len);
+			if (len > 0 && !file.read(&event.data[0], len)) {
+				return false;
+			}
+			m_events.push_back(std::move(event));
+		}
+	}
+
+	// 返回读取到的全部事件
+	const std::vector<SessionEvent>& getEvents() const {
+		return m_events;
+	}
+
+	/*
+	 *  回放会话
+	 *  启动传入的程序，按录制时的节奏(可加速)回放全部输入
+	 *  输入全部回放后关闭输入管道，等待程序结束，然后对比输出内容、退出代码和输出延迟
+	 *  程序[in]：未启动的程序，通常使用新版本的可执行文件构造
+	 *  回放结果[out]：返回对比的详细结果
+	 *  返回程序是否启动并且输出、退出代码一致且没有延迟退化
+	 */
+	bool Replay(ConsoleProgram_SyncA& program, const ReplayOptions& options,
+	            ReplayReport& report) {
+		report = ReplayReport();
+
+		// 整理录制时的输出、输入时间和退出代码
+		std::vector<long long> recordedInputTimes;
+		std::vector<OutputMark> recordedMarks;
+		for (const SessionEvent& event : m_events) {
+			switch (event.type) {
+				case SessionEventType::Input:
+					recordedInputTimes.push_back(event.timeMicroseconds);
+					break;
+				case SessionEventType::Output: {
+					report.recordedOutput += event.data;
+					OutputMark mark;
+					mark.offset = report.recordedOutput.size();
+					mark.timeMicroseconds = event.timeMicroseconds;
+					mark.inputIndex = static_cast<long long>(recordedInputTimes.size()) - 1;
+					recordedMarks.push_back(mark);
+					break;
+				}
+				case SessionEventType::Exit:
+					report.recordedExitCode = 0;
+					for (size_t i = 0; i < 4 && i < event.data.size(); ++i) {
+						unsigned char byte = static_cast<unsigned char>(event.data[i]);
+						report.recordedExitCode |= static_cast<DWORD>(byte) << (8 * i);
+					}
+					break;
+			}
+		}
+
+		// 启动程序和输出读取线程
+		if (!program.Start()) {
+			return false;
+		}
+		auto start = std::chrono::steady_clock::now();
+		std::vector<OutputMark> replayedMarks;
+		std::thread outputThread(&ReadOutputThread, &program, start,
+		                         &report.replayedOutput, &replayedMarks);
+
+		// 按录制时的节奏回放输入
+		std::vector<long long> replayedInputTimes;
+		for (const SessionEvent& event : m_events) {
+			if (event.type != SessionEventType::Input) {
+				continue;
+			}
+			if (options.speed > 0) {
+				long long target = static_cast<long long>(event.timeMicroseconds / options.speed);
+				std::this_thread::sleep_until(start + std::chrono::microseconds(target));
+			}
+			replayedInputTimes.push_back(std::chrono::duration_cast<std::chrono::microseconds>
+			                             (std::chrono::steady_clock::now() - start).count());
+			program.Input(event.data);
+		}
+
+		// 关闭输入管道，等待程序结束
+		StopPolicy policy;
+		policy.closeInputTimeout = options.exitTimeout;
+		program.Stop(policy);
+		outputThread.join();
+		report.replayedExitCode = program.getProcessExitCode();
+
+		// 对比输出内容
+		const std::string& recorded = report.recordedOutput;
+		const std::string& replayed = report.replayedOutput;
+		size_t commonLen = recorded.size() < replayed.size() ? recorded.size() : replayed.size();
+		report.mismatchOffset = 0;
+		while (report.mismatchOffset < commonLen &&
+		       recorded[report.mismatchOffset] == replayed[report.mismatchOffset]) {
+			++report.mismatchOffset;
+		}
+		report.isOutputMatched = (recorded.size() == replayed.size() &&
+		                          report.mismatchOffset == commonLen);
+
+		// 对比一致部分的输出延迟，延迟从这段输出之前最近一次输入算起
+		size_t replayedMark = 0;
+		for (const OutputMark& mark : recordedMarks) {
+			if (mark.offset > report.mismatchOffset) {
+				break;
+			}
+			while (replayedMark < replayedMarks.size() &&
+			       replayedMarks[replayedMark].offset < mark.offset) {
+				++replayedMark;
+			}
+			if (replayedMark == replayedMarks.size()) {
+				break;
+			}
+			long long recordedLatency = mark.timeMicroseconds;
+			long long replayedLatency = replayedMarks[replayedMark].timeMicroseconds;
+			if (mark.inputIndex >= 0) {
+				recordedLatency -= recordedInputTimes[mark.inputIndex];
+				replayedLatency -= replayedInputTimes[mark.inputIndex];
+			}
+			if (replayedLatency - recordedLatency > options.latencyThreshold) {
+				ReplayLatencyRegression regression;
+				regression.outputOffset = mark.offset;
+				regression.recordedLatency = recordedLatency;
+				regression.replayedLatency = replayedLatency;
+				report.latencyRegressions.push_back(regression);
+			}
+		}
+
+		return report.isOutputMatched &&
+		       report.recordedExitCode == report.replayedExitCode &&
+		       report.latencyRegressions.empty();
+	}
+};
+
+#endif /* _XY0797_CONSOLEPROGRAM_REPLAYA */
@@ -6,7 +6,14 @@
 #include <thread>
 #include <chrono>
 #include <string>
+#include <fstream>
+#include <memory>
+#include <deque>
+#include <map>
+#include <condition_variable>
+#include <vector>
 #include <windows.h>
+#include "OutputChunkPool.hpp"
 
 // 换行符风格定义
 enum class NewlineStyle {
@@ -15,6 +22,58 @@ enum class NewlineStyle {
 	CRLF    // \r\n
 };
 
+// 二进制帧的长度头格式
+enum class FrameHeader {
+	U16LE,      // 2字节小端序
+	U16BE,      // 2字节大端序
+	U32LE,      // 4字节小端序
+	U32BE,      // 4字节大端序
+	Varint      // 变长整数，每字节低7位存数据，最高位为1表示后面还有字节
+};
+
+// 会话日志中的事件类型
+// 日志格式：4字节魔数"CPSL"，之后每条事件为：
+// 1字节事件类型 + 距上一条事件的微秒数(变长整数) + 数据长度(变长整数) + 数据
+enum class SessionEventType : unsigned char {
+	Input = 1,      // 写入目标程序的输入
+	Output = 2,     // 从目标程序读取的一段输出
+	Exit = 3        // 目标程序结束，数据为4字节小端序的退出代码
+};
+
+// 输出订阅者落后超过上限时的处理方式
+enum class SubscriberOverflow {
+	Drop,       // 丢弃该订阅者最旧的未读输出
+	Block       // 暂停读取输出，等待该订阅者追上，目标程序的输出也会被阻塞
+};
+
+// 停止进程时各升级步骤
+enum class StopStep {
+	None,           // 进程未在运行，无需停止
+	Input,          // 输入停止命令后进程自行结束
+	CloseInput,     // 关闭输入管道(EOF)后进程自行结束
+	Terminate,      // 强制结束进程
+	Failed          // 所有步骤执行完毕，进程仍然处于运行状态
+};
+
+// 停止进程的升级策略，按Input->CloseInput->Terminate的顺序依次执行
+// 每一步的超时时间单位为毫秒，超时时间为0表示跳过该步骤
+struct StopPolicy {
+	// 停止命令(需要包含换行符)，为空则跳过输入步骤
+	std::string input;
+	DWORD inputTimeout = 0;
+	DWORD closeInputTimeout = 0;
+	// 强制结束进程后的等待时间，为0时只结束进程，不等待
+	DWORD terminateTimeout = 120000;
+};
+
+// 停止进程的结果
+struct StopResult {
+	// 使进程结束的步骤
+	StopStep step = StopStep::None;
+	// 从开始停止到进程结束(或放弃等待)的耗时，单位毫秒
+	DWORD elapsedMilliseconds = 0;
+};
+
 // 安全关闭句柄
 void Clhandle_s(HANDLE& hd) {
 	if (hd != NULL) {
@@ -24,7 +83,6 @@ void Clhandle_s(HANDLE& hd) {
 }
 
 // 控制台程序操作类，同步方式，线程安全
-// 调用Stop可能抛出int型异常，值为1，表示调用结束进程后等待了2分钟，进程仍然处于运行状态
 class ConsoleProgram_SyncA {
 private:
 	// 可执行文件路径、工作目录、命令行参数
@@ -37,6 +95,55 @@ private:
 
 	std::mutex m_outputMutex;
 
+	// 读写二进制帧专用锁，保证一帧的长度头和数据不被其它帧穿插
+	std::mutex m_frameReadMutex;
+	std::mutex m_frameWriteMutex;
+
+	// 已读取长度头但还未读取数据的帧
+	bool m_hasPendingFrame = false;
+	DWORD m_pendingFrameLen = 0;
+
+	// 输出订阅者
+	struct OutputSubscriber {
+		// 下一个要读取的输出块序号
+		unsigned long long cursor;
+		// 允许落后的最大字节数和超过时的处理方式
+		DWORD maxLagBytes;
+		SubscriberOverflow overflow;
+		// 被丢弃的字节数
+		unsigned long long droppedBytes;
+	};
+
+	// 共享的输出块，以及这块输出结束时的累计字节数
+	struct OutputChunk {
+		std::shared_ptr<const std::string> data;
+		unsigned long long endOffset;
+	};
+
+	// 输出广播专用锁和条件变量
+	std::mutex m_broadcastMutex;
+	std::condition_variable m_broadcastCond;
+
+	// 所有订阅者共享的输出块队列，队首块的序号，累计输出字节数
+	std::deque<OutputChunk> m_broadcastChunks;
+	unsigned long long m_broadcastFirstSeq = 0;
+	unsigned long long m_broadcastTotalBytes = 0;
+
+	// 订阅者及下一个订阅者编号
+	std::map<int, OutputSubscriber> m_subscribers;
+	int m_nextSubscriberId = 1;
+
+	// 广播线程对象，线程是否在运行，输出是否已经结束，是否要求线程退出
+	std::thread m_broadcastThread;
+	bool m_isBroadcasting = false;
+	bool m_isBroadcastEnded = false;
+	bool m_isBroadcastStopping = false;
+
+	// 会话录制专用锁、日志文件和上一条事件的时间
+	std::mutex m_recordMutex;
+	std::ofstream m_recordFile;
+	std::chrono::steady_clock::time_point m_recordLastTime;
+
 	// 线程对象
 	std::thread m_thread;
 
@@ -52,15 +159,38 @@ private:
 	// 进程句柄
 	HANDLE m_processHandle = NULL;
 
+	// 作业对象句柄，子进程及其创建的所有进程都在此作业中
+	HANDLE m_jobHandle = NULL;
+
+	// 进程结束事件，手动重置，进程未运行时为有信号状态
+	HANDLE m_hProcessExitedEvent = NULL;
+
 	// 管道句柄
 	HANDLE m_inputPipeRead = NULL;
 	HANDLE m_inputPipeWrite = NULL;
 	HANDLE m_outputPipeRead = NULL;
 	HANDLE m_outputPipeWrite = NULL;
 
-	// 结束后残留的输出
-	char* m_lastOutputBuffer;
-	DWORD m_lastOutputBufferLen;
+	// 输出块内存池，用于存放结束后残留的输出
+	OutputChunkPool m_chunkPool;
+
+	// 结束后残留的输出，每块记录数据长度和已取出的位置
+	struct LastOutputChunk {
+		char* data;
+		DWORD len;
+		DWORD pos;
+	};
+	std::vector<LastOutputChunk> m_lastOutputChunks;
+	size_t m_lastOutputHead = 0;
+
+	// 录制时的输出读取线程，输出一到达就读取并录制，读到的输出放入队列供ReadOutput取出
+	std::thread m_recordReaderThread;
+	std::mutex m_recordOutputMutex;
+	std::condition_variable m_recordOutputCond;
+	std::deque<LastOutputChunk> m_recordedChunks;
+	// 本次启动的输出是否由录制读取线程读取，以及是否已经读到EOF
+	bool m_isRecordReading = false;
+	bool m_isRecordReadEnded = false;
 
 
 	// 监视线程
@@ -99,7 +229,10 @@ private:
 			classthis->m_processStatus = false;
 
 			// 为了防止无剩余输出导致其它线程仍在等待，这里解锁可能正在等待的线程
-			classthis->UnlockOutput();
+			// 录制读取线程要读到EOF，不取消其读取，等待的线程由它结束时唤醒
+			if (!classthis->m_isRecordReading) {
+				classthis->UnlockOutput();
+			}
 
 			// 获取进程退出代码
 			DWORD exitCode = 0;
@@ -108,6 +241,26 @@ private:
 			// 设置进程退出代码
 			classthis->m_processExitCode = exitCode;
 
+			// 关闭作业对象，结束子进程遗留的所有进程，使输出管道能读到EOF
+			Clhandle_s(classthis->m_jobHandle);
+
+			// 等待录制读取线程读完剩余的输出，使退出事件录制在全部输出之后
+			if (classthis->m_recordReaderThread.joinable()) {
+				classthis->WaitRecordReaderEnd();
+			}
+
+			// 录制退出事件
+			char exitCodeBytes[4];
+			for (int i = 0; i < 4; ++i) {
+				exitCodeBytes[i] = static_cast<char>((exitCode >> (8 * i)) & 0xFF);
+			}
+			classthis->RecordEvent(SessionEventType::Exit, exitCodeBytes, 4);
+
+			// 进程已结束，不在析构时获取剩余输出
+			if (!classthis->m_isExit) {
+				classthis->GetLastOutput();
+			}
+
 			// 安全关闭句柄
 			Clhandle_s(classthis->m_inputPipeRead);
 			Clhandle_s(classthis->m_inputPipeWrite);
@@ -115,6 +268,9 @@ private:
 			Clhandle_s(classthis->m_outputPipeWrite);
 			Clhandle_s(classthis->m_processHandle);
 
+			// 通知等待进程结束的线程
+			SetEvent(classthis->m_hProcessExitedEvent);
+
 			// 判断是否在析构
 			if (classthis->m_isExit) {
 				// 释放锁后退出
@@ -122,14 +278,82 @@ private:
 				return;
 			}
 
-			// 进程已结束，获取剩余输出
-			classthis->GetLastOutput();
-
 			// 资源回收工作完成，解锁，进入下一循环
 			classthis->m_rwProcMutex.unlock();
 		}
 	}
 
+	// 录制时的输出读取线程，输出一到达就读取，以到达的时间录制，然后放入队列
+	static void RecordReaderThread(ConsoleProgram_SyncA* const classthis, HANDLE hpipe) {
+		DWORD chunkSize = static_cast<DWORD>(classthis->m_chunkPool.getChunkSize());
+		while (1) {
+			LastOutputChunk chunk;
+			chunk.data = classthis->m_chunkPool.Allocate();
+			chunk.len = 0;
+			chunk.pos = 0;
+			if (!ReadFile(hpipe, chunk.data, chunkSize, &chunk.len, NULL) || chunk.len == 0) {
+				classthis->m_chunkPool.Release(chunk.data);
+				break;
+			}
+			classthis->RecordEvent(SessionEventType::Output, chunk.data, chunk.len);
+			classthis->m_recordOutputMutex.lock();
+			classthis->m_recordedChunks.push_back(chunk);
+			classthis->m_recordOutputMutex.unlock();
+			classthis->m_recordOutputCond.notify_all();
+		}
+		classthis->m_recordOutputMutex.lock();
+		classthis->m_isRecordReadEnded = true;
+		classthis->m_recordOutputMutex.unlock();
+		classthis->m_recordOutputCond.notify_all();
+	}
+
+	// 等待录制读取线程读到EOF后回收线程(无锁)，遗留的进程仍持有管道时取消读取
+	void WaitRecordReaderEnd() {
+		std::unique_lock<std::mutex> lock(m_recordOutputMutex);
+		bool isEnded = m_recordOutputCond.wait_for(lock, std::chrono::seconds(1), [&] {
+			return m_isRecordReadEnded;
+		});
+		lock.unlock();
+		if (!isEnded) {
+			UnlockOutput();
+		}
+		m_recordReaderThread.join();
+	}
+
+	// 从录制读取线程的队列中取出输出，没有输出时等待，读到EOF且已取完时返回0
+	DWORD TakeRecordedOutput(char* buffer, DWORD size) {
+		std::unique_lock<std::mutex> lock(m_recordOutputMutex);
+		m_recordOutputCond.wait(lock, [&] {
+			return !m_recordedChunks.empty() || m_isRecordReadEnded;
+		});
+		DWORD bytesRead = 0;
+		while (bytesRead < size && !m_recordedChunks.empty()) {
+			LastOutputChunk& chunk = m_recordedChunks.front();
+			DWORD copyLen = chunk.len - chunk.pos;
+			if (copyLen > size - bytesRead) {
+				copyLen = size - bytesRead;
+			}
+			memcpy(buffer + bytesRead, chunk.data + chunk.pos, copyLen);
+			chunk.pos += copyLen;
+			bytesRead += copyLen;
+			if (chunk.pos == chunk.len) {
+				m_chunkPool.Release(chunk.data);
+				m_recordedChunks.pop_front();
+			}
+		}
+		return bytesRead;
+	}
+
+	// 释放录制读取线程队列中未取出的输出
+	void ReleaseRecordedOutput() {
+		m_recordOutputMutex.lock();
+		for (LastOutputChunk& chunk : m_recordedChunks) {
+			m_chunkPool.Release(chunk.data);
+		}
+		m_recordedChunks.clear();
+		m_recordOutputMutex.unlock();
+	}
+
 	// 解锁输出管道(无锁)
 	void UnlockOutput() {
 		CancelIoEx(m_outputPipeRead, NULL);
@@ -137,19 +361,341 @@ private:
 
 	// 获取最后的输出(无锁)
 	void GetLastOutput() {
-		DWORD bytesRead;
-		PeekNamedPipe(m_outputPipeRead, NULL, 0, NULL, &bytesRead, NULL);
-		if (bytesRead > 0) {
-			if (m_lastOutputBuffer != NULL) {
-				delete[] m_lastOutputBuffer;
+		DWORD bytesAvailable = 0;
+		PeekNamedPipe(m_outputPipeRead, NULL, 0, NULL, &bytesAvailable, NULL);
+		if (bytesAvailable > 0) {
+			// 丢弃上一次未取出的残留输出
+			ReleaseLastOutput();
+		}
+		while (bytesAvailable > 0) {
+			// 按块读入内存池分配的空间
+			LastOutputChunk chunk;
+			chunk.data = m_chunkPool.Allocate();
+			chunk.len = 0;
+			chunk.pos = 0;
+			DWORD chunkSize = static_cast<DWORD>(m_chunkPool.getChunkSize());
+			DWORD readSize = bytesAvailable < chunkSize ? bytesAvailable : chunkSize;
+			if (!ReadFile(m_outputPipeRead, chunk.data, readSize, &chunk.len, NULL) ||
+			    chunk.len == 0) {
+				m_chunkPool.Release(chunk.data);
+				break;
+			}
+			m_lastOutputChunks.push_back(chunk);
+			bytesAvailable -= chunk.len;
+		}
+	}
+
+	// 从残留的输出中取出数据(无锁)，返回取出的字节数
+	DWORD TakeLastOutput(char* buffer, DWORD size) {
+		DWORD bytesRead = 0;
+		while (bytesRead < size && m_lastOutputHead < m_lastOutputChunks.size()) {
+			LastOutputChunk& chunk = m_lastOutputChunks[m_lastOutputHead];
+			DWORD copyLen = chunk.len - chunk.pos;
+			if (copyLen > size - bytesRead) {
+				copyLen = size - bytesRead;
+			}
+			memcpy(buffer + bytesRead, chunk.data + chunk.pos, copyLen);
+			chunk.pos += copyLen;
+			bytesRead += copyLen;
+
+			// 整块取完后归还内存池
+			if (chunk.pos == chunk.len) {
+				m_chunkPool.Release(chunk.data);
+				++m_lastOutputHead;
+			}
+		}
+		if (m_lastOutputHead == m_lastOutputChunks.size()) {
+			// 全部取完，保留容量供下次使用
+			m_lastOutputChunks.clear();
+			m_lastOutputHead = 0;
+		}
+		return bytesRead;
+	}
+
+	// 释放全部残留的输出(无锁)
+	void ReleaseLastOutput() {
+		for (size_t i = m_lastOutputHead; i < m_lastOutputChunks.size(); ++i) {
+			m_chunkPool.Release(m_lastOutputChunks[i].data);
+		}
+		m_lastOutputChunks.clear();
+		m_lastOutputHead = 0;
+	}
+
+	// 等待进程结束，返回进程是否在超时时间内结束
+	bool WaitProcessExit(DWORD timeoutMilliseconds) {
+		return WaitForSingleObject(m_hProcessExitedEvent,
+		                           timeoutMilliseconds) == WAIT_OBJECT_0;
+	}
+
+	// 生成停止结果，计算从开始停止到现在的耗时
+	static StopResult MakeStopResult(StopStep step,
+	                                 std::chrono::steady_clock::time_point start) {
+		StopResult result;
+		result.step = step;
+		result.elapsedMilliseconds = static_cast<DWORD>(
+		    std::chrono::duration_cast<std::chrono::milliseconds>
+		    (std::chrono::steady_clock::now() - start).count());
+		return result;
+	}
+
+
+	// 把数据全部写入输入管道(无锁)，返回是否完整写入
+	bool WriteAll(const char* data, DWORD len) {
+		while (len > 0) {
+			DWORD bytesWritten = 0;
+			if (!WriteFile(m_inputPipeWrite, data, len, &bytesWritten, NULL)) {
+				return false;
 			}
-			m_lastOutputBuffer = new char[bytesRead + 1];
-			m_lastOutputBufferLen = bytesRead;
-			ReadFile(m_outputPipeRead, m_lastOutputBuffer, bytesRead, &bytesRead, NULL);
-			m_lastOutputBuffer[bytesRead] = 0;
+			data += bytesWritten;
+			len -= bytesWritten;
 		}
+		return true;
 	}
 
+	// 读取指定长度的输出，返回是否完整读取，进程结束导致数据不足时返回false
+	bool ReadOutputExact(char* buffer, DWORD size) {
+		DWORD total = 0;
+		while (total < size) {
+			DWORD bytesRead = ReadOutput(buffer + total, size - total);
+			if (bytesRead == 0) {
+				// 进程仍在运行说明输出管道已经关闭
+				if (getProcessStatus()) {
+					return false;
+				}
+				// 进程已结束，取出剩余的输出
+				bytesRead = ReadOutput(buffer + total, size - total);
+				if (bytesRead == 0) {
+					return false;
+				}
+			}
+			total += bytesRead;
+		}
+		return true;
+	}
+
+	// 编码帧长度头，返回长度头的字节数，长度超出格式范围时返回0
+	static DWORD EncodeFrameHeader(DWORD len, FrameHeader header, char* out) {
+		switch (header) {
+			case FrameHeader::U16LE:
+			case FrameHeader::U16BE:
+				if (len > 0xFFFF) {
+					return 0;
+				}
+				for (int i = 0; i < 2; ++i) {
+					int shift = (header == FrameHeader::U16LE) ? (8 * i) : (8 * (1 - i));
+					out[i] = static_cast<char>((len >> shift) & 0xFF);
+				}
+				return 2;
+			case FrameHeader::U32LE:
+			case FrameHeader::U32BE:
+				for (int i = 0; i < 4; ++i) {
+					int shift = (header == FrameHeader::U32LE) ? (8 * i) : (8 * (3 - i));
+					out[i] = static_cast<char>((len >> shift) & 0xFF);
+				}
+				return 4;
+			case FrameHeader::Varint:
+			default:
+				return EncodeVarint(len, out);
+		}
+	}
+
+	// 编码变长整数，每字节低7位存数据，最高位表示后面还有字节，返回字节数(最多10字节)
+	static DWORD EncodeVarint(unsigned long long value, char* out) {
+		DWORD outLen = 0;
+		do {
+			unsigned char byte = value & 0x7F;
+			value >>= 7;
+			if (value != 0) {
+				byte |= 0x80;
+			}
+			out[outLen++] = static_cast<char>(byte);
+		} while (value != 0);
+		return outLen;
+	}
+
+	// 录制一条会话事件，未在录制时直接返回
+	void RecordEvent(SessionEventType type, const char* data, DWORD len) {
+		m_recordMutex.lock();
+		if (!m_recordFile.is_open()) {
+			m_recordMutex.unlock();
+			return;
+		}
+
+		// 计算距上一条事件的微秒数
+		auto now = std::chrono::steady_clock::now();
+		unsigned long long delta = std::chrono::duration_cast<std::chrono::microseconds>
+		                           (now - m_recordLastTime).count();
+		m_recordLastTime = now;
+
+		// 写入事件头和数据
+		char eventHeader[21];
+		eventHeader[0] = static_cast<char>(type);
+		DWORD headerLen = 1;
+		headerLen += EncodeVarint(delta, eventHeader + headerLen);
+		headerLen += EncodeVarint(len, eventHeader + headerLen);
+		m_recordFile.write(eventHeader, headerLen);
+		m_recordFile.write(data, len);
+
+		m_recordMutex.unlock();
+	}
+
+	// 读取并解码帧长度头，返回是否成功
+	bool ReadFrameHeader(FrameHeader header, DWORD& len) {
+		unsigned char bytes[5];
+		len = 0;
+		switch (header) {
+			case FrameHeader::U16LE:
+			case FrameHeader::U16BE:
+			case FrameHeader::U32LE:
+			case FrameHeader::U32BE: {
+				bool isLittleEndian = (header == FrameHeader::U16LE ||
+				                       header == FrameHeader::U32LE);
+				int headerLen = (header == FrameHeader::U16LE ||
+				                 header == FrameHeader::U16BE) ? 2 : 4;
+				if (!ReadOutputExact(reinterpret_cast<char*>(bytes), headerLen)) {
+					return false;
+				}
+				for (int i = 0; i < headerLen; ++i) {
+					int shift = isLittleEndian ? (8 * i) : (8 * (headerLen - 1 - i));
+					len |= static_cast<DWORD>(bytes[i]) << shift;
+				}
+				return true;
+			}
+			case FrameHeader::Varint:
+			default:
+				// 32位长度最多5个字节，第5个字节只有低4位有效，更大的值超出32位
+				for (int i = 0; i < 5; ++i) {
+					if (!ReadOutputExact(reinterpret_cast<char*>(bytes + i), 1)) {
+						return false;
+					}
+					if (i == 4 && bytes[i] > 0x0F) {
+						return false;
+					}
+					len |= static_cast<DWORD>(bytes[i] & 0x7F) << (7 * i);
+					if ((bytes[i] & 0x80) == 0) {
+						return true;
+					}
+				}
+				return false;
+		}
+	}
+
+	// 输出广播线程，把读到的输出放入共享队列供所有订阅者读取
+	static void BroadcastThread(ConsoleProgram_SyncA* const classthis) {
+		// 等待进程启动，Start、取消订阅和析构时会唤醒本线程
+		std::unique_lock<std::mutex> lock(classthis->m_broadcastMutex);
+		classthis->m_broadcastCond.wait(lock, [&] {
+			return classthis->m_isBroadcastStopping || classthis->m_subscribers.empty() ||
+			       classthis->getProcessStatus();
+		});
+		bool isStopping = classthis->m_isBroadcastStopping || classthis->m_subscribers.empty();
+		lock.unlock();
+		if (isStopping) {
+			classthis->EndBroadcast();
+			return;
+		}
+
+		// 读取输出直到进程结束
+		char buffer[4096];
+		while (1) {
+			DWORD bytesRead = classthis->ReadOutput(buffer, sizeof(buffer));
+			if (bytesRead == 0) {
+				// 进程仍在运行说明输出管道已经关闭
+				if (classthis->getProcessStatus()) {
+					break;
+				}
+				// 进程已结束，取出剩余的输出
+				bytesRead = classthis->ReadOutput(buffer, sizeof(buffer));
+				if (bytesRead == 0) {
+					break;
+				}
+			}
+			if (!classthis->PublishOutput(std::make_shared<const std::string>(buffer,
+			                              bytesRead))) {
+				break;
+			}
+		}
+		classthis->EndBroadcast();
+	}
+
+	// 计算订阅者落后的字节数(无锁)
+	unsigned long long GetSubscriberLag(const OutputSubscriber& subscriber) {
+		unsigned long long index = subscriber.cursor - m_broadcastFirstSeq;
+		if (index >= m_broadcastChunks.size()) {
+			return 0;
+		}
+		const OutputChunk& chunk = m_broadcastChunks[index];
+		return m_broadcastTotalBytes - (chunk.endOffset - chunk.data->size());
+	}
+
+	// 释放所有订阅者都已读过的输出块(无锁)
+	void TrimBroadcastChunks() {
+		unsigned long long minCursor = m_broadcastFirstSeq + m_broadcastChunks.size();
+		for (auto& item : m_subscribers) {
+			if (item.second.cursor < minCursor) {
+				minCursor = item.second.cursor;
+			}
+		}
+		while (m_broadcastFirstSeq < minCursor) {
+			m_broadcastChunks.pop_front();
+			++m_broadcastFirstSeq;
+		}
+	}
+
+	// 发布一块输出，返回是否继续广播
+	bool PublishOutput(std::shared_ptr<const std::string> data) {
+		std::unique_lock<std::mutex> lock(m_broadcastMutex);
+
+		// 等待阻塞模式的订阅者追上
+		m_broadcastCond.wait(lock, [&] {
+			if (m_isBroadcastStopping) {
+				return true;
+			}
+			for (auto& item : m_subscribers) {
+				unsigned long long lag = GetSubscriberLag(item.second);
+				if (item.second.overflow == SubscriberOverflow::Block &&
+				    lag > 0 && lag + data->size() > item.second.maxLagBytes) {
+					return false;
+				}
+			}
+			return true;
+		});
+		if (m_isBroadcastStopping) {
+			return false;
+		}
+
+		// 放入共享队列
+		m_broadcastTotalBytes += data->size();
+		OutputChunk chunk;
+		chunk.data = std::move(data);
+		chunk.endOffset = m_broadcastTotalBytes;
+		m_broadcastChunks.push_back(std::move(chunk));
+
+		// 丢弃模式的订阅者落后过多时，跳过其最旧的输出
+		for (auto& item : m_subscribers) {
+			OutputSubscriber& subscriber = item.second;
+			while (subscriber.overflow == SubscriberOverflow::Drop &&
+			       GetSubscriberLag(subscriber) > subscriber.maxLagBytes) {
+				subscriber.droppedBytes +=
+				    m_broadcastChunks[subscriber.cursor - m_broadcastFirstSeq].data->size();
+				++subscriber.cursor;
+			}
+		}
+		TrimBroadcastChunks();
+
+		// 唤醒等待输出的订阅者
+		m_broadcastCond.notify_all();
+		return true;
+	}
+
+	// 标记输出结束，唤醒所有等待的订阅者
+	void EndBroadcast() {
+		m_broadcastMutex.lock();
+		m_isBroadcastEnded = true;
+		m_isBroadcasting = false;
+		m_broadcastMutex.unlock();
+		m_broadcastCond.notify_all();
+	}
 
 public:
 
@@ -161,8 +707,7 @@ public:
 	                              const std::string& workingDirectory = "",
 	                              const std::string& commandLineArgument = "")
 		: m_programPath(programPath), m_workingDirectory(workingDirectory),
-		  m_commandLineArgument(commandLineArgument), m_processExitCode(STILL_ACTIVE),
-		  m_lastOutputBuffer(NULL), m_lastOutputBufferLen(0) {
+		  m_commandLineArgument(commandLineArgument), m_processExitCode(STILL_ACTIVE) {
 		// 处理工作目录
 		if (workingDirectory.empty()) {
 			size_t found = programPath.find_last_of("/\\");
@@ -170,6 +715,8 @@ public:
 				this->m_workingDirectory = programPath.substr(0, found);
 			}
 		}
+		// 创建进程结束事件，初始为有信号状态
+		m_hProcessExitedEvent = CreateEvent(NULL, TRUE, TRUE, NULL);
 		// 启动监视线程
 		m_isExit = false;
 		m_processStatus = false;
@@ -185,26 +732,52 @@ public:
 		// 停止控制台程序运行
 		Stop();
 
+		// 停止输出广播
+		m_broadcastMutex.lock();
+		m_isBroadcastStopping = true;
+		m_broadcastMutex.unlock();
+		m_broadcastCond.notify_all();
+		if (m_broadcastThread.joinable()) {
+			m_broadcastThread.join();
+		}
+
 		// 等待线程结束运行
 		m_thread.join();
 
-		// 释放指针内容
+		// 释放残留的输出
 		m_rwProcMutex.lock();
-		if (m_lastOutputBuffer != NULL) {
-			delete[] m_lastOutputBuffer;
-		}
+		ReleaseLastOutput();
 		m_rwProcMutex.unlock();
+		ReleaseRecordedOutput();
+
+		// 关闭进程结束事件
+		Clhandle_s(m_hProcessExitedEvent);
 
 		// 析构工作完成
 	}
 
 	// 启动进程
 	bool Start() {
+		return Start(NULL, NULL);
+	}
+
+	/*
+	 *  启动进程，并把标准输入、标准输出重定向到外部句柄，用于把多个进程连接成流水线
+	 *  句柄为NULL时使用本类创建的管道，此时才能使用Input、PullOutput等函数
+	 *  句柄的所有权不转移，调用者需要在启动后自行关闭，句柄本身始终保持不可继承
+	 */
+	bool Start(HANDLE stdinHandle, HANDLE stdoutHandle) {
 		// 判断进程是否启动
 		if (getProcessStatus()) {
 			return false;
 		}
 
+		// 丢弃上一个进程留下的、已读取长度头但还未读取数据的帧
+		m_frameReadMutex.lock();
+		m_hasPendingFrame = false;
+		m_pendingFrameLen = 0;
+		m_frameReadMutex.unlock();
+
 		// 获取锁
 		m_rwProcMutex.lock();
 
@@ -220,8 +793,9 @@ public:
 		securityAttributes.bInheritHandle = TRUE;
 		securityAttributes.lpSecurityDescriptor = NULL;
 
-		// 附带安全标识符创建输入管道
-		if (!CreatePipe(&m_inputPipeRead, &m_inputPipeWrite, &securityAttributes, 0)) {
+		// 附带安全标识符创建输入管道，指定了外部句柄时不需要创建
+		if (stdinHandle == NULL &&
+		    !CreatePipe(&m_inputPipeRead, &m_inputPipeWrite, &securityAttributes, 0)) {
 			// 安全关闭句柄
 			Clhandle_s(m_inputPipeRead);
 			Clhandle_s(m_inputPipeWrite);
@@ -231,8 +805,9 @@ public:
 			return false;
 		}
 
-		// 附带安全标识符创建输出管道
-		if (!CreatePipe(&m_outputPipeRead, &m_outputPipeWrite, &securityAttributes, 0)) {
+		// 附带安全标识符创建输出管道，指定了外部句柄时不需要创建
+		if (stdoutHandle == NULL &&
+		    !CreatePipe(&m_outputPipeRead, &m_outputPipeWrite, &securityAttributes, 0)) {
 			// 安全关闭句柄
 			Clhandle_s(m_inputPipeRead);
 			Clhandle_s(m_inputPipeWrite);
@@ -244,16 +819,51 @@ public:
 			return false;
 		}
 
-		// 初始化启动信息结构体
-		STARTUPINFOA startupInfo;
-		ZeroMemory(&startupInfo, sizeof(startupInfo));
-		startupInfo.cb = sizeof(startupInfo);
+		// 父进程使用的管道端不能被子进程继承，否则关闭输入管道时子进程收不到EOF
+		SetHandleInformation(m_inputPipeWrite, HANDLE_FLAG_INHERIT, 0);
+		SetHandleInformation(m_outputPipeRead, HANDLE_FLAG_INHERIT, 0);
+
+		// 句柄列表中的句柄须为可继承的，外部句柄复制出可继承的副本，创建进程后关闭
+		// 外部句柄本身不改变继承属性，不会被其他线程同时创建的进程继承
+		HANDLE inheritedStdin = m_inputPipeRead;
+		HANDLE inheritedStdout = m_outputPipeWrite;
+		if (stdinHandle != NULL &&
+		    !DuplicateHandle(GetCurrentProcess(), stdinHandle, GetCurrentProcess(),
+		                     &inheritedStdin, 0, TRUE, DUPLICATE_SAME_ACCESS)) {
+			inheritedStdin = NULL;
+		}
+		if (stdoutHandle != NULL &&
+		    !DuplicateHandle(GetCurrentProcess(), stdoutHandle, GetCurrentProcess(),
+		                     &inheritedStdout, 0, TRUE, DUPLICATE_SAME_ACCESS)) {
+			inheritedStdout = NULL;
+		}
 
-		// 设置输入输出管道，设置使用自定义管道标志位
-		startupInfo.hStdInput = m_inputPipeRead;
-		startupInfo.hStdOutput = m_outputPipeWrite;
-		startupInfo.hStdError = m_outputPipeWrite;
-		startupInfo.dwFlags |= STARTF_USESTDHANDLES;
+		// 子进程只通过句柄列表继承标准输入和标准输出两个句柄
+		HANDLE handleList[2] = { inheritedStdin, inheritedStdout };
+		SIZE_T attributeListSize = 0;
+		InitializeProcThreadAttributeList(NULL, 1, 0, &attributeListSize);
+		std::vector<char> attributeListBuffer(attributeListSize);
+		LPPROC_THREAD_ATTRIBUTE_LIST attributeList =
+			reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeListBuffer.data());
+		bool isAttributeListReady =
+			inheritedStdin != NULL && inheritedStdout != NULL &&
+			InitializeProcThreadAttributeList(attributeList, 1, 0, &attributeListSize);
+		if (isAttributeListReady &&
+		    !UpdateProcThreadAttribute(attributeList, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+		                               handleList, sizeof(handleList), NULL, NULL)) {
+			DeleteProcThreadAttributeList(attributeList);
+			isAttributeListReady = false;
+		}
+
+		// 初始化启动信息结构体，设置输入输出管道，设置使用自定义管道标志位
+		STARTUPINFOEXA startupInfo;
+		ZeroMemory(&startupInfo, sizeof(startupInfo));
+		startupInfo.StartupInfo.cb = sizeof(startupInfo);
+		startupInfo.StartupInfo.hStdInput = inheritedStdin;
+		startupInfo.StartupInfo.hStdOutput = inheritedStdout;
+		startupInfo.StartupInfo.hStdError = inheritedStdout;
+		startupInfo.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
+		startupInfo.lpAttributeList = attributeList;
 
 		// 初始化进程信息结构体
 		PROCESS_INFORMATION processInfo;
@@ -268,10 +878,36 @@ public:
 		strncpy(commandLine_c, commandLine.c_str(), commandLine.size());
 		commandLine_c[commandLine.size()] = 0;
 
-		// 创建进程
-		if (!CreateProcessA(NULL, commandLine_c, NULL, NULL, TRUE,
-		                    CREATE_NO_WINDOW, NULL, m_workingDirectory.c_str(),
-		                    &startupInfo, &processInfo)) {
+		// 创建作业对象，关闭作业时结束其中的所有进程
+		m_jobHandle = CreateJobObject(NULL, NULL);
+		if (m_jobHandle != NULL) {
+			JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobLimit;
+			ZeroMemory(&jobLimit, sizeof(jobLimit));
+			jobLimit.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+			SetInformationJobObject(m_jobHandle, JobObjectExtendedLimitInformation,
+			                        &jobLimit, sizeof(jobLimit));
+		}
+
+		// 挂起创建进程，加入作业后再继续执行，保证其创建的进程都在作业中
+		BOOL isCreated = isAttributeListReady &&
+		                 CreateProcessA(NULL, commandLine_c, NULL, NULL, TRUE,
+		                                CREATE_NO_WINDOW | CREATE_SUSPENDED |
+		                                EXTENDED_STARTUPINFO_PRESENT, NULL,
+		                                m_workingDirectory.c_str(), &startupInfo.StartupInfo,
+		                                &processInfo);
+
+		// 释放句柄列表，关闭外部句柄的副本
+		if (isAttributeListReady) {
+			DeleteProcThreadAttributeList(attributeList);
+		}
+		if (stdinHandle != NULL) {
+			Clhandle_s(inheritedStdin);
+		}
+		if (stdoutHandle != NULL) {
+			Clhandle_s(inheritedStdout);
+		}
+
+		if (!isCreated) {
 			// 释放命令行文本
 			delete[] commandLine_c;
 
@@ -280,6 +916,7 @@ public:
 			Clhandle_s(m_inputPipeWrite);
 			Clhandle_s(m_outputPipeRead);
 			Clhandle_s(m_outputPipeWrite);
+			Clhandle_s(m_jobHandle);
 
 			// 解锁
 			m_rwProcMutex.unlock();
@@ -289,17 +926,44 @@ public:
 		// 释放命令行文本
 		delete[] commandLine_c;
 
-		// 关闭线程句柄
+		// 加入作业，失败时(如旧系统不支持嵌套作业)只管理子进程本身
+		if (m_jobHandle != NULL &&
+		    !AssignProcessToJobObject(m_jobHandle, processInfo.hProcess)) {
+			Clhandle_s(m_jobHandle);
+		}
+
+		// 继续执行进程，然后关闭线程句柄
+		ResumeThread(processInfo.hThread);
 		CloseHandle(processInfo.hThread);
 
+		// 关闭子进程使用的管道端，所有子进程都退出后输出管道才能读到EOF
+		Clhandle_s(m_inputPipeRead);
+		Clhandle_s(m_outputPipeWrite);
+
 		// 保存进程句柄
 		m_processHandle = processInfo.hProcess;
 
+		// 录制时由录制读取线程读取输出，输出到达时即录制，时间戳不受调用者读取时机的影响
+		ReleaseRecordedOutput();
+		m_recordMutex.lock();
+		m_isRecordReading = m_recordFile.is_open() && m_outputPipeRead != NULL;
+		m_recordMutex.unlock();
+		if (m_isRecordReading) {
+			m_isRecordReadEnded = false;
+			m_recordReaderThread = std::thread(&RecordReaderThread, this, m_outputPipeRead);
+		}
+
 		// 设置进程状态
 		m_processStatus = true;
+		ResetEvent(m_hProcessExitedEvent);
 
 		// 解锁
 		m_rwProcMutex.unlock();
+
+		// 唤醒等待进程启动的广播线程，先获取广播锁，保证不会错过正在检查状态的线程
+		m_broadcastMutex.lock();
+		m_broadcastMutex.unlock();
+		m_broadcastCond.notify_all();
 		return true;
 	}
 
@@ -307,103 +971,90 @@ public:
 	 *  停止进程运行，支持两种方式
 	 *  1.传入需要输入的命令(需要包含换行符)，以及非0的超时时间。
 	 *  将输入命令并且等待进程自行结束，如果超时就强制结束进程
-	 *  注意：超时时间大于0小于20ms按20ms计
+	 *  注意：超时时间小于0按1ms计
 	 *  2.不传参数或传入其他情况的参数则强制结束进程
 	 *  返回是否超时，如果未指定超时时间或超时时间为0，则始终返回false
 	 */
 	bool Stop(const std::string& input = "", int timeoutMilliseconds = 0) {
-		// 获取锁
-		m_rwProcMutex.lock_shared();
+		StopPolicy policy;
+		bool isTimed = (!input.empty()) && (timeoutMilliseconds != 0);
+		if (isTimed) {
+			policy.input = input;
+			policy.inputTimeout = timeoutMilliseconds > 0 ? timeoutMilliseconds : 1;
+		}
+		StopResult result = Stop(policy);
+		return isTimed && (result.step == StopStep::Terminate ||
+		                   result.step == StopStep::Failed);
+	}
 
-		// 判断参数情况
-		if ( (!input.empty()) && (timeoutMilliseconds != 0) ) {
-			// 先尝试输入命令，等待进程自然结束
+	/*
+	 *  按升级策略停止进程运行
+	 *  依次执行：输入停止命令 -> 关闭输入管道(EOF) -> 强制结束进程(包括其创建的所有进程)
+	 *  每一步都通过进程结束事件等待，进程在某一步的时限内结束则不再继续升级
+	 *  返回使进程结束的步骤和耗时，所有步骤完成后进程仍在运行时步骤为Failed
+	 */
+	StopResult Stop(const StopPolicy& policy) {
+		auto start = std::chrono::steady_clock::now();
 
-			// 判断状态，进程已经结束就没有必要再结束了
-			if (!m_processStatus) {
-				m_rwProcMutex.unlock_shared();
-				return false;
-			}
+		// 判断状态，进程已经结束就没有必要再结束了
+		if (!getProcessStatus()) {
+			return MakeStopResult(StopStep::None, start);
+		}
 
-			// 输入命令
-			DWORD bytesWritten;
-			WriteFile(m_inputPipeWrite, input.c_str(), input.size(), &bytesWritten, NULL);
+		// 已经执行过的最后一个步骤
+		StopStep lastStep = StopStep::None;
 
-			// 释放锁
-			m_rwProcMutex.unlock_shared();
+		// 输入停止命令，等待进程自然结束
+		if ( (!policy.input.empty()) && (policy.inputTimeout != 0) ) {
+			lastStep = StopStep::Input;
+			Input(policy.input);
+			if (WaitProcessExit(policy.inputTimeout)) {
+				return MakeStopResult(StopStep::Input, start);
+			}
+		}
 
-			// 计时等待进程结束
-			bool isTimeout = false;
-			do {
-				// 睡眠20ms
-				std::this_thread::sleep_for(std::chrono::milliseconds(20));
-				timeoutMilliseconds -= 20;
-				if (timeoutMilliseconds <= 0) {
-					isTimeout = true;
-					break;
-				}
-			} while (getProcessStatus());
-
-			// 判断是自然结束还是超时了
-			if (isTimeout) {
-				// 超时了就强制结束进程
-
-				// 获取锁
-				m_rwProcMutex.lock_shared();
-
-				// 判断进程是否结束
-				if (m_processStatus) {
-					// 强制结束进程
-					TerminateProcess(m_processHandle, 0);
-
-					// 结束进程后释放锁
-					m_rwProcMutex.unlock_shared();
-
-					// 等待进程结束
-					int cnt = 0;
-					do {
-						// 睡眠20ms
-						std::this_thread::sleep_for(std::chrono::milliseconds(20));
-						++cnt;
-						if (cnt > 6000) {
-							throw 1;
-						}
-					} while (getProcessStatus());
-				} else {
-					// 直接解锁后返回
-					m_rwProcMutex.unlock_shared();
-				}
-				return true;
+		// 关闭输入管道，使进程读到EOF，等待进程自然结束
+		if (policy.closeInputTimeout != 0) {
+			lastStep = StopStep::CloseInput;
+			m_rwProcMutex.lock();
+			if (m_processStatus) {
+				Clhandle_s(m_inputPipeWrite);
 			}
-		} else {
-			// 判断状态，进程已经结束就没有必要再结束了
-			if (!m_processStatus) {
-				m_rwProcMutex.unlock_shared();
-				return false;
+			m_rwProcMutex.unlock();
+			if (WaitProcessExit(policy.closeInputTimeout)) {
+				return MakeStopResult(StopStep::CloseInput, start);
 			}
+		}
+
+		// 获取锁
+		m_rwProcMutex.lock_shared();
+
+		// 判断进程是否结束，等待期间可能已经结束
+		if (!m_processStatus) {
+			m_rwProcMutex.unlock_shared();
+			return MakeStopResult(lastStep, start);
+		}
 
-			// 强制结束进程
+		// 强制结束进程，有作业时结束整个进程树
+		if (m_jobHandle != NULL) {
+			TerminateJobObject(m_jobHandle, 0);
+		} else {
 			TerminateProcess(m_processHandle, 0);
-			if (m_isExit) {
-				m_rwProcMutex.unlock_shared();
-				return false;
-			}
-			// 释放锁
+		}
+		if (m_isExit) {
+			// 正在析构，监视线程负责回收
 			m_rwProcMutex.unlock_shared();
+			return MakeStopResult(StopStep::Terminate, start);
+		}
 
-			// 等待进程结束
-			int cnt = 0;
-			do {
-				// 睡眠20ms
-				std::this_thread::sleep_for(std::chrono::milliseconds(20));
-				++cnt;
+		// 释放锁
+		m_rwProcMutex.unlock_shared();
 
-				if (cnt > 6000) {
-					throw 1;
-				}
-			} while (getProcessStatus());
+		// 等待进程结束
+		if (policy.terminateTimeout != 0 && !WaitProcessExit(policy.terminateTimeout)) {
+			return MakeStopResult(StopStep::Failed, start);
 		}
-		return false;
+		return MakeStopResult(StopStep::Terminate, start);
 	}
 
 	/*
@@ -423,6 +1074,7 @@ public:
 		// 把文本写入输入管道
 		DWORD bytesWritten;
 		WriteFile(m_inputPipeWrite, input, len, &bytesWritten, NULL);
+		RecordEvent(SessionEventType::Input, input, len);
 
 		// 解锁
 		m_rwProcMutex.unlock_shared();
@@ -445,6 +1097,7 @@ public:
 		// 把文本写入输入管道
 		DWORD bytesWritten;
 		WriteFile(m_inputPipeWrite, input.c_str(), input.size(), &bytesWritten, NULL);
+		RecordEvent(SessionEventType::Input, input.c_str(), input.size());
 
 		// 解锁
 		m_rwProcMutex.unlock_shared();
@@ -487,6 +1140,8 @@ public:
 
 		// 写入换行符
 		WriteFile(m_inputPipeWrite, newline, strlen(newline), &bytesWritten, NULL);
+		RecordEvent(SessionEventType::Input, input.c_str(), input.size());
+		RecordEvent(SessionEventType::Input, newline, strlen(newline));
 
 		// 解锁
 		m_rwProcMutex.unlock_shared();
@@ -500,9 +1155,26 @@ public:
 	 *  缓冲区大小必须大于1，否则行为未定义
 	 */
 	DWORD PullOutput(char* buffer, DWORD bufferSize) {
+		DWORD bytesRead = ReadOutput(buffer, bufferSize - 1);
+		buffer[bytesRead] = '\0';
+		return bytesRead;
+	}
+
+	/*
+	 *  读取原始输出
+	 *  与PullOutput相同，但不在末尾添加\0，数据中的\0也原样保留，适合二进制数据
+	 *  返回实际读取的字节数目。如果在等待过程中进程自然结束，那么返回0
+	 */
+	DWORD ReadOutput(char* buffer, DWORD size) {
 		// 获取读锁
 		m_rwProcMutex.lock_shared();
 
+		// 输出由录制读取线程读取时从其队列中取出，进程结束后队列中的剩余输出仍可取出
+		if (m_isRecordReading) {
+			m_rwProcMutex.unlock_shared();
+			return TakeRecordedOutput(buffer, size);
+		}
+
 		// 判断进程是否启动
 		if (!m_processStatus) {
 			// 释放读锁
@@ -514,52 +1186,18 @@ public:
 			// 再次判断状态，防止等待时状态更改
 			if (m_processStatus) {
 				m_rwProcMutex.unlock();
-				return PullOutput(buffer, bufferSize);
+				return ReadOutput(buffer, size);
 			}
 
-			if (m_lastOutputBuffer != NULL) {
-				// 说明有剩下的数据没有取出，这里模拟从管道取出数据
-				if (m_lastOutputBufferLen < bufferSize) {
-					// 一次性搞定，直接复制进去即可
-					strncpy(buffer, m_lastOutputBuffer, m_lastOutputBufferLen);
-					buffer[m_lastOutputBufferLen] = 0;
-
-					// 删除字符串的内存空间
-					delete[] m_lastOutputBuffer;
-					m_lastOutputBuffer = NULL;
-
-					// 解锁
-					m_rwProcMutex.unlock();
-
-					return m_lastOutputBufferLen;
-				} else {
-					// 需要分次拷贝
-
-					// 复制缓冲区能承受的最大长度
-					strncpy(buffer, m_lastOutputBuffer, bufferSize - 1);
-					buffer[bufferSize - 1] = 0;
-
-					// 新开辟空间存剩下的部分
-					m_lastOutputBufferLen = m_lastOutputBufferLen - bufferSize + 1;
-					char* tmp = new char [m_lastOutputBufferLen + 1];
+			// 说明有剩下的数据没有取出，这里模拟从管道取出数据
+			DWORD bytesRead = TakeLastOutput(buffer, size);
 
-					// 复制到新空间，并且释放旧的
-					strncpy(tmp, m_lastOutputBuffer + bufferSize - 1,
-					        m_lastOutputBufferLen);
-					tmp[m_lastOutputBufferLen] = 0;
-					delete[] m_lastOutputBuffer;
-					m_lastOutputBuffer = tmp;
-
-					// 解锁
-					m_rwProcMutex.unlock();
-
-					return bufferSize - 1;
-				}
-			}
 			// 解锁
 			m_rwProcMutex.unlock();
-			buffer[0] = '\0';
-			return 0;
+			if (bytesRead > 0) {
+				RecordEvent(SessionEventType::Output, buffer, bytesRead);
+			}
+			return bytesRead;
 		}
 
 		HANDLE hpipe = m_outputPipeRead;
@@ -574,21 +1212,260 @@ public:
 		if (hpipe != m_outputPipeRead) {
 			// 管道变了，解锁退出
 			m_outputMutex.unlock();
-			buffer[0] = '\0';
 			return 0;
 		}
 
 		// 读入数据
-		DWORD bytesRead;
-		ReadFile(hpipe, buffer, bufferSize - 1, &bytesRead, NULL);
+		DWORD bytesRead = 0;
+		ReadFile(hpipe, buffer, size, &bytesRead, NULL);
 
 		// 退出读取专用锁
 		m_outputMutex.unlock();
 
-		buffer[bytesRead] = '\0';
+		if (bytesRead > 0) {
+			RecordEvent(SessionEventType::Output, buffer, bytesRead);
+		}
 		return bytesRead;
 	}
 
+	/*
+	 *  写入一帧二进制数据，格式为：长度头 + 数据
+	 *  长度头格式未指定时，默认采用4字节小端序
+	 *  多个线程写帧时互不穿插，但不与Input系列函数同步
+	 *  返回是否完整写入，长度超出长度头能表示的范围时不写入并返回false
+	 */
+	bool WriteFrame(const char* data, DWORD len,
+	                FrameHeader header = FrameHeader::U32LE) {
+		// 编码长度头
+		char headerBuffer[5];
+		DWORD headerLen = EncodeFrameHeader(len, header, headerBuffer);
+		if (headerLen == 0) {
+			return false;
+		}
+
+		// 获取写帧专用锁，然后获取读锁
+		m_frameWriteMutex.lock();
+		m_rwProcMutex.lock_shared();
+
+		// 判断进程是否启动，未启动就直接返回
+		if (!m_processStatus) {
+			m_rwProcMutex.unlock_shared();
+			m_frameWriteMutex.unlock();
+			return false;
+		}
+
+		// 写入长度头和数据
+		bool isWritten = WriteAll(headerBuffer, headerLen) && WriteAll(data, len);
+		RecordEvent(SessionEventType::Input, headerBuffer, headerLen);
+		RecordEvent(SessionEventType::Input, data, len);
+
+		// 解锁
+		m_rwProcMutex.unlock_shared();
+		m_frameWriteMutex.unlock();
+		return isWritten;
+	}
+
+	/*
+	 *  读取一帧二进制数据到调用者提供的缓冲区，不添加\0
+	 *  帧长度[out]：返回这一帧数据的长度
+	 *  缓冲区不足时返回false，帧长度为所需的缓冲区大小，这一帧保留到下次读取
+	 *  进程结束导致读不到完整的帧或变长长度头超出32位时返回false，帧长度为0
+	 */
+	bool ReadFrame(char* buffer, DWORD bufferSize, DWORD& frameLen,
+	               FrameHeader header = FrameHeader::U32LE) {
+		// 进入读帧专用锁
+		m_frameReadMutex.lock();
+
+		// 读取长度头
+		if (!m_hasPendingFrame) {
+			if (!ReadFrameHeader(header, m_pendingFrameLen)) {
+				m_frameReadMutex.unlock();
+				frameLen = 0;
+				return false;
+			}
+			m_hasPendingFrame = true;
+		}
+
+		// 判断缓冲区是否足够
+		frameLen = m_pendingFrameLen;
+		if (frameLen > bufferSize) {
+			m_frameReadMutex.unlock();
+			return false;
+		}
+
+		// 直接读入调用者的缓冲区
+		m_hasPendingFrame = false;
+		bool isRead = ReadOutputExact(buffer, frameLen);
+		if (!isRead) {
+			frameLen = 0;
+		}
+
+		// 退出读帧专用锁
+		m_frameReadMutex.unlock();
+		return isRead;
+	}
+
+	/*
+	 *  读取一帧二进制数据到string
+	 *  复用string已有的容量，反复使用同一个string读取时不会每帧分配内存
+	 *  进程结束导致读不到完整的帧或变长长度头超出32位时返回false，string被清空
+	 *  最大帧长度[in]：长度头超过该值时不分配内存，返回false，string被清空，这一帧保留到下次读取
+	 *                 防止损坏的长度头导致分配大量内存，可以改用提供缓冲区的ReadFrame读取
+	 */
+	bool ReadFrame(std::string& frame, FrameHeader header = FrameHeader::U32LE,
+	               DWORD maxFrameLen = 1 << 26) {
+		// 进入读帧专用锁
+		m_frameReadMutex.lock();
+
+		// 读取长度头
+		if (!m_hasPendingFrame) {
+			if (!ReadFrameHeader(header, m_pendingFrameLen)) {
+				m_frameReadMutex.unlock();
+				frame.clear();
+				return false;
+			}
+			m_hasPendingFrame = true;
+		}
+
+		// 拒绝超过最大长度的帧
+		if (m_pendingFrameLen > maxFrameLen) {
+			m_frameReadMutex.unlock();
+			frame.clear();
+			return false;
+		}
+
+		// 读取数据
+		m_hasPendingFrame = false;
+		frame.resize(m_pendingFrameLen);
+		bool isRead = ReadOutputExact(&frame[0], m_pendingFrameLen);
+		if (!isRead) {
+			frame.clear();
+		}
+
+		// 退出读帧专用锁
+		m_frameReadMutex.unlock();
+		return isRead;
+	}
+
+	/*
+	 *  开始录制会话
+	 *  之后的每次输入、每段输出和进程结束都会连同单调时钟时间戳写入二进制日志文件
+	 *  日志可以用ConsoleProgram_ReplayA读取和回放，回放以启动进程为起点，所以应在Start之前开始录制
+	 *  在Start之前开始录制时由内部线程读取输出，输出的时间戳是输出到达的时间，而不是调用者读取的时间
+	 *  返回是否成功创建日志文件，已在录制时先结束之前的录制
+	 */
+	bool StartRecording(const std::string& logPath) {
+		m_recordMutex.lock();
+		if (m_recordFile.is_open()) {
+			m_recordFile.close();
+		}
+		m_recordFile.open(logPath, std::ios::binary | std::ios::trunc);
+		bool isOpen = m_recordFile.is_open();
+		if (isOpen) {
+			m_recordFile.write("CPSL", 4);
+			m_recordLastTime = std::chrono::steady_clock::now();
+		}
+		m_recordMutex.unlock();
+		return isOpen;
+	}
+
+	// 结束录制会话，关闭日志文件
+	void StopRecording() {
+		m_recordMutex.lock();
+		if (m_recordFile.is_open()) {
+			m_recordFile.close();
+		}
+		m_recordMutex.unlock();
+	}
+
+	/*
+	 *  订阅输出
+	 *  所有订阅者共享同一份输出，各自独立读取，输出块通过引用计数共享，不为每个订阅者复制
+	 *  订阅后由内部线程读取输出，不应再调用PullOutput、ReadOutput或ReadFrame
+	 *  进程未运行时订阅，会等待下一次启动；新订阅者只能读到订阅之后的输出
+	 *  最大落后字节数[in]：订阅者未读的输出超过该值时，按处理方式丢弃或阻塞
+	 *  返回订阅者编号
+	 */
+	int Subscribe(DWORD maxLagBytes, SubscriberOverflow overflow = SubscriberOverflow::Drop) {
+		m_broadcastMutex.lock();
+
+		// 添加订阅者，从当前位置开始读取
+		OutputSubscriber subscriber;
+		subscriber.cursor = m_broadcastFirstSeq + m_broadcastChunks.size();
+		subscriber.maxLagBytes = maxLagBytes;
+		subscriber.overflow = overflow;
+		subscriber.droppedBytes = 0;
+		int id = m_nextSubscriberId++;
+		m_subscribers[id] = subscriber;
+
+		// 广播线程未运行时启动
+		if (!m_isBroadcasting && !m_isBroadcastStopping) {
+			if (m_broadcastThread.joinable()) {
+				m_broadcastThread.join();
+			}
+			m_isBroadcasting = true;
+			m_isBroadcastEnded = false;
+			m_broadcastThread = std::thread(&BroadcastThread, this);
+		}
+
+		m_broadcastMutex.unlock();
+		return id;
+	}
+
+	// 取消订阅，释放该订阅者未读的输出
+	void Unsubscribe(int id) {
+		m_broadcastMutex.lock();
+		m_subscribers.erase(id);
+		TrimBroadcastChunks();
+		m_broadcastMutex.unlock();
+		m_broadcastCond.notify_all();
+	}
+
+	/*
+	 *  读取订阅的下一块输出
+	 *  同步方式读取，如果没有新的输出就会一直等待
+	 *  返回共享的输出块，进程结束且已读完全部输出或订阅已取消时返回nullptr
+	 */
+	std::shared_ptr<const std::string> PullSubscribedOutput(int id) {
+		std::unique_lock<std::mutex> lock(m_broadcastMutex);
+		std::shared_ptr<const std::string> data;
+		m_broadcastCond.wait(lock, [&] {
+			auto it = m_subscribers.find(id);
+			if (it == m_subscribers.end()) {
+				return true;
+			}
+			if (it->second.cursor < m_broadcastFirstSeq + m_broadcastChunks.size()) {
+				data = m_broadcastChunks[it->second.cursor - m_broadcastFirstSeq].data;
+				++it->second.cursor;
+				return true;
+			}
+			return m_isBroadcastEnded || m_isBroadcastStopping;
+		});
+		if (data) {
+			// 释放已读完的输出块，唤醒可能在等待的广播线程
+			TrimBroadcastChunks();
+			m_broadcastCond.notify_all();
+		}
+		return data;
+	}
+
+	// 返回订阅者因落后过多被丢弃的字节数
+	unsigned long long getSubscriberDroppedBytes(int id) {
+		m_broadcastMutex.lock();
+		unsigned long long droppedBytes = 0;
+		auto it = m_subscribers.find(id);
+		if (it != m_subscribers.end()) {
+			droppedBytes = it->second.droppedBytes;
+		}
+		m_broadcastMutex.unlock();
+		return droppedBytes;
+	}
+
+	// 返回输出块内存池的统计信息
+	OutputChunkPoolStats getChunkPoolStats() {
+		return m_chunkPool.getStats();
+	}
+
 	// 返回进程状态，正在运行返回true，否则返回false
 	bool getProcessStatus() {
 		m_rwProcMutex.lock_shared();
@@ -6,7 +6,9 @@
 #include <thread>
 #include <chrono>
 #include <string>
+#include <vector>
 #include <windows.h>
+#include "OutputChunkPool.hpp"
 
 // 换行符风格定义
 enum class NewlineStyle {
@@ -15,6 +17,44 @@ enum class NewlineStyle {
 	CRLF    // \r\n
 };
 
+// 二进制帧的长度头格式
+enum class FrameHeader {
+	U16LE,      // 2字节小端序
+	U16BE,      // 2字节大端序
+	U32LE,      // 4字节小端序
+	U32BE,      // 4字节大端序
+	Varint      // 变长整数，每字节低7位存数据，最高位为1表示后面还有字节
+};
+
+// 停止进程时各升级步骤
+enum class StopStep {
+	None,           // 进程未在运行，无需停止
+	Input,          // 输入停止命令后进程自行结束
+	CloseInput,     // 关闭输入管道(EOF)后进程自行结束
+	Terminate,      // 强制结束进程
+	Failed          // 所有步骤执行完毕，进程仍然处于运行状态
+};
+
+// 停止进程的升级策略，按Input->CloseInput->Terminate的顺序依次执行
+// 每一步的超时时间单位为毫秒，超时时间为0表示跳过该步骤
+struct StopPolicy {
+	// 停止命令的原始字节(需要包含换行符)，为空则跳过输入步骤
+	// 如果目标程序使用UTF16，请按字节传入wchar_t文本
+	std::string input;
+	DWORD inputTimeout = 0;
+	DWORD closeInputTimeout = 0;
+	// 强制结束进程后的等待时间，为0时只结束进程，不等待
+	DWORD terminateTimeout = 120000;
+};
+
+// 停止进程的结果
+struct StopResult {
+	// 使进程结束的步骤
+	StopStep step = StopStep::None;
+	// 从开始停止到进程结束(或放弃等待)的耗时，单位毫秒
+	DWORD elapsedMilliseconds = 0;
+};
+
 // 安全关闭句柄
 void Clhandle_s(HANDLE& hd) {
 	if (hd != NULL) {
@@ -24,7 +64,6 @@ void Clhandle_s(HANDLE& hd) {
 }
 
 // 控制台程序操作类，同步方式，线程安全
-// 调用Stop可能抛出int型异常，值为1，表示调用结束进程后等待了2分钟，进程仍然处于运行状态
 class ConsoleProgram_SyncW {
 private:
 	// 可执行文件路径、工作目录、命令行参数
@@ -37,6 +76,14 @@ private:
 
 	std::mutex m_outputMutex;
 
+	// 读写二进制帧专用锁，保证一帧的长度头和数据不被其它帧穿插
+	std::mutex m_frameReadMutex;
+	std::mutex m_frameWriteMutex;
+
+	// 已读取长度头但还未读取数据的帧
+	bool m_hasPendingFrame = false;
+	DWORD m_pendingFrameLen = 0;
+
 	// 线程对象
 	std::thread m_thread;
 
@@ -52,15 +99,29 @@ private:
 	// 进程句柄
 	HANDLE m_processHandle = NULL;
 
+	// 作业对象句柄，子进程及其创建的所有进程都在此作业中
+	HANDLE m_jobHandle = NULL;
+
+	// 进程结束事件，手动重置，进程未运行时为有信号状态
+	HANDLE m_hProcessExitedEvent = NULL;
+
 	// 管道句柄
 	HANDLE m_inputPipeRead = NULL;
 	HANDLE m_inputPipeWrite = NULL;
 	HANDLE m_outputPipeRead = NULL;
 	HANDLE m_outputPipeWrite = NULL;
 
-	// 结束后残留的输出
-	char* m_lastOutputBuffer;
-	DWORD m_lastOutputBufferLen;
+	// 输出块内存池，用于存放结束后残留的输出
+	OutputChunkPool m_chunkPool;
+
+	// 结束后残留的输出，每块记录数据长度和已取出的位置
+	struct LastOutputChunk {
+		char* data;
+		DWORD len;
+		DWORD pos;
+	};
+	std::vector<LastOutputChunk> m_lastOutputChunks;
+	size_t m_lastOutputHead = 0;
 
 
 	// 监视线程
@@ -108,6 +169,14 @@ private:
 			// 设置进程退出代码
 			classthis->m_processExitCode = exitCode;
 
+			// 关闭作业对象，结束子进程遗留的所有进程，使输出管道能读到EOF
+			Clhandle_s(classthis->m_jobHandle);
+
+			// 进程已结束，不在析构时获取剩余输出
+			if (!classthis->m_isExit) {
+				classthis->GetLastOutput();
+			}
+
 			// 安全关闭句柄
 			Clhandle_s(classthis->m_inputPipeRead);
 			Clhandle_s(classthis->m_inputPipeWrite);
@@ -115,6 +184,9 @@ private:
 			Clhandle_s(classthis->m_outputPipeWrite);
 			Clhandle_s(classthis->m_processHandle);
 
+			// 通知等待进程结束的线程
+			SetEvent(classthis->m_hProcessExitedEvent);
+
 			// 判断是否在析构
 			if (classthis->m_isExit) {
 				// 释放锁后退出
@@ -122,9 +194,6 @@ private:
 				return;
 			}
 
-			// 进程已结束，获取剩余输出
-			classthis->GetLastOutput();
-
 			// 资源回收工作完成，解锁，进入下一循环
 			classthis->m_rwProcMutex.unlock();
 		}
@@ -137,19 +206,195 @@ private:
 
 	// 获取最后的输出(无锁)
 	void GetLastOutput() {
-		DWORD bytesRead;
-		PeekNamedPipe(m_outputPipeRead, NULL, 0, NULL, &bytesRead, NULL);
-		if (bytesRead > 0) {
-			if (m_lastOutputBuffer != NULL) {
-				delete[] m_lastOutputBuffer;
+		DWORD bytesAvailable = 0;
+		PeekNamedPipe(m_outputPipeRead, NULL, 0, NULL, &bytesAvailable, NULL);
+		if (bytesAvailable > 0) {
+			// 丢弃上一次未取出的残留输出
+			ReleaseLastOutput();
+		}
+		while (bytesAvailable > 0) {
+			// 按块读入内存池分配的空间
+			LastOutputChunk chunk;
+			chunk.data = m_chunkPool.Allocate();
+			chunk.len = 0;
+			chunk.pos = 0;
+			DWORD chunkSize = static_cast<DWORD>(m_chunkPool.getChunkSize());
+			DWORD readSize = bytesAvailable < chunkSize ? bytesAvailable : chunkSize;
+			if (!ReadFile(m_outputPipeRead, chunk.data, readSize, &chunk.len, NULL) ||
+			    chunk.len == 0) {
+				m_chunkPool.Release(chunk.data);
+				break;
+			}
+			m_lastOutputChunks.push_back(chunk);
+			bytesAvailable -= chunk.len;
+		}
+	}
+
+	// 从残留的输出中取出数据(无锁)，返回取出的字节数
+	DWORD TakeLastOutput(char* buffer, DWORD size) {
+		DWORD bytesRead = 0;
+		while (bytesRead < size && m_lastOutputHead < m_lastOutputChunks.size()) {
+			LastOutputChunk& chunk = m_lastOutputChunks[m_lastOutputHead];
+			DWORD copyLen = chunk.len - chunk.pos;
+			if (copyLen > size - bytesRead) {
+				copyLen = size - bytesRead;
+			}
+			memcpy(buffer + bytesRead, chunk.data + chunk.pos, copyLen);
+			chunk.pos += copyLen;
+			bytesRead += copyLen;
+
+			// 整块取完后归还内存池
+			if (chunk.pos == chunk.len) {
+				m_chunkPool.Release(chunk.data);
+				++m_lastOutputHead;
+			}
+		}
+		if (m_lastOutputHead == m_lastOutputChunks.size()) {
+			// 全部取完，保留容量供下次使用
+			m_lastOutputChunks.clear();
+			m_lastOutputHead = 0;
+		}
+		return bytesRead;
+	}
+
+	// 释放全部残留的输出(无锁)
+	void ReleaseLastOutput() {
+		for (size_t i = m_lastOutputHead; i < m_lastOutputChunks.size(); ++i) {
+			m_chunkPool.Release(m_lastOutputChunks[i].data);
+		}
+		m_lastOutputChunks.clear();
+		m_lastOutputHead = 0;
+	}
+
+	// 等待进程结束，返回进程是否在超时时间内结束
+	bool WaitProcessExit(DWORD timeoutMilliseconds) {
+		return WaitForSingleObject(m_hProcessExitedEvent,
+		                           timeoutMilliseconds) == WAIT_OBJECT_0;
+	}
+
+	// 生成停止结果，计算从开始停止到现在的耗时
+	static StopResult MakeStopResult(StopStep step,
+	                                 std::chrono::steady_clock::time_point start) {
+		StopResult result;
+		result.step = step;
+		result.elapsedMilliseconds = static_cast<DWORD>(
+		    std::chrono::duration_cast<std::chrono::milliseconds>
+		    (std::chrono::steady_clock::now() - start).count());
+		return result;
+	}
+
+
+	// 把数据全部写入输入管道(无锁)，返回是否完整写入
+	bool WriteAll(const char* data, DWORD len) {
+		while (len > 0) {
+			DWORD bytesWritten = 0;
+			if (!WriteFile(m_inputPipeWrite, data, len, &bytesWritten, NULL)) {
+				return false;
+			}
+			data += bytesWritten;
+			len -= bytesWritten;
+		}
+		return true;
+	}
+
+	// 读取指定长度的输出，返回是否完整读取，进程结束导致数据不足时返回false
+	bool ReadOutputExact(char* buffer, DWORD size) {
+		DWORD total = 0;
+		while (total < size) {
+			DWORD bytesRead = ReadOutput(buffer + total, size - total);
+			if (bytesRead == 0) {
+				// 进程仍在运行说明输出管道已经关闭
+				if (getProcessStatus()) {
+					return false;
+				}
+				// 进程已结束，取出剩余的输出
+				bytesRead = ReadOutput(buffer + total, size - total);
+				if (bytesRead == 0) {
+					return false;
+				}
+			}
+			total += bytesRead;
+		}
+		return true;
+	}
+
+	// 编码帧长度头，返回长度头的字节数，长度超出格式范围时返回0
+	static DWORD EncodeFrameHeader(DWORD len, FrameHeader header, char* out) {
+		switch (header) {
+			case FrameHeader::U16LE:
+			case FrameHeader::U16BE:
+				if (len > 0xFFFF) {
+					return 0;
+				}
+				for (int i = 0; i < 2; ++i) {
+					int shift = (header == FrameHeader::U16LE) ? (8 * i) : (8 * (1 - i));
+					out[i] = static_cast<char>((len >> shift) & 0xFF);
+				}
+				return 2;
+			case FrameHeader::U32LE:
+			case FrameHeader::U32BE:
+				for (int i = 0; i < 4; ++i) {
+					int shift = (header == FrameHeader::U32LE) ? (8 * i) : (8 * (3 - i));
+					out[i] = static_cast<char>((len >> shift) & 0xFF);
+				}
+				return 4;
+			case FrameHeader::Varint:
+			default: {
+				// 每字节低7位存数据，最高位表示后面还有字节
+				DWORD headerLen = 0;
+				do {
+					unsigned char byte = len & 0x7F;
+					len >>= 7;
+					if (len != 0) {
+						byte |= 0x80;
+					}
+					out[headerLen++] = static_cast<char>(byte);
+				} while (len != 0);
+				return headerLen;
 			}
-			m_lastOutputBuffer = new char[bytesRead + 1];
-			m_lastOutputBufferLen = bytesRead;
-			ReadFile(m_outputPipeRead, m_lastOutputBuffer, bytesRead, &bytesRead, NULL);
-			m_lastOutputBuffer[bytesRead] = 0;
 		}
 	}
 
+	// 读取并解码帧长度头，返回是否成功
+	bool ReadFrameHeader(FrameHeader header, DWORD& len) {
+		unsigned char bytes[5];
+		len = 0;
+		switch (header) {
+			case FrameHeader::U16LE:
+			case FrameHeader::U16BE:
+			case FrameHeader::U32LE:
+			case FrameHeader::U32BE: {
+				bool isLittleEndian = (header == FrameHeader::U16LE ||
+				                       header == FrameHeader::U32LE);
+				int headerLen = (header == FrameHeader::U16LE ||
+				                 header == FrameHeader::U16BE) ? 2 : 4;
+				if (!ReadOutputExact(reinterpret_cast<char*>(bytes), headerLen)) {
+					return false;
+				}
+				for (int i = 0; i < headerLen; ++i) {
+					int shift = isLittleEndian ? (8 * i) : (8 * (headerLen - 1 - i));
+					len |= static_cast<DWORD>(bytes[i]) << shift;
+				}
+				return true;
+			}
+			case FrameHeader::Varint:
+			default:
+				// 32位长度最多5个字节，第5个字节只有低4位有效，更大的值超出32位
+				for (int i = 0; i < 5; ++i) {
+					if (!ReadOutputExact(reinterpret_cast<char*>(bytes + i), 1)) {
+						return false;
+					}
+					if (i == 4 && bytes[i] > 0x0F) {
+						return false;
+					}
+					len |= static_cast<DWORD>(bytes[i] & 0x7F) << (7 * i);
+					if ((bytes[i] & 0x80) == 0) {
+						return true;
+					}
+				}
+				return false;
+		}
+	}
 
 public:
 
@@ -161,8 +406,7 @@ public:
 	                              const std::wstring& workingDirectory = L"",
 	                              const std::wstring& commandLineArgument = L"")
 		: m_programPath(programPath), m_workingDirectory(workingDirectory),
-		  m_commandLineArgument(commandLineArgument), m_processExitCode(STILL_ACTIVE),
-		  m_lastOutputBuffer(NULL), m_lastOutputBufferLen(0) {
+		  m_commandLineArgument(commandLineArgument), m_processExitCode(STILL_ACTIVE) {
 		// 处理工作目录
 		if (workingDirectory.empty()) {
 			size_t found = programPath.find_last_of(L"/\\");
@@ -170,6 +414,8 @@ public:
 				this->m_workingDirectory = programPath.substr(0, found);
 			}
 		}
+		// 创建进程结束事件，初始为有信号状态
+		m_hProcessExitedEvent = CreateEvent(NULL, TRUE, TRUE, NULL);
 		// 启动监视线程
 		m_isExit = false;
 		m_processStatus = false;
@@ -188,13 +434,14 @@ public:
 		// 等待线程结束运行
 		m_thread.join();
 
-		// 释放指针内容
+		// 释放残留的输出
 		m_rwProcMutex.lock();
-		if (m_lastOutputBuffer != NULL) {
-			delete[] m_lastOutputBuffer;
-		}
+		ReleaseLastOutput();
 		m_rwProcMutex.unlock();
 
+		// 关闭进程结束事件
+		Clhandle_s(m_hProcessExitedEvent);
+
 		// 析构工作完成
 	}
 
@@ -205,6 +452,12 @@ public:
 			return false;
 		}
 
+		// 丢弃上一个进程留下的、已读取长度头但还未读取数据的帧
+		m_frameReadMutex.lock();
+		m_hasPendingFrame = false;
+		m_pendingFrameLen = 0;
+		m_frameReadMutex.unlock();
+
 		// 获取锁
 		m_rwProcMutex.lock();
 
@@ -244,6 +497,10 @@ public:
 			return false;
 		}
 
+		// 父进程使用的管道端不能被子进程继承，否则关闭输入管道时子进程收不到EOF
+		SetHandleInformation(m_inputPipeWrite, HANDLE_FLAG_INHERIT, 0);
+		SetHandleInformation(m_outputPipeRead, HANDLE_FLAG_INHERIT, 0);
+
 		// 初始化启动信息结构体
 		STARTUPINFOW startupInfo;
 		ZeroMemory(&startupInfo, sizeof(startupInfo));
@@ -268,10 +525,20 @@ public:
 		wcsncpy(commandLine_c, commandLine.c_str(), commandLine.size());
 		commandLine_c[commandLine.size()] = 0;
 
-		// 创建进程
+		// 创建作业对象，关闭作业时结束其中的所有进程
+		m_jobHandle = CreateJobObject(NULL, NULL);
+		if (m_jobHandle != NULL) {
+			JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobLimit;
+			ZeroMemory(&jobLimit, sizeof(jobLimit));
+			jobLimit.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+			SetInformationJobObject(m_jobHandle, JobObjectExtendedLimitInformation,
+			                        &jobLimit, sizeof(jobLimit));
+		}
+
+		// 挂起创建进程，加入作业后再继续执行，保证其创建的进程都在作业中
 		if (!CreateProcessW(NULL, commandLine_c, NULL, NULL, TRUE,
-		                    CREATE_NO_WINDOW, NULL, m_workingDirectory.c_str(),
-		                    &startupInfo, &processInfo)) {
+		                    CREATE_NO_WINDOW | CREATE_SUSPENDED, NULL,
+		                    m_workingDirectory.c_str(), &startupInfo, &processInfo)) {
 			// 释放命令行文本
 			delete[] commandLine_c;
 
@@ -280,6 +547,7 @@ public:
 			Clhandle_s(m_inputPipeWrite);
 			Clhandle_s(m_outputPipeRead);
 			Clhandle_s(m_outputPipeWrite);
+			Clhandle_s(m_jobHandle);
 
 			// 解锁
 			m_rwProcMutex.unlock();
@@ -289,14 +557,26 @@ public:
 		// 释放命令行文本
 		delete[] commandLine_c;
 
-		// 关闭线程句柄
+		// 加入作业，失败时(如旧系统不支持嵌套作业)只管理子进程本身
+		if (m_jobHandle != NULL &&
+		    !AssignProcessToJobObject(m_jobHandle, processInfo.hProcess)) {
+			Clhandle_s(m_jobHandle);
+		}
+
+		// 继续执行进程，然后关闭线程句柄
+		ResumeThread(processInfo.hThread);
 		CloseHandle(processInfo.hThread);
 
+		// 关闭子进程使用的管道端，所有子进程都退出后输出管道才能读到EOF
+		Clhandle_s(m_inputPipeRead);
+		Clhandle_s(m_outputPipeWrite);
+
 		// 保存进程句柄
 		m_processHandle = processInfo.hProcess;
 
 		// 设置进程状态
 		m_processStatus = true;
+		ResetEvent(m_hProcessExitedEvent);
 
 		// 解锁
 		m_rwProcMutex.unlock();
@@ -308,179 +588,104 @@ public:
 	 *  直接结束进程，等待进程结束后返回
 	 */
 	void Stop() {
-		// 获取锁
-		m_rwProcMutex.lock_shared();
-
-		// 判断状态，进程已经结束就没有必要再结束了
-		if (!m_processStatus) {
-			m_rwProcMutex.unlock_shared();
-			return;
-		}
-
-		// 强制结束进程
-		TerminateProcess(m_processHandle, 0);
-		if (m_isExit) {
-			m_rwProcMutex.unlock_shared();
-			return;
-		}
-
-		// 释放锁
-		m_rwProcMutex.unlock_shared();
+		Stop(StopPolicy());
+	}
 
-		// 等待进程结束
-		int cnt = 0;
-		do {
-			// 睡眠20ms
-			std::this_thread::sleep_for(std::chrono::milliseconds(20));
-			++cnt;
-			if (cnt > 6000) {
-				throw 1;
-			}
-		} while (getProcessStatus());
+	/*
+	 *  停止进程运行
+	 *  传入需要输入的命令(需要包含换行符,本函数为UTF16版本)，以及非0的超时时间。
+	 *  将输入命令并且等待进程自行结束，如果超时就强制结束进程
+	 *  注意：超时时间小于0按1ms计
+	 *  返回是否超时
+	 */
+	bool Stop(const std::wstring& input, int timeoutMilliseconds) {
+		return Stop(std::string(reinterpret_cast<const char*>(input.c_str()),
+		                        input.size() * 2), timeoutMilliseconds);
 	}
 
 	/*
 	 *  停止进程运行
 	 *  传入需要输入的命令(需要包含换行符,本函数为多字节字符集版本)，以及非0的超时时间。
 	 *  将输入命令并且等待进程自行结束，如果超时就强制结束进程
-	 *  注意：超时时间大于0小于20ms按20ms计
+	 *  注意：超时时间小于0按1ms计
 	 *  返回是否超时
 	 */
-	bool Stop(const std::wstring& input, int timeoutMilliseconds) {
-		// 获取锁
-		m_rwProcMutex.lock_shared();
+	bool Stop(const std::string& input, int timeoutMilliseconds) {
+		StopPolicy policy;
+		policy.input = input;
+		policy.inputTimeout = timeoutMilliseconds > 0 ? timeoutMilliseconds : 1;
+		StopResult result = Stop(policy);
+		return result.step == StopStep::Terminate || result.step == StopStep::Failed;
+	}
 
-		// 先尝试输入命令，等待进程自然结束
+	/*
+	 *  按升级策略停止进程运行
+	 *  依次执行：输入停止命令 -> 关闭输入管道(EOF) -> 强制结束进程(包括其创建的所有进程)
+	 *  每一步都通过进程结束事件等待，进程在某一步的时限内结束则不再继续升级
+	 *  返回使进程结束的步骤和耗时，所有步骤完成后进程仍在运行时步骤为Failed
+	 */
+	StopResult Stop(const StopPolicy& policy) {
+		auto start = std::chrono::steady_clock::now();
 
 		// 判断状态，进程已经结束就没有必要再结束了
-		if (!m_processStatus) {
-			m_rwProcMutex.unlock_shared();
-			return false;
+		if (!getProcessStatus()) {
+			return MakeStopResult(StopStep::None, start);
 		}
 
-		// 输入命令
-		DWORD bytesWritten;
-		WriteFile(m_inputPipeWrite, input.c_str(), input.size() * 2, &bytesWritten, NULL);
-
-		// 释放锁
-		m_rwProcMutex.unlock_shared();
+		// 已经执行过的最后一个步骤
+		StopStep lastStep = StopStep::None;
 
-		// 计时等待进程结束
-		bool isTimeout = false;
-		do {
-			// 睡眠20ms
-			std::this_thread::sleep_for(std::chrono::milliseconds(20));
-			timeoutMilliseconds -= 20;
-			if (timeoutMilliseconds <= 0) {
-				isTimeout = true;
-				break;
+		// 输入停止命令，等待进程自然结束
+		if ( (!policy.input.empty()) && (policy.inputTimeout != 0) ) {
+			lastStep = StopStep::Input;
+			Input(policy.input);
+			if (WaitProcessExit(policy.inputTimeout)) {
+				return MakeStopResult(StopStep::Input, start);
 			}
-		} while (getProcessStatus());
-
-		// 判断是自然结束还是超时了
-		if (isTimeout) {
-			// 超时了就强制结束进程
-
-			// 获取锁
-			m_rwProcMutex.lock_shared();
+		}
 
-			// 判断进程是否结束
+		// 关闭输入管道，使进程读到EOF，等待进程自然结束
+		if (policy.closeInputTimeout != 0) {
+			lastStep = StopStep::CloseInput;
+			m_rwProcMutex.lock();
 			if (m_processStatus) {
-				// 强制结束进程
-				TerminateProcess(m_processHandle, 0);
-
-				// 结束进程后释放锁
-				m_rwProcMutex.unlock_shared();
-
-				// 等待进程结束
-				int cnt = 0;
-				do {
-					// 睡眠20ms
-					std::this_thread::sleep_for(std::chrono::milliseconds(20));
-					++cnt;
-					if (cnt > 6000) {
-						throw 1;
-					}
-				} while (getProcessStatus());
-			} else {
-				// 直接解锁后返回
-				m_rwProcMutex.unlock_shared();
+				Clhandle_s(m_inputPipeWrite);
+			}
+			m_rwProcMutex.unlock();
+			if (WaitProcessExit(policy.closeInputTimeout)) {
+				return MakeStopResult(StopStep::CloseInput, start);
 			}
-			return true;
 		}
-		return false;
-	}
 
-	/*
-	 *  停止进程运行
-	 *  传入需要输入的命令(需要包含换行符,本函数为多字节字符集版本)，以及非0的超时时间。
-	 *  将输入命令并且等待进程自行结束，如果超时就强制结束进程
-	 *  注意：超时时间大于0小于20ms按20ms计
-	 *  返回是否超时
-	 */
-	bool Stop(const std::string& input, int timeoutMilliseconds) {
 		// 获取锁
 		m_rwProcMutex.lock_shared();
 
-		// 先尝试输入命令，等待进程自然结束
-
-		// 判断状态，进程已经结束就没有必要再结束了
+		// 判断进程是否结束，等待期间可能已经结束
 		if (!m_processStatus) {
 			m_rwProcMutex.unlock_shared();
-			return false;
+			return MakeStopResult(lastStep, start);
 		}
 
-		// 输入命令
-		DWORD bytesWritten;
-		WriteFile(m_inputPipeWrite, input.c_str(), input.size(), &bytesWritten, NULL);
+		// 强制结束进程，有作业时结束整个进程树
+		if (m_jobHandle != NULL) {
+			TerminateJobObject(m_jobHandle, 0);
+		} else {
+			TerminateProcess(m_processHandle, 0);
+		}
+		if (m_isExit) {
+			// 正在析构，监视线程负责回收
+			m_rwProcMutex.unlock_shared();
+			return MakeStopResult(StopStep::Terminate, start);
+		}
 
 		// 释放锁
 		m_rwProcMutex.unlock_shared();
 
-		// 计时等待进程结束
-		bool isTimeout = false;
-		do {
-			// 睡眠20ms
-			std::this_thread::sleep_for(std::chrono::milliseconds(20));
-			timeoutMilliseconds -= 20;
-			if (timeoutMilliseconds <= 0) {
-				isTimeout = true;
-				break;
-			}
-		} while (getProcessStatus());
-
-		// 判断是自然结束还是超时了
-		if (isTimeout) {
-			// 超时了就强制结束进程
-
-			// 获取锁
-			m_rwProcMutex.lock_shared();
-
-			// 判断进程是否结束
-			if (m_processStatus) {
-				// 强制结束进程
-				TerminateProcess(m_processHandle, 0);
-
-				// 结束进程后释放锁
-				m_rwProcMutex.unlock_shared();
-
-				// 等待进程结束
-				int cnt = 0;
-				do {
-					// 睡眠20ms
-					std::this_thread::sleep_for(std::chrono::milliseconds(20));
-					++cnt;
-					if (cnt > 6000) {
-						throw 1;
-					}
-				} while (getProcessStatus());
-			} else {
-				// 直接解锁后返回
-				m_rwProcMutex.unlock_shared();
-			}
-			return true;
+		// 等待进程结束
+		if (policy.terminateTimeout != 0 && !WaitProcessExit(policy.terminateTimeout)) {
+			return MakeStopResult(StopStep::Failed, start);
 		}
-		return false;
+		return MakeStopResult(StopStep::Terminate, start);
 	}
 
 	/*
@@ -627,6 +832,18 @@ public:
 	 *  缓冲区大小必须大于2，否则行为未定义
 	 */
 	DWORD PullOutput(char* buffer, DWORD bufferSize) {
+		DWORD bytesRead = ReadOutput(buffer, bufferSize - 2);
+		buffer[bytesRead] = '\0';
+		buffer[bytesRead + 1] = '\0';
+		return bytesRead;
+	}
+
+	/*
+	 *  读取原始输出
+	 *  与PullOutput相同，但不在末尾添加\0，数据中的\0也原样保留，适合二进制数据
+	 *  返回实际读取的字节数目。如果在等待过程中进程自然结束，那么返回0
+	 */
+	DWORD ReadOutput(char* buffer, DWORD size) {
 		// 获取读锁
 		m_rwProcMutex.lock_shared();
 
@@ -641,55 +858,15 @@ public:
 			// 再次判断状态，防止等待时状态更改
 			if (m_processStatus) {
 				m_rwProcMutex.unlock();
-				return PullOutput(buffer, bufferSize);
+				return ReadOutput(buffer, size);
 			}
 
-			if (m_lastOutputBuffer != NULL) {
-				// 说明有剩下的数据没有取出，这里模拟从管道取出数据
-				if (m_lastOutputBufferLen < bufferSize - 1) {
-					// 一次性搞定，直接复制进去即可
-					strncpy(buffer, m_lastOutputBuffer, m_lastOutputBufferLen);
-					buffer[m_lastOutputBufferLen] = 0;
-					buffer[m_lastOutputBufferLen + 1] = 0;
-
-					// 删除字符串的内存空间
-					delete[] m_lastOutputBuffer;
-					m_lastOutputBuffer = NULL;
-
-					// 解锁
-					m_rwProcMutex.unlock();
-
-					return m_lastOutputBufferLen;
-				} else {
-					// 需要分次拷贝
-
-					// 复制缓冲区能承受的最大长度
-					strncpy(buffer, m_lastOutputBuffer, bufferSize - 2);
-					buffer[bufferSize - 1] = 0;
-					buffer[bufferSize - 2] = 0;
-
-					// 新开辟空间存剩下的部分
-					m_lastOutputBufferLen = m_lastOutputBufferLen - bufferSize + 2;
-					char* tmp = new char [m_lastOutputBufferLen + 1];
-
-					// 复制到新空间，并且释放旧的
-					strncpy(tmp, m_lastOutputBuffer + bufferSize - 2,
-					        m_lastOutputBufferLen);
-					tmp[m_lastOutputBufferLen] = 0;
-					delete[] m_lastOutputBuffer;
-					m_lastOutputBuffer = tmp;
-
-					// 解锁
-					m_rwProcMutex.unlock();
-
-					return bufferSize - 2;
-				}
-			}
+			// 说明有剩下的数据没有取出，这里模拟从管道取出数据
+			DWORD bytesRead = TakeLastOutput(buffer, size);
+
 			// 解锁
 			m_rwProcMutex.unlock();
-			buffer[0] = '\0';
-			buffer[1] = '\0';
-			return 0;
+			return bytesRead;
 		}
 
 		HANDLE hpipe = m_outputPipeRead;
@@ -704,23 +881,141 @@ public:
 		if (hpipe != m_outputPipeRead) {
 			// 管道变了，解锁退出
 			m_outputMutex.unlock();
-			buffer[0] = '\0';
-			buffer[1] = '\0';
 			return 0;
 		}
 
 		// 读入数据
-		DWORD bytesRead;
-		ReadFile(hpipe, buffer, bufferSize - 2, &bytesRead, NULL);
+		DWORD bytesRead = 0;
+		ReadFile(hpipe, buffer, size, &bytesRead, NULL);
 
 		// 退出读取专用锁
 		m_outputMutex.unlock();
 
-		buffer[bytesRead] = '\0';
-		buffer[bytesRead + 1] = '\0';
 		return bytesRead;
 	}
 
+	/*
+	 *  写入一帧二进制数据，格式为：长度头 + 数据
+	 *  长度头格式未指定时，默认采用4字节小端序
+	 *  多个线程写帧时互不穿插，但不与Input系列函数同步
+	 *  返回是否完整写入，长度超出长度头能表示的范围时不写入并返回false
+	 */
+	bool WriteFrame(const char* data, DWORD len,
+	                FrameHeader header = FrameHeader::U32LE) {
+		// 编码长度头
+		char headerBuffer[5];
+		DWORD headerLen = EncodeFrameHeader(len, header, headerBuffer);
+		if (headerLen == 0) {
+			return false;
+		}
+
+		// 获取写帧专用锁，然后获取读锁
+		m_frameWriteMutex.lock();
+		m_rwProcMutex.lock_shared();
+
+		// 判断进程是否启动，未启动就直接返回
+		if (!m_processStatus) {
+			m_rwProcMutex.unlock_shared();
+			m_frameWriteMutex.unlock();
+			return false;
+		}
+
+		// 写入长度头和数据
+		bool isWritten = WriteAll(headerBuffer, headerLen) && WriteAll(data, len);
+
+		// 解锁
+		m_rwProcMutex.unlock_shared();
+		m_frameWriteMutex.unlock();
+		return isWritten;
+	}
+
+	/*
+	 *  读取一帧二进制数据到调用者提供的缓冲区，不添加\0
+	 *  帧长度[out]：返回这一帧数据的长度
+	 *  缓冲区不足时返回false，帧长度为所需的缓冲区大小，这一帧保留到下次读取
+	 *  进程结束导致读不到完整的帧或变长长度头超出32位时返回false，帧长度为0
+	 */
+	bool ReadFrame(char* buffer, DWORD bufferSize, DWORD& frameLen,
+	               FrameHeader header = FrameHeader::U32LE) {
+		// 进入读帧专用锁
+		m_frameReadMutex.lock();
+
+		// 读取长度头
+		if (!m_hasPendingFrame) {
+			if (!ReadFrameHeader(header, m_pendingFrameLen)) {
+				m_frameReadMutex.unlock();
+				frameLen = 0;
+				return false;
+			}
+			m_hasPendingFrame = true;
+		}
+
+		// 判断缓冲区是否足够
+		frameLen = m_pendingFrameLen;
+		if (frameLen > bufferSize) {
+			m_frameReadMutex.unlock();
+			return false;
+		}
+
+		// 直接读入调用者的缓冲区
+		m_hasPendingFrame = false;
+		bool isRead = ReadOutputExact(buffer, frameLen);
+		if (!isRead) {
+			frameLen = 0;
+		}
+
+		// 退出读帧专用锁
+		m_frameReadMutex.unlock();
+		return isRead;
+	}
+
+	/*
+	 *  读取一帧二进制数据到string
+	 *  复用string已有的容量，反复使用同一个string读取时不会每帧分配内存
+	 *  进程结束导致读不到完整的帧或变长长度头超出32位时返回false，string被清空
+	 *  最大帧长度[in]：长度头超过该值时不分配内存，返回false，string被清空，这一帧保留到下次读取
+	 *                 防止损坏的长度头导致分配大量内存，可以改用提供缓冲区的ReadFrame读取
+	 */
+	bool ReadFrame(std::string& frame, FrameHeader header = FrameHeader::U32LE,
+	               DWORD maxFrameLen = 1 << 26) {
+		// 进入读帧专用锁
+		m_frameReadMutex.lock();
+
+		// 读取长度头
+		if (!m_hasPendingFrame) {
+			if (!ReadFrameHeader(header, m_pendingFrameLen)) {
+				m_frameReadMutex.unlock();
+				frame.clear();
+				return false;
+			}
+			m_hasPendingFrame = true;
+		}
+
+		// 拒绝超过最大长度的帧
+		if (m_pendingFrameLen > maxFrameLen) {
+			m_frameReadMutex.unlock();
+			frame.clear();
+			return false;
+		}
+
+		// 读取数据
+		m_hasPendingFrame = false;
+		frame.resize(m_pendingFrameLen);
+		bool isRead = ReadOutputExact(&frame[0], m_pendingFrameLen);
+		if (!isRead) {
+			frame.clear();
+		}
+
+		// 退出读帧专用锁
+		m_frameReadMutex.unlock();
+		return isRead;
+	}
+
+	// 返回输出块内存池的统计信息
+	OutputChunkPoolStats getChunkPoolStats() {
+		return m_chunkPool.getStats();
+	}
+
 	// 返回进程状态，正在运行返回true，否则返回false
 	bool getProcessStatus() {
 		m_rwProcMutex.lock_shared();
@@ -0,0 +1,275 @@
+/**
+ * \file    	DirectoryJudge.hpp
+ * \author  	XY0797
+ * \brief		按目录批量评测测试数据，生成机器可读的报告
+ */
+#ifndef _XY0797_DIRECTORYJUDGE
+#define _XY0797_DIRECTORYJUDGE 1
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include "ConsoleOJ.hpp"
+
+// 目录评测的选项
+struct DirectoryJudgeOptions {
+	// 每组测试数据的时间限制，单位毫秒
+	long long timeLimit = 1000;
+	// 内存限制和输出字节数限制，单位字节，0为不限制
+	size_t memoryLimit = 0;
+	size_t outputLimit = 0;
+	// 检查器路径，为空时与标准答案逐记号比较
+	std::string checkerPath;
+	// 是否在第一组未通过的测试数据后停止，为false时评测全部数据用于计分
+	bool isStopAtFirstFailure = false;
+	// 评测结果缓存，为空时不使用，重测时跳过没有变化的测试数据，见ConsoleOJ::setVerdictCache
+	VerdictCache* verdictCache = nullptr;
+	// 因评测机负载过大而中止的测试数据(见ConsoleOJ::isOverloaded)最多重新评测的次数
+	int maxOverloadReruns = 2;
+	// 重新评测之前等待的时间，使负载有机会降低，单位毫秒
+	long long overloadRerunDelay = 1000;
+};
+
+// 一组测试数据的评测结果
+struct TestCaseResult {
+	// 测试数据名，即不含扩展名的文件名
+	std::string name;
+	JudgeVerdict verdict = JudgeVerdict::None;
+	// 时间花费(计算方式由ConsoleOJ::setCPUTimePolicy决定)和真实时间，单位毫秒
+	long long timeCosted = 0;
+	long long realTimeCosted = 0;
+	// 内存峰值，单位字节
+	size_t peakMemory = 0;
+	// 目标程序的退出代码和结束信号
+	int exitCode = 0;
+	int exitSignal = 0;
+	// 输出字节数，结果来自缓存时为0
+	size_t outputSize = 0;
+	// 结果是否来自评测结果缓存
+	bool isCached = false;
+	// 未通过时的错误信息
+	std::string error;
+};
+
+// 整个目录的评测结果
+struct DirectoryJudgeResult {
+	// 第一组未通过的测试数据的结果，全部通过为Accepted，没有测试数据为None
+	JudgeVerdict verdict = JudgeVerdict::None;
+	// 已评测的测试数据的结果，按测试数据名的自然顺序排列
+	std::vector<TestCaseResult> testCases;
+	// 测试数据总数、已评测数和通过数，在第一组未通过后停止时已评测数可能小于总数
+	size_t totalCount = 0;
+	size_t judgedCount = 0;
+	size_t passedCount = 0;
+	// 结果来自评测结果缓存的测试数据数
+	size_t cachedCount = 0;
+	// 时间花费的最大值和总和、真实时间的最大值，单位毫秒
+	long long maxTimeCosted = 0;
+	long long totalTimeCosted = 0;
+	long long maxRealTimeCosted = 0;
+	// 内存峰值的最大值，单位字节
+	size_t maxPeakMemory = 0;
+
+	// 转换为JSON文本
+	std::string toJSON() const {
+		std::string json = "{\"verdict\":\"" + std::string(judgeVerdictName(verdict)) + "\"";
+		json += ",\"totalCount\":" + std::to_string(totalCount);
+		json += ",\"judgedCount\":" + std::to_string(judgedCount);
+		json += ",\"passedCount\":" + std::to_string(passedCount);
+		json += ",\"cachedCount\":" + std::to_string(cachedCount);
+		json += ",\"maxTimeCosted\":" + std::to_string(maxTimeCosted);
+		json += ",\"totalTimeCosted\":" + std::to_string(totalTimeCosted);
+		json += ",\"maxRealTimeCosted\":" + std::to_string(maxRealTimeCosted);
+		json += ",\"maxPeakMemory\":" + std::to_string(maxPeakMemory);
+		json += ",\"testCases\":[";
+		for (size_t i = 0; i < testCases.size(); ++i) {
+			const TestCaseResult& testCase = testCases[i];
+			json += (i == 0) ? "\n" : ",\n";
+			json += "{\"name\":" + EscapeJSON(testCase.name);
+			json += ",\"verdict\":\"" + std::string(judgeVerdictName(testCase.verdict)) + "\"";
+			json += ",\"timeCosted\":" + std::to_string(testCase.timeCosted);
+			json += ",\"realTimeCosted\":" + std::to_string(testCase.realTimeCosted);
+			json += ",\"peakMemory\":" + std::to_string(testCase.peakMemory);
+			json += ",\"exitCode\":" + std::to_string(testCase.exitCode);
+			json += ",\"exitSignal\":" + std::to_string(testCase.exitSignal);
+			json += ",\"outputSize\":" + std::to_string(testCase.outputSize);
+			json += std::string(",\"cached\":") + (testCase.isCached ? "true" : "false");
+			json += ",\"error\":" + EscapeJSON(testCase.error) + "}";
+		}
+		json += "]}\n";
+		return json;
+	}
+
+	// 转换为带引号的JSON字符串，UTF-8字符原样保留
+	static std::string EscapeJSON(const std::string& text) {
+		std::string escaped = "\"";
+		for (char ch : text) {
+			switch (ch) {
+				case '"':
+					escaped += "\\\"";
+					break;
+				case '\\':
+					escaped += "\\\\";
+					break;
+				case '\n':
+					escaped += "\\n";
+					break;
+				case '\r':
+					escaped += "\\r";
+					break;
+				case '\t':
+					escaped += "\\t";
+					break;
+				default:
+					if (static_cast<unsigned char>(ch) < 0x20) {
+						char unicode[8];
+						snprintf(unicode, sizeof(unicode), "\\u%04x", static_cast<unsigned char>(ch));
+						escaped += unicode;
+					} else {
+						escaped += ch;
+					}
+			}
+		}
+		return escaped + "\"";
+	}
+};
+
+// 按自然顺序比较测试数据名，数字部分按数值比较，使得"2"排在"10"之前
+// 数值相同、只有前导零不同的名字(如"01"和"1")再按字符串比较，使得顺序确定
+inline bool naturalNameLess(const std::string& a, const std::string& b) {
+	size_t i = 0, j = 0;
+	while (i < a.size() && j < b.size()) {
+		if (isdigit(static_cast<unsigned char>(a[i])) && isdigit(static_cast<unsigned char>(b[j]))) {
+			// 跳过前导零后先比较位数，再逐位比较
+			size_t numberStartA = i, numberStartB = j;
+			while (numberStartA < a.size() && a[numberStartA] == '0') {
+				++numberStartA;
+			}
+			while (numberStartB < b.size() && b[numberStartB] == '0') {
+				++numberStartB;
+			}
+			size_t numberEndA = numberStartA, numberEndB = numberStartB;
+			while (numberEndA < a.size() && isdigit(static_cast<unsigned char>(a[numberEndA]))) {
+				++numberEndA;
+			}
+			while (numberEndB < b.size() && isdigit(static_cast<unsigned char>(b[numberEndB]))) {
+				++numberEndB;
+			}
+			if (numberEndA - numberStartA != numberEndB - numberStartB) {
+				return numberEndA - numberStartA < numberEndB - numberStartB;
+			}
+			int order = a.compare(numberStartA, numberEndA - numberStartA,
+			                      b, numberStartB, numberEndB - numberStartB);
+			if (order != 0) {
+				return order < 0;
+			}
+			i = numberEndA;
+			j = numberEndB;
+		} else {
+			if (a[i] != b[j]) {
+				return a[i] < b[j];
+			}
+			++i;
+			++j;
+		}
+	}
+	if (a.size() - i != b.size() - j) {
+		return a.size() - i < b.size() - j;
+	}
+	return a < b;
+}
+
+/*
+ *  评测目录中的全部测试数据
+ *  测试数据为目录中的*.in文件，标准答案为同名的*.out或*.ans文件，没有标准答案时只检查程序能否正常结束
+ *  输入文件直接重定向到目标程序的标准输入，见ConsoleOJ::launchAndWaitFile
+ *  可执行文件路径[in]：目标程序
+ *  目录[in]：测试数据所在的目录
+ *  选项[in]：时间、内存、输出限制，检查器，是否在第一组未通过后停止，评测结果缓存
+ *  返回每组测试数据的结果和汇总统计，目录不存在时没有测试数据
+ */
+inline DirectoryJudgeResult judgeDirectory(const std::string& programPath, const std::string& directory,
+                                           const DirectoryJudgeOptions& options = DirectoryJudgeOptions()) {
+	DirectoryJudgeResult result;
+
+	// 找出全部测试数据，按自然顺序排列
+	std::vector<std::string> names;
+	std::error_code errorCode;
+	for (std::filesystem::directory_iterator entry(directory, errorCode), end;
+	     !errorCode && entry != end; entry.increment(errorCode)) {
+		if (entry->is_regular_file(errorCode) && entry->path().extension() == ".in") {
+			names.push_back(entry->path().stem().string());
+		}
+	}
+	std::sort(names.begin(), names.end(), naturalNameLess);
+	result.totalCount = names.size();
+
+	// 依次评测，同一个ConsoleOJ对象复用于全部测试数据
+	ConsoleOJ oj(programPath);
+	oj.setMemoryLimit(options.memoryLimit);
+	oj.setOutputLimit(options.outputLimit);
+	if (!options.checkerPath.empty()) {
+		oj.setChecker(options.checkerPath);
+	}
+	oj.setVerdictCache(options.verdictCache);
+	std::filesystem::path directoryPath(directory);
+	for (const std::string& name : names) {
+		std::filesystem::path answerPath = directoryPath / (name + ".out");
+		if (!std::filesystem::exists(answerPath, errorCode)) {
+			answerPath = directoryPath / (name + ".ans");
+		}
+		if (!oj.setExpectedOutputFile(answerPath.string())) {
+			oj.clearExpectedOutput();
+		}
+
+		TestCaseResult testCase;
+		testCase.name = name;
+		std::string output;
+		for (int rerun = 0; ; ++rerun) {
+			testCase.error.clear();
+			oj.launchAndWaitFile((directoryPath / (name + ".in")).string(), options.timeLimit,
+			                     output, testCase.timeCosted, testCase.error);
+			if (!oj.isOverloaded() || rerun >= options.maxOverloadReruns) {
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(options.overloadRerunDelay));
+		}
+		testCase.verdict = oj.getVerdict();
+		testCase.realTimeCosted = oj.getRealTimeCosted();
+		testCase.peakMemory = oj.getPeakMemory();
+		testCase.exitCode = oj.getExitCode();
+		testCase.exitSignal = oj.getExitSignal();
+		testCase.outputSize = output.size();
+		testCase.isCached = oj.isVerdictCached();
+
+		// 汇总统计
+		++result.judgedCount;
+		if (testCase.isCached) {
+			++result.cachedCount;
+		}
+		if (testCase.verdict == JudgeVerdict::Accepted) {
+			++result.passedCount;
+		} else if (result.verdict == JudgeVerdict::None) {
+			result.verdict = testCase.verdict;
+		}
+		result.maxTimeCosted = std::max(result.maxTimeCosted, testCase.timeCosted);
+		result.totalTimeCosted += testCase.timeCosted;
+		result.maxRealTimeCosted = std::max(result.maxRealTimeCosted, testCase.realTimeCosted);
+		result.maxPeakMemory = std::max(result.maxPeakMemory, testCase.peakMemory);
+		bool isPassed = (testCase.verdict == JudgeVerdict::Accepted);
+		result.testCases.push_back(std::move(testCase));
+		if (!isPassed && options.isStopAtFirstFailure) {
+			break;
+		}
+	}
+	if (result.judgedCount > 0 && result.verdict == JudgeVerdict::None) {
+		result.verdict = JudgeVerdict::Accepted;
+	}
+	return result;
+}
+
+#endif /* _XY0797_DIRECTORYJUDGE */
@@ -0,0 +1,533 @@
+/**
+ * \file    	JudgeEngine.hpp
+ * \author  	XY0797
+ * \brief		多核并行评测引擎
+ */
+#ifndef _XY0797_JUDGEENGINE
+#define _XY0797_JUDGEENGINE 1
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "ConsoleOJ.hpp"
+
+// 一个评测任务：用一组测试数据运行一个程序
+struct JudgeJob {
+	// 可执行文件路径
+	std::string programPath;
+	// 输入文本
+	std::string input;
+	// 时间限制，单位毫秒
+	long long timeLimit = 1000;
+	// 内存限制和输出字节数限制，单位字节，0为不限制
+	size_t memoryLimit = 0;
+	size_t outputLimit = 0;
+	// 标准答案，hasExpectedOutput为false时不比较输出，见ConsoleOJ::setExpectedOutput
+	bool hasExpectedOutput = false;
+	std::string expectedOutput;
+	// 检查器路径，为空时与标准答案逐记号比较
+	std::string checkerPath;
+	// 时间的计算方式和是否计入子进程，见ConsoleOJ::setCPUTimePolicy
+	CPUTimePolicy cpuTimePolicy = CPUTimePolicy::TotalCPUTime;
+	bool isChildProcessCounted = false;
+	// 评测结果缓存，为空时不使用，见ConsoleOJ::setVerdictCache
+	VerdictCache* verdictCache = nullptr;
+};
+
+// 评测任务的结果，前四项的含义与ConsoleOJ::launchAndWait的返回值和输出参数相同
+struct JudgeResult {
+	bool isSucceeded = false;
+	std::string output;
+	long long timeCosted = 0;
+	std::string error;
+	// 评测结果和内存峰值(单位字节)
+	JudgeVerdict verdict = JudgeVerdict::None;
+	size_t peakMemory = 0;
+	// 结果是否来自评测结果缓存
+	bool isCached = false;
+	// 运行时绑定的CPU编号
+	int cpuIndex = -1;
+	// 因评测机负载过大而重新评测的次数
+	int overloadReruns = 0;
+};
+
+/*
+ *  并发评测的准入控制设置
+ *  工作线程取出任务之前先检查自己的CPU的负载，负载过高时任务留在队列中，由其他CPU空闲的工作线程评测或稍后再试
+ *  负载按两次检查之间的增量计算：占用比例为其他进程占用该CPU的时间比例(扣除本工作线程评测消耗的CPU时间)
+ *  steal为CPU被虚拟化平台占用的时间比例
+ *  运行队列压力为就绪任务在该CPU的运行队列中等待的时间比例(/proc/schedstat)，
+ *  不可用或工作线程不绑定CPU时使用整个系统有任务等待CPU的时间比例(/proc/pressure/cpu)
+ *  Windows下没有这些统计，总是立即评测
+ *  默认关闭：占用比例无法区分其他进程与评测机自身的线程，CPU少的机器上会频繁推迟评测，应按评测机的实际情况设置阈值后开启
+ *  关闭时因评测机负载过大而中止的评测仍会等待检查间隔后重新评测
+ */
+struct JudgeAdmissionOptions {
+	// 是否按负载决定能否开始评测，为false时取出任务立即评测
+	bool isEnabled = false;
+	// 其他进程占用比例的上限，工作线程不绑定CPU时不检查
+	double maxBusyRatio = 0.1;
+	// steal时间比例的上限
+	double maxStealRatio = 0.05;
+	// 运行队列压力的上限
+	double maxRunQueueRatio = 0.1;
+	// 负载过高时再次检查的间隔，单位毫秒，也是计算负载的最短时间窗口
+	long long retryInterval = 100;
+	// 任务排队超过该时间后不再检查负载，直接评测，单位毫秒
+	long long maxQueueTime = 30000;
+	// 因评测机负载过大而中止的评测(见ConsoleOJ::isOverloaded)最多重新评测的次数
+	int maxOverloadReruns = 2;
+};
+
+// 准入控制的统计信息
+struct JudgeAdmissionStats {
+	// 因负载过高推迟开始评测的次数
+	unsigned long long deferrals = 0;
+	// 因评测机负载过大而重新评测的次数
+	unsigned long long overloadReruns = 0;
+};
+
+// 多核并行评测引擎
+// 每个工作线程对应一个CPU，目标程序绑定到该CPU上运行，并发的评测之间互不抢占CPU
+// CPU的负载过高时推迟开始评测，因评测机负载过大而中止的评测自动重新评测，见JudgeAdmissionOptions
+// ConsoleOJ不可重入，所以每个任务使用独立的ConsoleOJ对象
+class JudgeEngine {
+private:
+	// 任务队列中的一项
+	struct QueuedJob {
+		size_t id;
+		JudgeJob job;
+		// 提交时间
+		std::chrono::steady_clock::time_point submitTime;
+	};
+
+	// 一个CPU的负载采样：各项的累计值和采样时刻，没有的项为0
+	struct LoadSample {
+		std::chrono::steady_clock::time_point time;
+		// /proc/stat中的非空闲、steal和全部时间，单位为时钟滴答
+		unsigned long long busyTicks = 0;
+		unsigned long long stealTicks = 0;
+		unsigned long long totalTicks = 0;
+		// 运行队列中等待的时间，单位纳秒
+		unsigned long long runDelay = 0;
+		// 系统中有任务等待CPU的时间，单位微秒
+		unsigned long long pressureTotal = 0;
+		// 自采样以来本工作线程评测消耗的CPU时间，单位毫秒
+		long long ownCPUTime = 0;
+		// 是否已经计算过负载，上一次计算的负载是否可以开始评测
+		bool isMeasured = false;
+		bool isAcceptable = true;
+	};
+
+	// 工作线程绑定的CPU和工作线程对象
+	std::vector<int> m_cpus;
+	std::vector<std::thread> m_workers;
+
+	// 任务队列、结果和完成标志，下标为任务编号
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobCond;
+	std::condition_variable m_resultCond;
+	std::deque<QueuedJob> m_jobQueue;
+	std::vector<JudgeResult> m_results;
+	std::vector<bool> m_isJobDone;
+	size_t m_pendingJobs = 0;
+
+	// 准入控制设置和统计信息
+	JudgeAdmissionOptions m_admission;
+	JudgeAdmissionStats m_admissionStats;
+
+	// 将要析构标志位
+	bool m_willExit = false;
+
+	// 解析形如"2-3,6"的CPU列表
+	static std::vector<int> ParseCPUList(const std::string& list) {
+		std::vector<int> cpus;
+		size_t pos = 0;
+		while (pos < list.size()) {
+			size_t end = list.find(',', pos);
+			if (end == std::string::npos) {
+				end = list.size();
+			}
+			std::string range = list.substr(pos, end - pos);
+			size_t dash = range.find('-');
+			try {
+				int first = std::stoi(range.substr(0, dash));
+				int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+				for (int cpu = first; cpu <= last; ++cpu) {
+					cpus.push_back(cpu);
+				}
+			} catch (...) {
+				// 忽略无法解析的部分，如结尾的换行
+			}
+			pos = end + 1;
+		}
+		return cpus;
+	}
+
+	/*
+	 *  读取CPU的负载累计值
+	 *  CPU编号[in]：-1时只读取整个系统的steal和CPU压力
+	 */
+	static void ReadLoadSample(int cpuIndex, LoadSample& sample) {
+		sample.time = std::chrono::steady_clock::now();
+#ifndef _WIN32
+		// /proc/stat的CPU行：名称 user nice system idle iowait irq softirq steal ...
+		std::string cpuName = (cpuIndex >= 0) ? "cpu" + std::to_string(cpuIndex) : "cpu";
+		std::ifstream statFile("/proc/stat");
+		std::string line;
+		while (std::getline(statFile, line) && line.compare(0, 3, "cpu") == 0) {
+			std::istringstream fields(line);
+			std::string name;
+			fields >> name;
+			if (name != cpuName) {
+				continue;
+			}
+			unsigned long long value;
+			sample.totalTicks = 0;
+			for (int i = 1; i <= 8 && (fields >> value); ++i) {
+				sample.totalTicks += value;
+				if (i != 4 && i != 5) {
+					sample.busyTicks += value;
+				}
+				if (i == 8) {
+					sample.stealTicks = value;
+				}
+			}
+			break;
+		}
+		// /proc/schedstat的CPU行：名称之后第8个字段为运行队列中等待的时间
+		if (cpuIndex >= 0) {
+			std::ifstream schedstatFile("/proc/schedstat");
+			while (std::getline(schedstatFile, line)) {
+				std::istringstream fields(line);
+				std::string name;
+				fields >> name;
+				if (name != cpuName) {
+					continue;
+				}
+				unsigned long long value = 0;
+				for (int i = 1; i <= 8 && (fields >> value); ++i) {
+				}
+				sample.runDelay = value;
+				break;
+			}
+		}
+		// /proc/pressure/cpu的第一行：some avg10=... avg60=... avg300=... total=...
+		std::ifstream pressureFile("/proc/pressure/cpu");
+		if (std::getline(pressureFile, line)) {
+			size_t found = line.find("total=");
+			if (found != std::string::npos) {
+				sample.pressureTotal = strtoull(line.c_str() + found + 6, NULL, 10);
+			}
+		}
+#else
+		(void)cpuIndex;
+#endif
+	}
+
+	/*
+	 *  返回CPU的负载是否可以开始评测
+	 *  距上次采样不足检查间隔时沿用上次的结论，还没有结论(工作线程刚启动)时直接评测，不等待采样
+	 *  计算时按两次采样之间的增量计算并更新采样
+	 */
+	static bool IsLoadAcceptable(int cpuIndex, const JudgeAdmissionOptions& options, LoadSample& sample) {
+		LoadSample current;
+		ReadLoadSample(cpuIndex, current);
+		long long window = std::chrono::duration_cast<std::chrono::microseconds>(current.time - sample.time).count();
+		if (window < options.retryInterval * 1000) {
+			return sample.isMeasured ? sample.isAcceptable : true;
+		}
+		current.isMeasured = true;
+		current.isAcceptable = true;
+		if (current.totalTicks > sample.totalTicks && current.stealTicks >= sample.stealTicks) {
+			double totalTicks = static_cast<double>(current.totalTicks - sample.totalTicks);
+			double stealRatio = (current.stealTicks - sample.stealTicks) / totalTicks;
+			if (stealRatio > options.maxStealRatio) {
+				current.isAcceptable = false;
+			}
+#ifndef _WIN32
+			// 扣除本工作线程评测消耗的CPU时间
+			if (cpuIndex >= 0 && current.busyTicks >= sample.busyTicks) {
+				double ownTicks = sample.ownCPUTime * sysconf(_SC_CLK_TCK) / 1000.0;
+				double busyRatio = (current.busyTicks - sample.busyTicks - ownTicks) / totalTicks;
+				if (busyRatio > options.maxBusyRatio) {
+					current.isAcceptable = false;
+				}
+			}
+#endif
+		}
+		double runQueueRatio = 0;
+		if (current.runDelay > 0 && current.runDelay >= sample.runDelay) {
+			runQueueRatio = (current.runDelay - sample.runDelay) / 1000.0 / window;
+		} else if (current.pressureTotal >= sample.pressureTotal) {
+			runQueueRatio = static_cast<double>(current.pressureTotal - sample.pressureTotal) / window;
+		}
+		if (runQueueRatio > options.maxRunQueueRatio) {
+			current.isAcceptable = false;
+		}
+		sample = current;
+		return sample.isAcceptable;
+	}
+
+	/*
+	 *  等待CPU的负载降低到可以开始评测，返回false表示引擎正在析构
+	 *  最长等待时间[in]：超过后不再等待，单位毫秒
+	 */
+	bool WaitForAdmission(int cpuIndex, LoadSample& sample, long long maxWaitTime) {
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(maxWaitTime);
+		std::unique_lock<std::mutex> lock(m_jobMutex);
+		while (!m_willExit) {
+			JudgeAdmissionOptions options = m_admission;
+			lock.unlock();
+			bool isAcceptable = !options.isEnabled || std::chrono::steady_clock::now() >= deadline ||
+			                    IsLoadAcceptable(cpuIndex, options, sample);
+			lock.lock();
+			if (isAcceptable) {
+				return true;
+			}
+			++m_admissionStats.deferrals;
+			m_jobCond.wait_for(lock, std::chrono::milliseconds(options.retryInterval), [&] {
+				return m_willExit;
+			});
+		}
+		return false;
+	}
+
+	// 工作线程，依次取出任务，CPU的负载允许时在绑定的CPU上评测
+	static void WorkerThread(JudgeEngine* const classthis, int cpuIndex) {
+		// 启动时先采样一次，之后按增量计算负载
+		LoadSample sample;
+		ReadLoadSample(cpuIndex, sample);
+		while (1) {
+			std::unique_lock<std::mutex> lock(classthis->m_jobMutex);
+			classthis->m_jobCond.wait(lock, [&] {
+				return classthis->m_willExit || !classthis->m_jobQueue.empty();
+			});
+			if (classthis->m_willExit) {
+				return;
+			}
+
+			// 负载过高时任务留在队列中，稍后再试，排队过久的任务直接评测
+			JudgeAdmissionOptions options = classthis->m_admission;
+			bool isQueuedTooLong = std::chrono::steady_clock::now() - classthis->m_jobQueue.front().submitTime >=
+			                       std::chrono::milliseconds(options.maxQueueTime);
+			if (options.isEnabled && !isQueuedTooLong) {
+				lock.unlock();
+				bool isAcceptable = IsLoadAcceptable(cpuIndex, options, sample);
+				lock.lock();
+				if (!isAcceptable) {
+					++classthis->m_admissionStats.deferrals;
+					classthis->m_jobCond.wait_for(lock, std::chrono::milliseconds(options.retryInterval), [&] {
+						return classthis->m_willExit;
+					});
+					continue;
+				}
+				// 检查负载期间任务可能已被其他工作线程取走
+				if (classthis->m_willExit || classthis->m_jobQueue.empty()) {
+					continue;
+				}
+			}
+			QueuedJob queuedJob = std::move(classthis->m_jobQueue.front());
+			classthis->m_jobQueue.pop_front();
+			lock.unlock();
+
+			// 在锁外评测，因评测机负载过大而中止时等待负载降低后重新评测
+			JudgeResult result;
+			while (1) {
+				int overloadReruns = result.overloadReruns;
+				result = JudgeResult();
+				result.cpuIndex = cpuIndex;
+				result.overloadReruns = overloadReruns;
+				const JudgeJob& job = queuedJob.job;
+				ConsoleOJ oj(job.programPath);
+				oj.setCPUAffinity(cpuIndex);
+				oj.setMemoryLimit(job.memoryLimit);
+				oj.setOutputLimit(job.outputLimit);
+				if (job.hasExpectedOutput) {
+					oj.setExpectedOutput(job.expectedOutput);
+				}
+				if (!job.checkerPath.empty()) {
+					oj.setChecker(job.checkerPath);
+				}
+				oj.setCPUTimePolicy(job.cpuTimePolicy, job.isChildProcessCounted);
+				oj.setVerdictCache(job.verdictCache);
+				result.isSucceeded = oj.launchAndWait(job.input, job.timeLimit, result.output,
+				                                      result.timeCosted, result.error);
+				result.verdict = oj.getVerdict();
+				result.peakMemory = oj.getPeakMemory();
+				result.isCached = oj.isVerdictCached();
+				sample.ownCPUTime += result.timeCosted;
+				if (!oj.isOverloaded() || result.overloadReruns >= options.maxOverloadReruns) {
+					break;
+				}
+				++result.overloadReruns;
+				// 至少等待一个检查间隔，使负载有机会降低，之后的负载判断也会重新采样
+				lock.lock();
+				++classthis->m_admissionStats.overloadReruns;
+				classthis->m_jobCond.wait_for(lock, std::chrono::milliseconds(options.retryInterval), [&] {
+					return classthis->m_willExit;
+				});
+				lock.unlock();
+				if (!classthis->WaitForAdmission(cpuIndex, sample, options.maxQueueTime)) {
+					break;
+				}
+			}
+
+			lock.lock();
+			classthis->m_results[queuedJob.id] = std::move(result);
+			classthis->m_isJobDone[queuedJob.id] = true;
+			--classthis->m_pendingJobs;
+			lock.unlock();
+			classthis->m_resultCond.notify_all();
+		}
+	}
+
+public:
+	/*
+	 *  返回默认使用的CPU列表
+	 *  Linux下优先使用隔离的CPU(内核参数isolcpus)，没有隔离的CPU时使用本进程可用的CPU
+	 *  使用本进程可用的CPU时，如果不止一个，则把第一个留给评测机自身的线程
+	 */
+	static std::vector<int> getDefaultCPUs() {
+		std::vector<int> cpus;
+#ifdef _WIN32
+		DWORD_PTR processMask = 0, systemMask = 0;
+		GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+		for (int cpu = 0; cpu < static_cast<int>(sizeof(DWORD_PTR) * 8); ++cpu) {
+			if (processMask & (static_cast<DWORD_PTR>(1) << cpu)) {
+				cpus.push_back(cpu);
+			}
+		}
+#else
+		std::ifstream isolatedFile("/sys/devices/system/cpu/isolated");
+		std::string isolated;
+		if (std::getline(isolatedFile, isolated)) {
+			cpus = ParseCPUList(isolated);
+			if (!cpus.empty()) {
+				return cpus;
+			}
+		}
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0) {
+			for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+				if (CPU_ISSET(cpu, &cpuSet)) {
+					cpus.push_back(cpu);
+				}
+			}
+		}
+#endif
+		if (cpus.size() > 1) {
+			cpus.erase(cpus.begin());
+		}
+		if (cpus.empty()) {
+			cpus.push_back(-1);
+		}
+		return cpus;
+	}
+
+	/*
+	 *  构造时传入：[工作线程绑定的CPU列表]
+	 *  每个CPU启动一个工作线程，列表为空则使用getDefaultCPUs()
+	 *  CPU编号为-1的工作线程不绑定CPU
+	 */
+	explicit JudgeEngine(const std::vector<int>& cpus = std::vector<int>()) : m_cpus(cpus) {
+		if (m_cpus.empty()) {
+			m_cpus = getDefaultCPUs();
+		}
+		for (int cpu : m_cpus) {
+			m_workers.emplace_back(&WorkerThread, this, cpu);
+		}
+	}
+
+	JudgeEngine(const JudgeEngine&) = delete;
+	JudgeEngine& operator=(const JudgeEngine&) = delete;
+
+	// 析构时丢弃未开始的任务，等待正在评测的任务结束
+	~JudgeEngine() {
+		m_jobMutex.lock();
+		m_willExit = true;
+		m_jobQueue.clear();
+		m_jobMutex.unlock();
+		m_jobCond.notify_all();
+		for (std::thread& worker : m_workers) {
+			worker.join();
+		}
+	}
+
+	// 提交一个任务，返回任务编号，编号从0开始依次递增
+	size_t Submit(const JudgeJob& job) {
+		m_jobMutex.lock();
+		size_t id = m_results.size();
+		m_results.emplace_back();
+		m_isJobDone.push_back(false);
+		m_jobQueue.push_back(QueuedJob{ id, job, std::chrono::steady_clock::now() });
+		++m_pendingJobs;
+		m_jobMutex.unlock();
+		m_jobCond.notify_one();
+		return id;
+	}
+
+	// 等待指定任务完成并返回其结果
+	JudgeResult WaitResult(size_t id) {
+		std::unique_lock<std::mutex> lock(m_jobMutex);
+		m_resultCond.wait(lock, [&] {
+			return m_isJobDone.at(id);
+		});
+		return m_results[id];
+	}
+
+	// 等待所有已提交的任务完成
+	void WaitAll() {
+		std::unique_lock<std::mutex> lock(m_jobMutex);
+		m_resultCond.wait(lock, [&] {
+			return m_pendingJobs == 0;
+		});
+	}
+
+	// 提交一组任务并等待全部完成，按提交顺序返回结果
+	std::vector<JudgeResult> RunAll(const std::vector<JudgeJob>& jobs) {
+		std::vector<size_t> ids;
+		for (const JudgeJob& job : jobs) {
+			ids.push_back(Submit(job));
+		}
+		std::vector<JudgeResult> results;
+		for (size_t id : ids) {
+			results.push_back(WaitResult(id));
+		}
+		return results;
+	}
+
+	// 设置准入控制，对之后开始的评测生效
+	void setAdmissionOptions(const JudgeAdmissionOptions& options) {
+		m_jobMutex.lock();
+		m_admission = options;
+		m_jobMutex.unlock();
+		m_jobCond.notify_all();
+	}
+
+	// 返回准入控制的统计信息
+	JudgeAdmissionStats getAdmissionStats() {
+		m_jobMutex.lock();
+		JudgeAdmissionStats stats = m_admissionStats;
+		m_jobMutex.unlock();
+		return stats;
+	}
+
+	// 返回工作线程的数目
+	size_t getWorkerCount() const {
+		return m_workers.size();
+	}
+
+	// 返回工作线程绑定的CPU列表
+	const std::vector<int>& getCPUs() const {
+		return m_cpus;
+	}
+};
+
+#endif /* _XY0797_JUDGEENGINE */
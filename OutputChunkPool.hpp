@@ -0,0 +1,108 @@
+/**
+ * \file    	OutputChunkPool.hpp
+ * \author  	XY0797
+ * \brief		输出块内存池，复用捕获输出用的固定大小内存块
+ */
+#ifndef _XY0797_OUTPUTCHUNKPOOL
+#define _XY0797_OUTPUTCHUNKPOOL 1
+
+#include <mutex>
+#include <vector>
+
+// 输出块内存池的统计信息
+struct OutputChunkPoolStats {
+	// 从空闲列表取到块的次数、需要新分配内存的次数
+	unsigned long long hits = 0;
+	unsigned long long misses = 0;
+	// 正在使用的块数、空闲列表中的块数
+	size_t inUseChunks = 0;
+	size_t freeChunks = 0;
+};
+
+// 固定大小输出块的内存池，线程安全
+// 归还的块放入空闲列表供下次使用，稳定运行时不再分配内存
+class OutputChunkPool {
+private:
+	// 块大小、空闲列表最多保留的块数
+	size_t m_chunkSize;
+	size_t m_maxFreeChunks;
+
+	// 空闲列表和统计信息
+	std::mutex m_poolMutex;
+	std::vector<char*> m_freeChunks;
+	OutputChunkPoolStats m_stats;
+
+public:
+	/*
+	 *  构造时传入：[块大小] [空闲列表最多保留的块数]
+	 *  归还时空闲列表已满则直接释放内存
+	 */
+	explicit OutputChunkPool(size_t chunkSize = 4096, size_t maxFreeChunks = 64)
+		: m_chunkSize(chunkSize), m_maxFreeChunks(maxFreeChunks) {
+		m_freeChunks.reserve(maxFreeChunks);
+	}
+
+	OutputChunkPool(const OutputChunkPool&) = delete;
+	OutputChunkPool& operator=(const OutputChunkPool&) = delete;
+
+	~OutputChunkPool() {
+		for (char* chunk : m_freeChunks) {
+			delete[] chunk;
+		}
+	}
+
+	// 分配一个块，块大小为getChunkSize()
+	char* Allocate() {
+		m_poolMutex.lock();
+		char* chunk;
+		if (!m_freeChunks.empty()) {
+			chunk = m_freeChunks.back();
+			m_freeChunks.pop_back();
+			++m_stats.hits;
+		} else {
+			chunk = nullptr;
+			++m_stats.misses;
+		}
+		++m_stats.inUseChunks;
+		m_poolMutex.unlock();
+
+		// 在锁外分配内存
+		if (chunk == nullptr) {
+			chunk = new char[m_chunkSize];
+		}
+		return chunk;
+	}
+
+	// 归还由Allocate分配的块
+	void Release(char* chunk) {
+		if (chunk == nullptr) {
+			return;
+		}
+		m_poolMutex.lock();
+		--m_stats.inUseChunks;
+		if (m_freeChunks.size() < m_maxFreeChunks) {
+			m_freeChunks.push_back(chunk);
+			chunk = nullptr;
+		}
+		m_poolMutex.unlock();
+
+		// 空闲列表已满，在锁外释放内存
+		delete[] chunk;
+	}
+
+	// 返回块大小
+	size_t getChunkSize() const {
+		return m_chunkSize;
+	}
+
+	// 返回统计信息
+	OutputChunkPoolStats getStats() {
+		m_poolMutex.lock();
+		OutputChunkPoolStats stats = m_stats;
+		stats.freeChunks = m_freeChunks.size();
+		m_poolMutex.unlock();
+		return stats;
+	}
+};
+
+#endif /* _XY0797_OUTPUTCHUNKPOOL */
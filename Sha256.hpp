@@ -0,0 +1,184 @@
+/**
+ * \file    	Sha256.hpp
+ * \author  	XY0797
+ * \brief		流式SHA-256摘要，用于按内容寻址的缓存
+ */
+#ifndef _XY0797_SHA256
+#define _XY0797_SHA256 1
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+// 流式SHA-256摘要，数据可以分段传入
+class Sha256 {
+private:
+	// 当前的哈希值、未满一块的数据和已传入的总字节数
+	uint32_t m_state[8];
+	unsigned char m_block[64];
+	size_t m_blockLen = 0;
+	unsigned long long m_totalLen = 0;
+
+	static uint32_t RotateRight(uint32_t x, int n) {
+		return (x >> n) | (x << (32 - n));
+	}
+
+	// 处理一个64字节的块
+	void Transform(const unsigned char* block) {
+		static const uint32_t k[64] = {
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+		};
+		uint32_t w[64];
+		for (int i = 0; i < 16; ++i) {
+			w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+			       (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | static_cast<uint32_t>(block[i * 4 + 3]);
+		}
+		for (int i = 16; i < 64; ++i) {
+			uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+		uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+		uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+		for (int i = 0; i < 64; ++i) {
+			uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+			uint32_t ch = (e & f) ^ (~e & g);
+			uint32_t temp1 = h + s1 + ch + k[i] + w[i];
+			uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+			uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+			uint32_t temp2 = s0 + maj;
+			h = g;
+			g = f;
+			f = e;
+			e = d + temp1;
+			d = c;
+			c = b;
+			b = a;
+			a = temp1 + temp2;
+		}
+		m_state[0] += a;
+		m_state[1] += b;
+		m_state[2] += c;
+		m_state[3] += d;
+		m_state[4] += e;
+		m_state[5] += f;
+		m_state[6] += g;
+		m_state[7] += h;
+	}
+
+public:
+	Sha256() {
+		Reset();
+	}
+
+	// 重置为初始状态，开始计算新的摘要
+	void Reset() {
+		static const uint32_t initialState[8] = {
+			0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+		};
+		memcpy(m_state, initialState, sizeof(m_state));
+		m_blockLen = 0;
+		m_totalLen = 0;
+	}
+
+	// 传入一段数据
+	void Update(const void* data, size_t len) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		m_totalLen += len;
+		while (len > 0) {
+			size_t copyLen = 64 - m_blockLen;
+			copyLen = (len < copyLen) ? len : copyLen;
+			memcpy(m_block + m_blockLen, bytes, copyLen);
+			m_blockLen += copyLen;
+			bytes += copyLen;
+			len -= copyLen;
+			if (m_blockLen == 64) {
+				Transform(m_block);
+				m_blockLen = 0;
+			}
+		}
+	}
+
+	void Update(const std::string& data) {
+		Update(data.data(), data.size());
+	}
+
+	/*
+	 *  传入一个带长度前缀的字段，用于把多个字段拼成一个键
+	 *  长度前缀使得字段的边界不会产生歧义，如("ab","c")和("a","bc")的摘要不同
+	 */
+	void UpdateField(const std::string& field) {
+		unsigned char lenBytes[8];
+		unsigned long long len = field.size();
+		for (int i = 0; i < 8; ++i) {
+			lenBytes[i] = static_cast<unsigned char>(len >> (8 * i));
+		}
+		Update(lenBytes, sizeof(lenBytes));
+		Update(field);
+	}
+
+	// 传入文件的全部内容，返回是否读取成功
+	bool UpdateFile(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		char buffer[65536];
+		while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+			Update(buffer, static_cast<size_t>(file.gcount()));
+		}
+		return file.eof();
+	}
+
+	// 结束计算，返回小写十六进制的摘要，之后需要Reset才能再次使用
+	std::string FinalHex() {
+		unsigned long long bitLen = m_totalLen * 8;
+		unsigned char padding = 0x80;
+		Update(&padding, 1);
+		padding = 0;
+		while (m_blockLen != 56) {
+			Update(&padding, 1);
+		}
+		unsigned char lenBytes[8];
+		for (int i = 0; i < 8; ++i) {
+			lenBytes[i] = static_cast<unsigned char>(bitLen >> (56 - 8 * i));
+		}
+		Update(lenBytes, sizeof(lenBytes));
+
+		static const char hexDigits[] = "0123456789abcdef";
+		std::string hex;
+		hex.reserve(64);
+		for (uint32_t word : m_state) {
+			for (int shift = 28; shift >= 0; shift -= 4) {
+				hex += hexDigits[(word >> shift) & 0xF];
+			}
+		}
+		return hex;
+	}
+
+	// 计算一段数据的摘要
+	static std::string hashHex(const std::string& data) {
+		Sha256 sha;
+		sha.Update(data);
+		return sha.FinalHex();
+	}
+
+	// 计算文件内容的摘要，读取失败时返回空串
+	static std::string hashFileHex(const std::string& path) {
+		Sha256 sha;
+		if (!sha.UpdateFile(path)) {
+			return "";
+		}
+		return sha.FinalHex();
+	}
+};
+
+#endif /* _XY0797_SHA256 */
@@ -0,0 +1,213 @@
+/**
+ * \file    	VerdictCache.hpp
+ * \author  	XY0797
+ * \brief		评测结果缓存，重测时跳过没有变化的测试数据
+ */
+#ifndef _XY0797_VERDICTCACHE
+#define _XY0797_VERDICTCACHE 1
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "Sha256.hpp"
+
+// 缓存的一次通过的评测
+struct VerdictCacheEntry {
+	// 时间花费和真实时间，单位毫秒
+	long long timeCosted = 0;
+	long long realTimeCosted = 0;
+	// 内存峰值，单位字节
+	size_t peakMemory = 0;
+	// 检查器的输出，没有检查器时为空
+	std::string checkerMessage;
+};
+
+// 评测结果缓存的统计信息
+struct VerdictCacheStats {
+	// 命中的次数、没有缓存的次数
+	unsigned long long hits = 0;
+	unsigned long long misses = 0;
+	// 有缓存但时间或内存接近限制，需要重新评测的次数
+	unsigned long long borderlineReruns = 0;
+	// 存入缓存的次数
+	unsigned long long stores = 0;
+};
+
+/*
+ *  评测结果缓存，线程安全，多个进程可以共用同一个缓存目录
+ *  键为(目标程序, 输入, 标准答案, 检查器, 各项限制, 评测机版本)的SHA-256，由ConsoleOJ生成
+ *  只缓存通过的评测：未通过的结果可能不稳定(如读取未初始化的内存)，重测时总是重新运行
+ *  时间或内存超过限制的一定比例(临界比例)的缓存不使用，重新评测并更新缓存
+ *  每个键一个小文件，按键的前两位分到子目录，写入临时文件后原子地重命名
+ */
+class VerdictCache {
+private:
+	// 缓存目录、评测机版本和临界比例
+	std::filesystem::path m_cacheDirectory;
+	std::string m_judgeVersion;
+	double m_borderlineRatio;
+
+	// 文件摘要的缓存，文件的大小和修改时间不变时不重新计算
+	struct FileHash {
+		uintmax_t size;
+		std::filesystem::file_time_type lastWriteTime;
+		std::string hash;
+	};
+	std::mutex m_cacheMutex;
+	std::map<std::string, FileHash> m_fileHashes;
+	VerdictCacheStats m_stats;
+
+	// 临时文件名的随机部分和编号，使得不同进程的临时文件不会重名
+	unsigned long long m_tempTag;
+	unsigned long long m_tempCounter = 0;
+
+	// 返回键对应的缓存文件路径
+	std::filesystem::path GetEntryPath(const std::string& key) const {
+		return m_cacheDirectory / key.substr(0, 2) / key;
+	}
+
+public:
+	/*
+	 *  构造时传入：[缓存目录] [评测机版本] [临界比例]
+	 *  缓存目录不存在时自动创建
+	 *  评测机版本[in]：评测机或评测环境升级后传入新的版本，旧的缓存自动失效
+	 *  临界比例[in]：缓存的时间花费超过时间限制乘以该比例，或内存峰值超过内存限制乘以该比例时重新评测
+	 */
+	explicit VerdictCache(const std::string& cacheDirectory, const std::string& judgeVersion = "",
+	                      double borderlineRatio = 0.5)
+		: m_judgeVersion(judgeVersion), m_borderlineRatio(borderlineRatio) {
+		std::error_code errorCode;
+		std::filesystem::create_directories(cacheDirectory, errorCode);
+		m_cacheDirectory = std::filesystem::absolute(cacheDirectory, errorCode);
+		std::random_device randomDevice;
+		m_tempTag = (static_cast<unsigned long long>(randomDevice()) << 32) | randomDevice();
+	}
+
+	VerdictCache(const VerdictCache&) = delete;
+	VerdictCache& operator=(const VerdictCache&) = delete;
+
+	// 计算文件内容的摘要，读取失败时返回空串，文件的大小和修改时间不变时直接返回上次的结果
+	std::string HashFile(const std::string& path) {
+		std::error_code errorCode;
+		uintmax_t size = std::filesystem::file_size(path, errorCode);
+		if (errorCode) {
+			return "";
+		}
+		std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(path, errorCode);
+		if (errorCode) {
+			return "";
+		}
+		m_cacheMutex.lock();
+		auto found = m_fileHashes.find(path);
+		if (found != m_fileHashes.end() && found->second.size == size &&
+		    found->second.lastWriteTime == lastWriteTime) {
+			std::string hash = found->second.hash;
+			m_cacheMutex.unlock();
+			return hash;
+		}
+		m_cacheMutex.unlock();
+
+		// 在锁外计算摘要
+		std::string hash = Sha256::hashFileHex(path);
+		if (!hash.empty()) {
+			m_cacheMutex.lock();
+			m_fileHashes[path] = FileHash{ size, lastWriteTime, hash };
+			m_cacheMutex.unlock();
+		}
+		return hash;
+	}
+
+	// 由各个字段和评测机版本生成键
+	std::string MakeKey(const std::vector<std::string>& fields) const {
+		Sha256 sha;
+		sha.UpdateField("VerdictCache 1");
+		sha.UpdateField(m_judgeVersion);
+		for (const std::string& field : fields) {
+			sha.UpdateField(field);
+		}
+		return sha.FinalHex();
+	}
+
+	/*
+	 *  查询缓存，返回是否可以使用缓存的结果
+	 *  键[in]：MakeKey生成的键
+	 *  时间限制[in]：单位毫秒，内存限制[in]：单位字节，0为不限制，用于判断是否接近限制
+	 *  缓存项[out]：命中时返回缓存的结果
+	 */
+	bool Lookup(const std::string& key, long long timeLimit, size_t memoryLimit, VerdictCacheEntry& entry) {
+		std::ifstream entryFile(GetEntryPath(key).string(), std::ios::binary);
+		VerdictCacheEntry cachedEntry;
+		bool isFound = static_cast<bool>(entryFile >> cachedEntry.timeCosted >> cachedEntry.realTimeCosted
+		                                           >> cachedEntry.peakMemory);
+		if (isFound) {
+			entryFile.get();
+			std::ostringstream message;
+			message << entryFile.rdbuf();
+			cachedEntry.checkerMessage = message.str();
+		}
+		bool isBorderline = isFound &&
+		                    (cachedEntry.timeCosted > timeLimit * m_borderlineRatio ||
+		                     (memoryLimit > 0 && cachedEntry.peakMemory > memoryLimit * m_borderlineRatio));
+
+		m_cacheMutex.lock();
+		if (!isFound) {
+			++m_stats.misses;
+		} else if (isBorderline) {
+			++m_stats.borderlineReruns;
+		} else {
+			++m_stats.hits;
+		}
+		m_cacheMutex.unlock();
+
+		if (!isFound || isBorderline) {
+			return false;
+		}
+		entry = std::move(cachedEntry);
+		return true;
+	}
+
+	// 存入一次通过的评测，已有相同的键时覆盖
+	void Store(const std::string& key, const VerdictCacheEntry& entry) {
+		std::filesystem::path entryPath = GetEntryPath(key);
+		std::error_code errorCode;
+		std::filesystem::create_directories(entryPath.parent_path(), errorCode);
+
+		m_cacheMutex.lock();
+		std::filesystem::path tempPath = entryPath.parent_path() /
+		                                 ("tmp-" + std::to_string(m_tempTag) + "-" + std::to_string(m_tempCounter++));
+		m_cacheMutex.unlock();
+
+		std::ofstream entryFile(tempPath.string(), std::ios::binary | std::ios::trunc);
+		entryFile << entry.timeCosted << ' ' << entry.realTimeCosted << ' ' << entry.peakMemory << '\n'
+		          << entry.checkerMessage;
+		entryFile.close();
+		if (!entryFile) {
+			std::filesystem::remove(tempPath, errorCode);
+			return;
+		}
+		std::filesystem::rename(tempPath, entryPath, errorCode);
+		if (errorCode) {
+			std::filesystem::remove(tempPath, errorCode);
+			return;
+		}
+
+		m_cacheMutex.lock();
+		++m_stats.stores;
+		m_cacheMutex.unlock();
+	}
+
+	// 返回统计信息
+	VerdictCacheStats getStats() {
+		m_cacheMutex.lock();
+		VerdictCacheStats stats = m_stats;
+		m_cacheMutex.unlock();
+		return stats;
+	}
+};
+
+#endif /* _XY0797_VERDICTCACHE */
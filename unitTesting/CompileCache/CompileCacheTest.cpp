@@ -0,0 +1,70 @@
+// CompileCache的测试：命中与未命中、编译选项不同时分别缓存、编译失败不缓存、并发编译相同的源码只编译一次
+// 用法：CompileCacheTest [编译器路径]，默认为/usr/bin/g++
+// 源码和缓存目录写入临时目录，测试结束后删除
+#include "../../CompileCache.hpp"
+#include "../TestCheck.hpp"
+#include <fstream>
+#include <filesystem>
+#include <thread>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+	string compilerPath = (argc > 1) ? argv[1] : "/usr/bin/g++";
+
+	filesystem::path testDirectory = filesystem::temp_directory_path() / "CompileCacheTest";
+	filesystem::remove_all(testDirectory);
+	filesystem::create_directories(testDirectory);
+	string helloPath = (testDirectory / "hello.cpp").string();
+	string brokenPath = (testDirectory / "broken.cpp").string();
+	string twicePath = (testDirectory / "twice.cpp").string();
+	ofstream(helloPath) << "#include <cstdio>\nint main() { puts(\"hello\"); return 0; }\n";
+	ofstream(brokenPath) << "int main() { return undefinedName; }\n";
+	ofstream(twicePath) << "int main() { return 0; }\n";
+
+	CompileCache cache((testDirectory / "cache").string());
+	string binaryPath, cachedPath, message;
+
+	// 第一次编译，运行编译出的程序
+	check("编译", cache.Compile(helloPath, compilerPath, { "-O0" }, binaryPath, message), true);
+	ConsoleOJ hello(binaryPath);
+	string output, error;
+	long long timeCosted;
+	hello.launchAndWait("", 1000, output, timeCosted, error);
+	check("运行编译出的程序", output, string("hello\n"));
+
+	// 相同的源码和选项命中缓存
+	check("再次编译", cache.Compile(helloPath, compilerPath, { "-O0" }, cachedPath, message), true);
+	check("命中时的路径", cachedPath, binaryPath);
+	check("命中时的编译信息", message, string());
+
+	// 编译选项不同时是另一个键
+	check("不同的选项", cache.Compile(helloPath, compilerPath, { "-O2" }, cachedPath, message), true);
+	check("不同选项的路径", cachedPath != binaryPath, true);
+
+	// 编译失败不缓存，再次编译仍然失败
+	check("编译失败", cache.Compile(brokenPath, compilerPath, {}, cachedPath, message), false);
+	check("编译失败的信息", message.find("undefinedName") != string::npos, true);
+	check("再次编译失败", cache.Compile(brokenPath, compilerPath, {}, cachedPath, message), false);
+	check("源文件不存在", cache.Compile(helloPath + ".none", compilerPath, {}, cachedPath, message), false);
+
+	// 两个线程同时编译相同的源码，只编译一次
+	string firstPath, secondPath, firstMessage, secondMessage;
+	thread first([&] {
+		cache.Compile(twicePath, compilerPath, {}, firstPath, firstMessage);
+	});
+	thread second([&] {
+		cache.Compile(twicePath, compilerPath, {}, secondPath, secondMessage);
+	});
+	first.join();
+	second.join();
+	check("并发编译的路径", firstPath, secondPath);
+
+	CompileCacheStats stats = cache.getStats();
+	check("命中次数", stats.hits, 2ull);
+	check("编译次数", stats.misses, 5ull);
+	check("编译失败次数", stats.compileErrors, 2ull);
+
+	filesystem::remove_all(testDirectory);
+	return testSummary();
+}
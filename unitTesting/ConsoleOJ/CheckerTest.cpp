@@ -0,0 +1,46 @@
+// 检查器(special judge)的评测结果测试：AC、WA、PE、PC、检查器失败
+// 用法：CheckerTest [目标程序所在目录]
+// 目标程序为TestPrograms下的Echo和Checker，先编译到同一目录：g++ -O2 Echo.cpp -o Echo，g++ -O2 Checker.cpp -o Checker
+#include "../../ConsoleOJ.hpp"
+#include "../TestCheck.hpp"
+#include <fstream>
+#include <filesystem>
+
+using namespace std;
+
+// Echo原样输出输入，由检查器判定，返回评测结果的简写
+string judge(ConsoleOJ& program, const string& input) {
+	string output, error;
+	long long timeCosted;
+	program.launchAndWait(input, 1000, output, timeCosted, error);
+	return judgeVerdictName(program.getVerdict());
+}
+
+int main(int argc, char* argv[]) {
+	string directory = testProgramDirectory(argc, argv);
+
+	ConsoleOJ program(directory + "Echo");
+	program.setChecker(directory + "Checker");
+	program.setExpectedOutput("42\n");
+	check("AC", judge(program, "42\n"), string("AC"));
+	check("AC的检查器信息", program.getCheckerMessage(), string("ok\n"));
+	check("WA", judge(program, "43\n"), string("WA"));
+	check("PE", judge(program, "PE\n"), string("PE"));
+	check("PC", judge(program, "PC\n"), string("PC"));
+	check("PC的检查器信息", program.getCheckerMessage(), string("points 50\n"));
+	check("检查器失败", judge(program, "FAIL\n"), string("SE"));
+
+	// 标准答案来自文件时直接传给检查器
+	filesystem::path answerPath = filesystem::temp_directory_path() / "CheckerTest.ans";
+	ofstream(answerPath.string()) << "7\n";
+	check("标准答案文件", program.setExpectedOutputFile(answerPath.string()), true);
+	check("标准答案文件AC", judge(program, "7\n"), string("AC"));
+	check("标准答案文件WA", judge(program, "42\n"), string("WA"));
+
+	// 检查器不存在时为评测机错误
+	program.setChecker(directory + "NotExist");
+	check("检查器不存在", judge(program, "7\n"), string("SE"));
+	filesystem::remove(answerPath);
+
+	return testSummary();
+}
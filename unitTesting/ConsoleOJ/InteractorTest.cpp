@@ -0,0 +1,36 @@
+// 交互题的评测结果测试：AC、WA、ILE、RE，以及等待较慢的交互器不算空闲
+// 用法：InteractorTest [目标程序所在目录]
+// 目标程序为TestPrograms下的Interactor、Guess、DumbGuess、Silent、Quit，先编译到同一目录：g++ -O2 Guess.cpp -o Guess，依此类推
+#include "../../ConsoleOJ.hpp"
+#include "../TestCheck.hpp"
+
+using namespace std;
+
+// 与猜数交互器交互一次，返回评测结果的简写
+string judge(const string& directory, const string& programName, const string& input, long long timelimit) {
+	ConsoleOJ program(directory + programName);
+	long long timeCosted;
+	string error;
+	program.launchInteractive(directory + "Interactor", input, timelimit, 5000, timeCosted, error);
+	return judgeVerdictName(program.getVerdict());
+}
+
+int main(int argc, char* argv[]) {
+	string directory = testProgramDirectory(argc, argv);
+
+	check("AC", judge(directory, "Guess", "123456\n", 1000), string("AC"));
+	check("WA(交互器判定)", judge(directory, "DumbGuess", "123456\n", 1000), string("WA"));
+	check("ILE(互相等待)", judge(directory, "Silent", "123456\n", 500), string("ILE"));
+	check("RE(目标程序先结束)", judge(directory, "Quit", "123456\n", 1000), string("RE"));
+	// 交互器第一次回答前计算1.5秒，目标程序在这段时间内等待管道，不算空闲
+	check("等待较慢的交互器", judge(directory, "Guess", "123456 1500\n", 500), string("AC"));
+
+	// 交互器的标准错误作为检查器信息
+	ConsoleOJ program(directory + "Guess");
+	long long timeCosted;
+	string error;
+	program.launchInteractive(directory + "Interactor", "1\n", 1000, 5000, timeCosted, error);
+	check("交互器信息", program.getCheckerMessage(), string("ok 29次\n"));
+
+	return testSummary();
+}
@@ -0,0 +1,168 @@
+// Linux下ConsoleOJ的评测结果测试：AC、WA(含边输出边比较)、TLE、RE、OLE、MLE、ILE，计时方式，文件输入
+// 用法：VerdictTest [目标程序所在目录]
+// 目标程序为TestPrograms下的Sum、WrongSum、Loop、Abort、Flood、Alloc、Sleep、Echo、Spin，先编译到同一目录：g++ -O2 Sum.cpp -o Sum，依此类推
+#include "../../ConsoleOJ.hpp"
+#include "../TestCheck.hpp"
+#include <csignal>
+#include <fstream>
+#include <filesystem>
+#include <unistd.h>
+
+using namespace std;
+
+// 用给定的输入和标准答案评测一次，返回评测结果的简写，标准答案为空时只检查程序能否正常结束
+string judge(ConsoleOJ& program, const string& input, const string& answer, long long timelimit) {
+	string output, error;
+	long long timeCosted;
+	if (answer.empty()) {
+		program.clearExpectedOutput();
+	} else {
+		program.setExpectedOutput(answer);
+	}
+	program.launchAndWait(input, timelimit, output, timeCosted, error);
+	return judgeVerdictName(program.getVerdict());
+}
+
+int main(int argc, char* argv[]) {
+	string directory = testProgramDirectory(argc, argv);
+
+	ConsoleOJ sum(directory + "Sum");
+	check("AC", judge(sum, "1 2\n", "3\n", 1000), string("AC"));
+	check("AC的退出代码", sum.getExitCode(), 0);
+	check("缺少末尾换行仍为AC", judge(sum, "1 2", "3", 1000), string("AC"));
+
+	ConsoleOJ wrongSum(directory + "WrongSum");
+	check("WA", judge(wrongSum, "1 2\n", "3\n", 1000), string("WA"));
+	check("WA的差异位置", wrongSum.getMismatchOffset(), static_cast<size_t>(0));
+	check("WA的结束信号", wrongSum.getExitSignal(), 0);
+
+	// 边输出边比较：不停输出的程序在第二个记号处与标准答案不一致，不等程序结束立即判为WA
+	ConsoleOJ streamingFlood(directory + "Flood");
+	string floodLine = "0123456789012345678901234567890123456789012345678901234567890123\n";
+	check("WA(边输出边比较)", judge(streamingFlood, "", floodLine + "end\n", 1000), string("WA"));
+	check("边输出边比较的差异位置", streamingFlood.getMismatchOffset(), floodLine.size());
+
+	ConsoleOJ loop(directory + "Loop");
+	check("TLE", judge(loop, "", "", 200), string("TLE"));
+	// 按截止时间检查，超时后很快结束，不必等到下一个固定间隔
+	for (long long timelimit : { 150LL, 250LL }) {
+		string output, error;
+		long long timeCosted;
+		loop.launchAndWait("", timelimit, output, timeCosted, error);
+		check("TLE的时间花费超过限制(" + to_string(timelimit) + "ms)", timeCosted > timelimit, true);
+		check("TLE后及时结束(" + to_string(timelimit) + "ms)", loop.getRealTimeCosted() < timelimit + 60, true);
+	}
+
+	ConsoleOJ abortProgram(directory + "Abort");
+	check("RE(返回值)", judge(abortProgram, "0\n", "", 1000), string("RE"));
+	check("RE的退出代码", abortProgram.getExitCode(), 3);
+	check("RE(信号)", judge(abortProgram, "1\n", "", 1000), string("RE"));
+	check("RE的结束信号", abortProgram.getExitSignal(), static_cast<int>(SIGABRT));
+
+	ConsoleOJ flood(directory + "Flood");
+	flood.setOutputLimit(1 << 16);
+	check("OLE", judge(flood, "", "", 1000), string("OLE"));
+	check("OLE的结束信号", flood.getExitSignal(), 0);
+	{
+		string output, error;
+		long long timeCosted;
+		flood.launchAndWait("", 1000, output, timeCosted, error);
+		check("OLE时保留限制以内的输出", output.size(), static_cast<size_t>(1 << 16));
+	}
+
+	// 输出恰好等于限制时不算超限
+	sum.setOutputLimit(2);
+	check("输出等于限制", judge(sum, "1 2\n", "3\n", 1000), string("AC"));
+	sum.setOutputLimit(1);
+	check("输出超过限制一个字节", judge(sum, "1 2\n", "3\n", 1000), string("OLE"));
+	sum.setOutputLimit(0);
+
+	// 内存超限：默认的cgroup可用时被OOM结束，结果为MLE
+	// 不可用时由RLIMIT_AS限制，申请内存失败，按文档表现为运行错误或输出不一致，只检查未通过
+	ConsoleOJ alloc(directory + "Alloc");
+	check("内存限制内", judge(alloc, "32\n", "done 1\n", 1000), string("AC"));
+	check("内存峰值", alloc.getPeakMemory() >= (static_cast<size_t>(32) << 20), true);
+	alloc.setMemoryLimit(static_cast<size_t>(64) << 20);
+	check("设置内存限制后限制内", judge(alloc, "16\n", "done 1\n", 1000), string("AC"));
+	string allocVerdict = judge(alloc, "256\n", "done 1\n", 1000);
+	if (access("/sys/fs/cgroup/ConsoleOJ/cgroup.subtree_control", W_OK) == 0) {
+		check("MLE(cgroup)", allocVerdict, string("MLE"));
+	} else {
+		check("超过RLIMIT_AS时未通过", allocVerdict != "AC", true);
+		check("超过RLIMIT_AS时的内存峰值", alloc.getPeakMemory() < (static_cast<size_t>(64) << 20), true);
+	}
+
+	// 计时方式：休眠不计入CPU时间，按真实时间计算时计入
+	ConsoleOJ sleepProgram(directory + "Sleep");
+	{
+		string output, error;
+		long long timeCosted;
+		sleepProgram.setExpectedOutput("done\n");
+		sleepProgram.launchAndWait("300\n", 1000, output, timeCosted, error);
+		check("CPU时间不计入休眠", timeCosted < 100, true);
+		sleepProgram.setCPUTimePolicy(CPUTimePolicy::WallClockTime);
+		sleepProgram.launchAndWait("300\n", 1000, output, timeCosted, error);
+		check("真实时间的结果", string(judgeVerdictName(sleepProgram.getVerdict())), string("AC"));
+		check("真实时间计入休眠", timeCosted >= 300, true);
+	}
+
+	// 输入来自文件或管道，读到末尾即为EOF，Ctrl+Z不再作为结束标记
+	ConsoleOJ echo(directory + "Echo");
+	{
+		string input("1 2\n\x1a" "3\n", 7);
+		string inputPath = (filesystem::temp_directory_path() / "VerdictTestInput.txt").string();
+		ofstream(inputPath, ios::binary) << input;
+		string output, error;
+		long long timeCosted;
+		echo.launchAndWaitFile(inputPath, 1000, output, timeCosted, error);
+		check("文件输入读到EOF", string(judgeVerdictName(echo.getVerdict())), string("AC"));
+		check("文件输入原样读入", output, input);
+		echo.launchAndWait(input, 1000, output, timeCosted, error);
+		check("管道输入原样读入", output, input);
+		filesystem::remove(inputPath);
+		echo.launchAndWaitFile(inputPath, 1000, output, timeCosted, error);
+		check("输入文件不存在", string(judgeVerdictName(echo.getVerdict())), string("SE"));
+	}
+
+	// 空闲：休眠超过空闲时间限制(默认等于时间限制)时为ILE，放宽限制后正常结束
+	ConsoleOJ idle(directory + "Sleep");
+	check("ILE", judge(idle, "3000\n", "done\n", 300), string("ILE"));
+	check("ILE后及时结束", idle.getRealTimeCosted() < 1000, true);
+	idle.setIdleLimit(3000);
+	check("放宽空闲时间限制", judge(idle, "1000\n", "done\n", 300), string("AC"));
+
+	// 性能计数器的计时方式，不可用时结果为SE，此时跳过
+	ConsoleOJ spin(directory + "Spin");
+	spin.setExpectedOutput("done\n");
+	spin.setCPUTimePolicy(CPUTimePolicy::TaskClock);
+	{
+		string output, error;
+		long long timeCosted;
+		spin.launchAndWait("200\n", 1000, output, timeCosted, error);
+		if (spin.getVerdict() == JudgeVerdict::SystemError) {
+			cout << "跳过：性能计数器不可用，" << error << '\n';
+		} else {
+			check("任务时钟的结果", string(judgeVerdictName(spin.getVerdict())), string("AC"));
+			check("任务时钟的时间花费", timeCosted >= 150 && timeCosted < 400, true);
+			check("任务时钟的纳秒数", static_cast<long long>(spin.getTaskClockNanoseconds() / 1000000), timeCosted);
+		}
+		// 指令数需要硬件计数器，虚拟机中常常不可用
+		spin.setCPUTimePolicy(CPUTimePolicy::Instructions);
+		spin.setInstructionRate(1000);
+		spin.launchAndWait("200\n", 1000000000, output, timeCosted, error);
+		if (spin.getVerdict() == JudgeVerdict::SystemError) {
+			cout << "跳过：硬件性能计数器不可用，" << error << '\n';
+			check("计数器不可用时的时间花费", timeCosted, 0LL);
+		} else {
+			check("指令数的结果", string(judgeVerdictName(spin.getVerdict())), string("AC"));
+			check("指令数按速率换算", timeCosted, static_cast<long long>(spin.getInstructionCount() / 1000));
+			spin.launchAndWait("200\n", 10, output, timeCosted, error);
+			check("指令数超过限制", string(judgeVerdictName(spin.getVerdict())), string("TLE"));
+		}
+	}
+
+	ConsoleOJ missing(directory + "NotExist");
+	check("程序不存在", judge(missing, "", "", 1000), string("SE"));
+
+	return testSummary();
+}
@@ -0,0 +1,54 @@
+// 进程创建延迟的基准测试，对比每次fork与使用zygote
+// 用法：SpawnBenchmark 目标程序 [次数] [评测机额外占用的内存MB]
+// 额外占用的内存模拟大型评测机，fork需要复制的页表随之增大
+#include "../../ConsoleOJ.hpp"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+// 运行若干次空输入的评测，返回平均每次的真实时间，单位微秒
+double benchmark(ConsoleOJ& program, int times) {
+	string output, error;
+	long long timeCosted;
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < times; ++i) {
+		if (!program.launchAndWait("", 1000, output, timeCosted, error)) {
+			cout << "失败：" << error << '\n';
+		}
+	}
+	auto elapsed = chrono::steady_clock::now() - start;
+	return chrono::duration_cast<chrono::microseconds>(elapsed).count() / static_cast<double>(times);
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		cout << "用法：SpawnBenchmark 目标程序 [次数] [评测机额外占用的内存MB]\n";
+		return 1;
+	}
+	int times = (argc > 2) ? atoi(argv[2]) : 500;
+	size_t ballastSize = (argc > 3) ? static_cast<size_t>(atoi(argv[3])) << 20 : 0;
+
+	// zygote在占用内存之前创建
+	ConsoleOJZygote zygote;
+	if (!zygote.isAvailable()) {
+		cout << "zygote创建失败\n";
+		return 1;
+	}
+	char* ballast = new char[ballastSize + 1];
+	memset(ballast, 1, ballastSize + 1);
+
+	ConsoleOJ program(argv[1]);
+	double forkLatency = benchmark(program, times);
+	program.setZygote(&zygote);
+	double zygoteLatency = benchmark(program, times);
+
+	ConsoleOJZygoteStats stats = zygote.getStats();
+	cout << "fork：  " << forkLatency << "微秒/次\n";
+	cout << "zygote：" << zygoteLatency << "微秒/次\n";
+	cout << "zygote启动" << stats.spawns << "次，就绪" << stats.readyHits << "次，等待"
+	     << stats.readyWaits << "次，退回fork " << stats.fallbacks << "次\n";
+	delete[] ballast;
+	return 0;
+}
@@ -0,0 +1,66 @@
+// judgeDirectory的测试：测试数据的自然顺序、标准答案的查找、汇总统计和JSON报告
+// 用法：DirectoryJudgeTest [目标程序所在目录]
+// 目标程序为TestPrograms下的Sum，先编译：g++ -O2 Sum.cpp -o Sum
+// 测试数据写入临时目录，测试结束后删除
+#include "../../DirectoryJudge.hpp"
+#include "../TestCheck.hpp"
+#include <fstream>
+#include <filesystem>
+
+using namespace std;
+
+// 在目录中写入一个文件
+void writeFile(const filesystem::path& directory, const string& name, const string& content) {
+	ofstream((directory / name).string(), ios::binary) << content;
+}
+
+int main(int argc, char* argv[]) {
+	string directory = testProgramDirectory(argc, argv);
+
+	// 10排在2之后；3没有标准答案，只检查能否正常结束；2的标准答案为.ans；10的标准答案错误
+	filesystem::path dataDirectory = filesystem::temp_directory_path() / "DirectoryJudgeTest";
+	filesystem::remove_all(dataDirectory);
+	filesystem::create_directories(dataDirectory);
+	writeFile(dataDirectory, "1.in", "1 2\n");
+	writeFile(dataDirectory, "1.out", "3\n");
+	writeFile(dataDirectory, "2.in", "3 4\n");
+	writeFile(dataDirectory, "2.ans", "7\n");
+	writeFile(dataDirectory, "3.in", "5 6\n");
+	writeFile(dataDirectory, "10.in", "1 1\n");
+	writeFile(dataDirectory, "10.out", "3\n");
+	writeFile(dataDirectory, "a\"b.in", "0 0\n");
+	writeFile(dataDirectory, "a\"b.out", "0\n");
+	writeFile(dataDirectory, "readme.txt", "不是测试数据\n");
+
+	DirectoryJudgeResult result = judgeDirectory(directory + "Sum", dataDirectory.string());
+	string json = result.toJSON();
+	cout << json;
+	check("总数", result.totalCount, static_cast<size_t>(5));
+	check("已评测数", result.judgedCount, static_cast<size_t>(5));
+	check("通过数", result.passedCount, static_cast<size_t>(4));
+	check("总体结果", string(judgeVerdictName(result.verdict)), string("WA"));
+	string order;
+	for (const TestCaseResult& testCase : result.testCases) {
+		order += testCase.name + " ";
+	}
+	check("自然顺序", order, string("1 2 3 10 a\"b "));
+	check("JSON开头", json.substr(0, 40), string("{\"verdict\":\"WA\",\"totalCount\":5,\"judgedCo"));
+	check("JSON中的WA", json.find("{\"name\":\"10\",\"verdict\":\"WA\"") != string::npos, true);
+	check("JSON转义", json.find("{\"name\":\"a\\\"b\",\"verdict\":\"AC\"") != string::npos, true);
+	check("JSON结尾", json.substr(json.size() - 4), string("}]}\n"));
+
+	// 在第一组未通过的测试数据后停止
+	writeFile(dataDirectory, "2.ans", "8\n");
+	DirectoryJudgeOptions options;
+	options.isStopAtFirstFailure = true;
+	result = judgeDirectory(directory + "Sum", dataDirectory.string(), options);
+	check("停止后的已评测数", result.judgedCount, static_cast<size_t>(2));
+	check("停止后的通过数", result.passedCount, static_cast<size_t>(1));
+
+	// 目录不存在时没有测试数据
+	result = judgeDirectory(directory + "Sum", (dataDirectory / "NotExist").string());
+	check("目录不存在", string(judgeVerdictName(result.verdict)), string("None"));
+
+	filesystem::remove_all(dataDirectory);
+	return testSummary();
+}
@@ -0,0 +1,103 @@
+// JudgeEngine的测试(仅Linux)：任务的评测设置，准入控制默认关闭、负载过高时推迟评测、排队超时后直接评测、负载过大时重新评测
+// 用法：JudgeEngineTest [目标程序所在目录]
+// 目标程序为TestPrograms下的Sum和Starve，先编译到同一目录：g++ -O2 Sum.cpp -o Sum，g++ -O2 Starve.cpp -o Starve
+// 工作线程和模拟其他进程的空转线程都绑定在CPU 0上
+#include "../../JudgeEngine.hpp"
+#include "../TestCheck.hpp"
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+// 绑定在指定CPU上空转的线程，模拟评测机上的其他进程
+class Hog {
+private:
+	atomic<bool> m_willExit{ false };
+	thread m_thread;
+
+public:
+	explicit Hog(int cpuIndex) {
+		m_thread = thread([this] {
+			volatile unsigned long long counter = 0;
+			while (!m_willExit) {
+				++counter;
+			}
+		});
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(cpuIndex, &cpuSet);
+		pthread_setaffinity_np(m_thread.native_handle(), sizeof(cpuSet), &cpuSet);
+	}
+
+	~Hog() {
+		m_willExit = true;
+		m_thread.join();
+	}
+};
+
+int main(int argc, char* argv[]) {
+	string directory = testProgramDirectory(argc, argv);
+	JudgeJob sumJob;
+	sumJob.programPath = directory + "Sum";
+	sumJob.input = "1 2\n";
+	JudgeJob starveJob;
+	starveJob.programPath = directory + "Starve";
+	starveJob.timeLimit = 20;
+
+	// 任务的评测设置应用到评测该任务的ConsoleOJ
+	{
+		JudgeEngine engine({ 0 });
+		JudgeJob answerJob = sumJob;
+		answerJob.hasExpectedOutput = true;
+		answerJob.expectedOutput = "4\n";
+		JudgeJob limitJob = sumJob;
+		limitJob.outputLimit = 1;
+		JudgeResult answerResult = engine.WaitResult(engine.Submit(answerJob));
+		JudgeResult limitResult = engine.WaitResult(engine.Submit(limitJob));
+		check("任务的标准答案", string(judgeVerdictName(answerResult.verdict)), string("WA"));
+		check("任务的输出限制", string(judgeVerdictName(limitResult.verdict)), string("OLE"));
+	}
+
+	// 默认关闭准入控制，有其他进程占用CPU时也立即评测
+	{
+		JudgeEngine engine({ 0 });
+		Hog hog(0);
+		this_thread::sleep_for(chrono::milliseconds(300));
+		JudgeResult result = engine.WaitResult(engine.Submit(sumJob));
+		check("默认关闭时的结果", result.output, string("3\n"));
+		check("默认关闭时不推迟", engine.getAdmissionStats().deferrals, 0ull);
+	}
+
+	// 开启后CPU被占用时推迟评测，排队超过maxQueueTime后直接评测
+	{
+		JudgeEngine engine({ 0 });
+		JudgeAdmissionOptions options;
+		options.isEnabled = true;
+		options.maxQueueTime = 1000;
+		engine.setAdmissionOptions(options);
+		Hog hog(0);
+		this_thread::sleep_for(chrono::milliseconds(300));
+		auto start = chrono::steady_clock::now();
+		JudgeResult result = engine.WaitResult(engine.Submit(sumJob));
+		long long waited = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+		check("排队超时后的结果", result.output, string("3\n"));
+		check("负载过高时推迟", engine.getAdmissionStats().deferrals > 0, true);
+		check("排队时间达到maxQueueTime", waited >= options.maxQueueTime, true);
+	}
+
+	// 目标程序得不到CPU时判为评测机负载过大，等待后重新评测，重测次数用完后返回评测机错误
+	{
+		JudgeEngine engine({ 0 });
+		JudgeAdmissionOptions options;
+		options.maxOverloadReruns = 1;
+		engine.setAdmissionOptions(options);
+		Hog hog(0);
+		JudgeResult result = engine.WaitResult(engine.Submit(starveJob));
+		check("负载过大的结果", result.isSucceeded, false);
+		check("负载过大的错误信息", result.error, string("评测机负载过大，执行超时！"));
+		check("重新评测次数", result.overloadReruns, 1);
+		check("统计的重新评测次数", engine.getAdmissionStats().overloadReruns, 1ull);
+	}
+
+	return testSummary();
+}
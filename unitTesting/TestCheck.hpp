@@ -0,0 +1,37 @@
+/**
+ * \file    	TestCheck.hpp
+ * \author  	XY0797
+ * \brief		测试程序共用的检查函数
+ */
+#ifndef _XY0797_TESTCHECK
+#define _XY0797_TESTCHECK 1
+
+#include <iostream>
+#include <string>
+
+// 失败的检查次数
+inline int testFailures = 0;
+
+// 比较实际值与期望值，输出结果并记录失败次数
+template <typename T>
+void check(const std::string& name, const T& actual, const T& expected) {
+	if (actual == expected) {
+		std::cout << "通过：" << name << '\n';
+	} else {
+		std::cout << "失败：" << name << "，实际为" << actual << "，期望为" << expected << '\n';
+		++testFailures;
+	}
+}
+
+// 返回命令行第一个参数给出的目标程序所在目录，以/结尾，没有参数时为当前目录
+inline std::string testProgramDirectory(int argc, char* argv[]) {
+	return (argc > 1) ? std::string(argv[1]) + "/" : "./";
+}
+
+// 输出测试的总体结果，返回值作为main的返回值
+inline int testSummary() {
+	std::cout << (testFailures == 0 ? "全部通过\n" : "有测试失败\n");
+	return testFailures == 0 ? 0 : 1;
+}
+
+#endif
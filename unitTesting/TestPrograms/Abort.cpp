@@ -0,0 +1,11 @@
+// 运行错误的目标程序：第一个整数为0时返回3，否则被SIGABRT终止
+#include <cstdio>
+#include <cstdlib>
+
+int main() {
+	long long a;
+	if (scanf("%lld", &a) != 1 || a == 0) {
+		return 3;
+	}
+	abort();
+}
@@ -0,0 +1,17 @@
+// 消耗内存的目标程序：申请输入的兆字节数的内存并逐页写入，然后输出done
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+int main() {
+	long long megabytes = 0;
+	if (scanf("%lld", &megabytes) != 1) {
+		return 1;
+	}
+	size_t size = static_cast<size_t>(megabytes) << 20;
+	char* buffer = new char[size];
+	memset(buffer, 1, size);
+	printf("done %d\n", buffer[size / 2]);
+	delete[] buffer;
+	return 0;
+}
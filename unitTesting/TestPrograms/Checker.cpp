@@ -0,0 +1,35 @@
+// 检查器：命令行为 检查器 输入文件 输出文件 标准答案文件，按testlib的退出代码约定返回
+// 输出与标准答案的第一个记号相同为AC，输出PE、PC、FAIL分别返回格式错误、部分正确、检查器失败，其余为WA
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+	if (argc < 4) {
+		std::cerr << "参数不足\n";
+		return 3;
+	}
+	std::ifstream outputFile(argv[2]);
+	std::ifstream answerFile(argv[3]);
+	std::string output, answer;
+	outputFile >> output;
+	answerFile >> answer;
+	if (output == answer) {
+		std::cerr << "ok\n";
+		return 0;
+	}
+	if (output == "PE") {
+		std::cerr << "格式错误\n";
+		return 2;
+	}
+	if (output == "PC") {
+		std::cerr << "points 50\n";
+		return 7;
+	}
+	if (output == "FAIL") {
+		std::cerr << "检查器失败\n";
+		return 3;
+	}
+	std::cerr << "读到" << output << "，期望" << answer << '\n';
+	return 1;
+}
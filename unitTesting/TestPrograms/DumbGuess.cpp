@@ -0,0 +1,13 @@
+// 答案错误的目标程序：从1开始逐个猜测，超过交互器允许的次数
+#include <cstdio>
+
+int main() {
+	for (long long guess = 1; ; ++guess) {
+		printf("%lld\n", guess);
+		fflush(stdout);
+		char reply[4];
+		if (scanf("%3s", reply) != 1 || reply[0] == '=') {
+			return 0;
+		}
+	}
+}
@@ -0,0 +1,10 @@
+// 目标程序：把标准输入原样输出
+#include <cstdio>
+
+int main() {
+	int ch;
+	while ((ch = getchar()) != EOF) {
+		putchar(ch);
+	}
+	return 0;
+}
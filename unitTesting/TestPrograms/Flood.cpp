@@ -0,0 +1,8 @@
+// 输出超限的目标程序：不停地输出
+#include <cstdio>
+
+int main() {
+	while (1) {
+		fputs("0123456789012345678901234567890123456789012345678901234567890123\n", stdout);
+	}
+}
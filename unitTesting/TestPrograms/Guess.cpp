@@ -0,0 +1,21 @@
+// 正确的目标程序：在[1, 10^9]中二分查找
+#include <cstdio>
+
+int main() {
+	long long low = 1, high = 1000000000;
+	while (low <= high) {
+		long long mid = (low + high) / 2;
+		printf("%lld\n", mid);
+		fflush(stdout);
+		char reply[4];
+		if (scanf("%3s", reply) != 1 || reply[0] == '=') {
+			return 0;
+		}
+		if (reply[0] == '<') {
+			low = mid + 1;
+		} else {
+			high = mid - 1;
+		}
+	}
+	return 0;
+}
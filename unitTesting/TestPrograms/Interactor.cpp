@@ -0,0 +1,43 @@
+// 猜数交互器：命令行为 交互器 输入文件 输出文件 标准答案文件
+// 输入文件的第一个整数为要猜的数，另一个参数为延迟时，第一次回答前先计算该毫秒数，用于模拟较慢的交互器
+// 每次读入一个猜测，回答<、>或=，40次以内猜中为AC，并把猜测次数写入输出文件
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+int main(int argc, char* argv[]) {
+	if (argc < 4) {
+		fprintf(stderr, "参数不足\n");
+		return 3;
+	}
+	std::ifstream inputFile(argv[1]);
+	long long secret = 0, delay = 0;
+	inputFile >> secret >> delay;
+	FILE* outputFile = fopen(argv[2], "w");
+	for (int query = 1; query <= 40; ++query) {
+		long long guess;
+		if (scanf("%lld", &guess) != 1) {
+			fprintf(stderr, "目标程序提前结束\n");
+			return 8;
+		}
+		if (query == 1 && delay > 0) {
+			auto start = std::chrono::steady_clock::now();
+			volatile unsigned long long counter = 0;
+			while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(delay)) {
+				++counter;
+			}
+		}
+		if (guess == secret) {
+			printf("=\n");
+			fflush(stdout);
+			fprintf(outputFile, "%d\n", query);
+			fprintf(stderr, "ok %d次\n", query);
+			return 0;
+		}
+		printf(guess < secret ? "<\n" : ">\n");
+		fflush(stdout);
+	}
+	fprintf(stderr, "猜测次数过多\n");
+	return 1;
+}
@@ -0,0 +1,7 @@
+// 超时的目标程序：死循环
+int main() {
+	volatile unsigned long long counter = 0;
+	while (1) {
+		++counter;
+	}
+}
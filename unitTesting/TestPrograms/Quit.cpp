@@ -0,0 +1,4 @@
+// 运行错误的目标程序：不进行交互，直接返回3
+int main() {
+	return 3;
+}
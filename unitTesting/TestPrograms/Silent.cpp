@@ -0,0 +1,10 @@
+// 空闲的目标程序：等待交互器先发言，与等待猜测的交互器互相阻塞
+#include <cstdio>
+
+int main() {
+	char reply[4];
+	if (scanf("%3s", reply) != 1) {
+		return 1;
+	}
+	return 0;
+}
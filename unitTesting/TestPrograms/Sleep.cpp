@@ -0,0 +1,14 @@
+// 不消耗CPU时间的目标程序：休眠输入的毫秒数后输出done
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+int main() {
+	long long milliseconds = 0;
+	if (scanf("%lld", &milliseconds) != 1) {
+		return 1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	puts("done");
+	return 0;
+}
@@ -0,0 +1,17 @@
+// 消耗CPU时间的目标程序：空转输入的毫秒数后输出done
+#include <chrono>
+#include <cstdio>
+
+int main() {
+	long long milliseconds = 0;
+	if (scanf("%lld", &milliseconds) != 1) {
+		return 1;
+	}
+	auto start = std::chrono::steady_clock::now();
+	volatile unsigned long long counter = 0;
+	while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(milliseconds)) {
+		++counter;
+	}
+	puts("done");
+	return 0;
+}
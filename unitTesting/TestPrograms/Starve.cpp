@@ -0,0 +1,14 @@
+// 得不到CPU的目标程序：以SCHED_IDLE优先级空转，同一CPU上有其他可运行的线程时几乎不被调度
+#include <sched.h>
+#include <cstdio>
+
+int main() {
+	sched_param param = {};
+	sched_setscheduler(0, SCHED_IDLE, &param);
+	volatile unsigned long long counter = 0;
+	for (unsigned long long i = 0; i < 2000000000ull; ++i) {
+		++counter;
+	}
+	puts("done");
+	return 0;
+}
@@ -0,0 +1,11 @@
+// 正确的目标程序：输出两个整数之和
+#include <cstdio>
+
+int main() {
+	long long a, b;
+	if (scanf("%lld%lld", &a, &b) != 2) {
+		return 1;
+	}
+	printf("%lld\n", a + b);
+	return 0;
+}
@@ -0,0 +1,67 @@
+// VerdictCache的测试：命中、键的组成、只缓存通过的评测、接近时间限制时重新评测
+// 用法：VerdictCacheTest [目标程序所在目录]
+// 目标程序为TestPrograms下的Sum和Spin，先编译到同一目录：g++ -O2 Sum.cpp -o Sum，g++ -O2 Spin.cpp -o Spin
+// 缓存目录写入临时目录，测试结束后删除
+#include "../../ConsoleOJ.hpp"
+#include "../TestCheck.hpp"
+#include <filesystem>
+
+using namespace std;
+
+// 评测一次，返回结果是否来自缓存
+bool judgeCached(ConsoleOJ& program, const string& input, long long timelimit) {
+	string output, error;
+	long long timeCosted;
+	program.launchAndWait(input, timelimit, output, timeCosted, error);
+	return program.isVerdictCached();
+}
+
+int main(int argc, char* argv[]) {
+	string directory = testProgramDirectory(argc, argv);
+	filesystem::path cacheDirectory = filesystem::temp_directory_path() / "VerdictCacheTest";
+	filesystem::remove_all(cacheDirectory);
+
+	VerdictCache cache(cacheDirectory.string(), "v1");
+	ConsoleOJ sum(directory + "Sum");
+	sum.setVerdictCache(&cache);
+	sum.setExpectedOutput("3\n");
+	check("第一次评测", judgeCached(sum, "1 2\n", 1000), false);
+	check("第二次评测命中", judgeCached(sum, "1 2\n", 1000), true);
+	check("命中时的结果", string(judgeVerdictName(sum.getVerdict())), string("AC"));
+	check("输入不同", judgeCached(sum, "1  2\n", 1000), false);
+	check("时间限制不同", judgeCached(sum, "1 2\n", 2000), false);
+
+	// 未通过的评测不缓存
+	sum.setExpectedOutput("4\n");
+	check("WA", judgeCached(sum, "1 2\n", 1000), false);
+	check("WA再次评测", judgeCached(sum, "1 2\n", 1000), false);
+	check("WA的结果", string(judgeVerdictName(sum.getVerdict())), string("WA"));
+
+	// 没有标准答案时不使用缓存
+	sum.clearExpectedOutput();
+	judgeCached(sum, "1 2\n", 1000);
+	check("没有标准答案", judgeCached(sum, "1 2\n", 1000), false);
+
+	// 时间花费约300ms，时间限制为500ms时超过一半，缓存不使用，重新评测
+	ConsoleOJ spin(directory + "Spin");
+	spin.setVerdictCache(&cache);
+	spin.setExpectedOutput("done\n");
+	check("远离时间限制", judgeCached(spin, "300\n", 2000), false);
+	check("远离时间限制命中", judgeCached(spin, "300\n", 2000), true);
+	check("接近时间限制", judgeCached(spin, "300\n", 500), false);
+	check("接近时间限制重新评测", judgeCached(spin, "300\n", 500), false);
+	check("重新评测的结果", string(judgeVerdictName(spin.getVerdict())), string("AC"));
+
+	VerdictCacheStats stats = cache.getStats();
+	check("命中次数", stats.hits, 2ull);
+	check("临界重测次数", stats.borderlineReruns, 1ull);
+
+	// 评测机版本不同时旧的缓存失效
+	VerdictCache newCache(cacheDirectory.string(), "v2");
+	sum.setVerdictCache(&newCache);
+	sum.setExpectedOutput("3\n");
+	check("评测机版本不同", judgeCached(sum, "1 2\n", 1000), false);
+
+	filesystem::remove_all(cacheDirectory);
+	return testSummary();
+}